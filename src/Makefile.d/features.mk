@@ -60,6 +60,15 @@ ifdef HAVE_MINIUPNPC
 libs+=-lminiupnpc
 endif
 
+ifdef HAVE_ZSTD
+libs+=-lzstd
+opts+=-DHAVE_ZSTD
+endif
+
+ifdef MAXPLAYERS
+opts+=-DMAXPLAYERS=$(MAXPLAYERS)
+endif
+
 # (Valgrind is a memory debugger.)
 ifdef VALGRIND
 VALGRIND_PKGCONFIG?=valgrind
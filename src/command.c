@@ -61,6 +61,9 @@ static const char *CV_StringValue(const char *var_name);
 static consvar_t *consvar_vars; // list of registered console variables
 static UINT16     consvar_number_of_netids = 0;
 
+static consvar_t **consvar_netvars = NULL; // net variables by netid
+static size_t      consvar_netvars_size = 0;
+
 #ifdef OLD22DEMOCOMPAT
 static old_demo_var_t *consvar_old_demo_vars;
 #endif
@@ -97,12 +100,109 @@ static INT32 com_wait; // one command per frame (for cmd sequences)
 typedef struct cmdalias_s
 {
 	struct cmdalias_s *next;
+	struct cmdalias_s *hashnext;
 	char *name;
 	char *value; // the command string to replace the alias
 } cmdalias_t;
 
 static cmdalias_t *com_alias; // aliases list
 
+// =========================================================================
+//                              NAME LOOKUP
+// =========================================================================
+
+// Commands, aliases and variables are looked up by name all the time
+// (config files, netvars, Lua), so each kind gets a hash table next to
+// its list. The lists are kept for everything that walks all of them.
+#define COM_HASHSIZE 1024 // Must be a power of two
+
+/** Hashes a name case insensitively, like stricmp compares them.
+  *
+  * \param name The name to hash.
+  * \return The hash bucket for the name.
+  */
+static UINT32 COM_HashName(const char *name)
+{
+	UINT32 hash = 2166136261u; // FNV-1a
+
+	while (*name)
+	{
+		hash ^= (UINT8)tolower(*name++);
+		hash *= 16777619u;
+	}
+
+	return hash & (COM_HASHSIZE - 1);
+}
+
+// Names sorted with strcmp, for tab completion.
+// New names are appended, and the index is only sorted again
+// the next time something needs completing.
+typedef struct
+{
+	const char **names;
+	size_t numnames, maxnames;
+	boolean sorted;
+} com_nameindex_t;
+
+static com_nameindex_t com_command_names, com_alias_names, consvar_names;
+
+static void COM_AddToNameIndex(com_nameindex_t *index, const char *name)
+{
+	if (index->numnames >= index->maxnames)
+	{
+		index->maxnames = index->maxnames ? index->maxnames * 2 : 256;
+		index->names = Z_Realloc(index->names, index->maxnames * sizeof (*index->names), PU_STATIC, NULL);
+	}
+
+	index->names[index->numnames++] = name;
+	index->sorted = false;
+}
+
+static int COM_CompareNames(const void *a, const void *b)
+{
+	return strcmp(*(const char * const *)a, *(const char * const *)b);
+}
+
+/** Finds the names starting with a partial name, in sorted order.
+  *
+  * \param index   The names to search.
+  * \param partial The partial name.
+  * \param skips   Number of matches to skip.
+  * \return The complete name, or NULL.
+  */
+static const char *COM_CompleteFromNameIndex(com_nameindex_t *index, const char *partial, INT32 skips)
+{
+	size_t len = strlen(partial);
+	size_t lo = 0, hi, mid;
+
+	if (!len || skips < 0)
+		return NULL;
+
+	if (!index->sorted)
+	{
+		qsort(index->names, index->numnames, sizeof (*index->names), COM_CompareNames);
+		index->sorted = true;
+	}
+
+	// Find the first name that isn't less than the partial name;
+	// all the names it's a prefix of follow it.
+	hi = index->numnames;
+	while (lo < hi)
+	{
+		mid = lo + (hi - lo) / 2;
+		if (strcmp(index->names[mid], partial) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	lo += skips;
+	if (lo < index->numnames && !strncmp(partial, index->names[lo], len))
+		return index->names[lo];
+
+	return NULL;
+}
+
 // =========================================================================
 //                            COMMAND BUFFER
 // =========================================================================
@@ -307,10 +407,14 @@ typedef struct xcommand_s
 {
 	const char *name;
 	struct xcommand_s *next;
+	struct xcommand_s *hashnext;
 	com_func_t function;
 } xcommand_t;
 
 static xcommand_t *com_commands = NULL; // current commands
+static xcommand_t *com_command_hash[COM_HASHSIZE];
+static cmdalias_t *com_alias_hash[COM_HASHSIZE];
+static consvar_t *consvar_hash[COM_HASHSIZE];
 
 #define MAX_ARGS 80
 static size_t com_argc;
@@ -473,6 +577,54 @@ static void COM_TokenizeString(char *ptext)
 	}
 }
 
+/** Finds a command by name.
+  *
+  * \param name Name of the command, case insensitive.
+  * \return The command, or NULL.
+  */
+static xcommand_t *COM_FindCommand(const char *name)
+{
+	xcommand_t *cmd;
+
+	for (cmd = com_command_hash[COM_HashName(name)]; cmd; cmd = cmd->hashnext)
+		if (!stricmp(name, cmd->name)) //case insensitive now that we have lower and uppercase!
+			return cmd;
+
+	return NULL;
+}
+
+static void COM_LinkCommand(const char *name, com_func_t func)
+{
+	xcommand_t *cmd;
+	UINT32 hash = COM_HashName(name);
+
+	cmd = ZZ_Alloc(sizeof *cmd);
+	cmd->name = name;
+	cmd->function = func;
+	cmd->next = com_commands;
+	com_commands = cmd;
+	cmd->hashnext = com_command_hash[hash];
+	com_command_hash[hash] = cmd;
+
+	COM_AddToNameIndex(&com_command_names, name);
+}
+
+/** Finds an alias by name. The latest definition of an alias wins.
+  *
+  * \param name Name of the alias, case insensitive.
+  * \return The alias, or NULL.
+  */
+static cmdalias_t *COM_FindAlias(const char *name)
+{
+	cmdalias_t *a;
+
+	for (a = com_alias_hash[COM_HashName(name)]; a; a = a->hashnext)
+		if (!stricmp(name, a->name))
+			return a;
+
+	return NULL;
+}
+
 /** Adds a console command.
   *
   * \param name Name of the command.
@@ -490,26 +642,20 @@ void COM_AddCommand(const char *name, com_func_t func)
 	}
 
 	// fail if the command already exists
-	for (cmd = com_commands; cmd; cmd = cmd->next)
+	cmd = COM_FindCommand(name);
+	if (cmd)
 	{
-		if (!stricmp(name, cmd->name)) //case insensitive now that we have lower and uppercase!
-		{
-			// don't I_Error for Lua commands
-			// Lua commands can replace game commands, and they have priority.
-			// BUT, if for some reason we screwed up and made two console commands with the same name,
-			// it's good to have this here so we find out.
-			if (cmd->function != COM_Lua_f)
-				I_Error("Command %s already exists\n", name);
+		// don't I_Error for Lua commands
+		// Lua commands can replace game commands, and they have priority.
+		// BUT, if for some reason we screwed up and made two console commands with the same name,
+		// it's good to have this here so we find out.
+		if (cmd->function != COM_Lua_f)
+			I_Error("Command %s already exists\n", name);
 
-			return;
-		}
+		return;
 	}
 
-	cmd = ZZ_Alloc(sizeof *cmd);
-	cmd->name = name;
-	cmd->function = func;
-	cmd->next = com_commands;
-	com_commands = cmd;
+	COM_LinkCommand(name, func);
 }
 
 /** Adds a console command for Lua.
@@ -526,22 +672,16 @@ int COM_AddLuaCommand(const char *name)
 		return -1;
 
 	// command already exists
-	for (cmd = com_commands; cmd; cmd = cmd->next)
+	cmd = COM_FindCommand(name);
+	if (cmd)
 	{
-		if (!stricmp(name, cmd->name)) //case insensitive now that we have lower and uppercase!
-		{
-			// replace the built in command.
-			cmd->function = COM_Lua_f;
-			return 1;
-		}
+		// replace the built in command.
+		cmd->function = COM_Lua_f;
+		return 1;
 	}
 
 	// Add a new command.
-	cmd = ZZ_Alloc(sizeof *cmd);
-	cmd->name = name;
-	cmd->function = COM_Lua_f;
-	cmd->next = com_commands;
-	com_commands = cmd;
+	COM_LinkCommand(name, COM_Lua_f);
 	return 0;
 }
 
@@ -552,13 +692,7 @@ int COM_AddLuaCommand(const char *name)
   */
 static boolean COM_Exists(const char *com_name)
 {
-	xcommand_t *cmd;
-
-	for (cmd = com_commands; cmd; cmd = cmd->next)
-		if (!stricmp(com_name, cmd->name))
-			return true;
-
-	return false;
+	return (COM_FindCommand(com_name) != NULL);
 }
 
 /** Does command completion for the console.
@@ -570,21 +704,7 @@ static boolean COM_Exists(const char *com_name)
   */
 const char *COM_CompleteCommand(const char *partial, INT32 skips)
 {
-	xcommand_t *cmd;
-	size_t len;
-
-	len = strlen(partial);
-
-	if (!len)
-		return NULL;
-
-	// check functions
-	for (cmd = com_commands; cmd; cmd = cmd->next)
-		if (!strncmp(partial, cmd->name, len))
-			if (!skips--)
-				return cmd->name;
-
-	return NULL;
+	return COM_CompleteFromNameIndex(&com_command_names, partial, skips);
 }
 
 /** Completes the name of an alias.
@@ -596,21 +716,7 @@ const char *COM_CompleteCommand(const char *partial, INT32 skips)
   */
 const char *COM_CompleteAlias(const char *partial, INT32 skips)
 {
-	cmdalias_t *a;
-	size_t len;
-
-	len = strlen(partial);
-
-	if (!len)
-		return NULL;
-
-	// check functions
-	for (a = com_alias; a; a = a->next)
-		if (!strncmp(partial, a->name, len))
-			if (!skips--)
-				return a->name;
-
-	return NULL;
+	return COM_CompleteFromNameIndex(&com_alias_names, partial, skips);
 }
 
 /** Parses a single line of text into arguments and tries to execute it.
@@ -631,30 +737,26 @@ static void COM_ExecuteString(char *ptext)
 		return; // no tokens
 
 	// check functions
-	for (cmd = com_commands; cmd; cmd = cmd->next)
+	cmd = COM_FindCommand(com_argv[0]);
+	if (cmd)
 	{
-		if (!stricmp(com_argv[0], cmd->name)) //case insensitive now that we have lower and uppercase!
-		{
-			cmd->function();
-			return;
-		}
+		cmd->function();
+		return;
 	}
 
 	// check aliases
-	for (a = com_alias; a; a = a->next)
+	a = COM_FindAlias(com_argv[0]);
+	if (a)
 	{
-		if (!stricmp(com_argv[0], a->name))
-		{
-			if (recursion > MAX_ALIAS_RECURSION)
-				CONS_Alert(CONS_WARNING, M_GetText("Alias recursion cycle detected!\n"));
-			else
-			{ // Monster Iestyn: keep track of how many levels of recursion we're in
-				recursion++;
-				COM_BufInsertTextEx(a->value, com_flags);
-				recursion--;
-			}
-			return;
+		if (recursion > MAX_ALIAS_RECURSION)
+			CONS_Alert(CONS_WARNING, M_GetText("Alias recursion cycle detected!\n"));
+		else
+		{ // Monster Iestyn: keep track of how many levels of recursion we're in
+			recursion++;
+			COM_BufInsertTextEx(a->value, com_flags);
+			recursion--;
 		}
+		return;
 	}
 
 	// check cvars
@@ -675,6 +777,7 @@ static void COM_Alias_f(void)
 	cmdalias_t *a;
 	char cmd[1024];
 	size_t i, c;
+	UINT32 hash;
 
 	if (COM_Argc() < 3)
 	{
@@ -688,6 +791,14 @@ static void COM_Alias_f(void)
 
 	a->name = Z_StrDup(COM_Argv(1));
 
+	// a redefined alias shadows the old one, so it's only completed once
+	if (!COM_FindAlias(a->name))
+		COM_AddToNameIndex(&com_alias_names, a->name);
+
+	hash = COM_HashName(a->name);
+	a->hashnext = com_alias_hash[hash];
+	com_alias_hash[hash] = a;
+
 	// copy the rest of the command line
 	cmd[0] = 0; // start out with a null string
 	c = COM_Argc();
@@ -913,11 +1024,9 @@ static void COM_Help_f(void)
 		}
 		else
 		{
-			for (cmd = com_commands; cmd; cmd = cmd->next)
+			cmd = COM_FindCommand(help);
+			if (cmd && !strcmp(cmd->name, help))
 			{
-				if (strcmp(cmd->name, help))
-					continue;
-
 				CONS_Printf("\x82""Command %s:\n", cmd->name);
 				CONS_Printf("  help is not available for commands");
 				CONS_Printf("\x82""\nCheck wiki.srb2.org for more or try typing <name> without arguments\n");
@@ -1168,7 +1277,7 @@ consvar_t *CV_FindVar(const char *name)
 {
 	consvar_t *cvar;
 
-	for (cvar = consvar_vars; cvar; cvar = cvar->next)
+	for (cvar = consvar_hash[COM_HashName(name)]; cvar; cvar = cvar->hashnext)
 		if (!stricmp(name,cvar->name))
 			return cvar;
 
@@ -1234,16 +1343,10 @@ static old_demo_var_t *CV_FindOldDemoVar(UINT16 chk)
   */
 static consvar_t *CV_FindNetVar(UINT16 netid)
 {
-	consvar_t *cvar;
-
-	if (netid > consvar_number_of_netids)
+	if (netid >= consvar_netvars_size)
 		return NULL;
 
-	for (cvar = consvar_vars; cvar; cvar = cvar->next)
-		if (cvar->netid == netid)
-			return cvar;
-
-	return NULL;
+	return consvar_netvars[netid];
 }
 
 static void Setvalue(consvar_t *var, const char *valstr, boolean stealth);
@@ -1311,8 +1414,28 @@ void CV_RegisterVar(consvar_t *variable)
 	// link the variable in
 	if (!(variable->flags & CV_HIDEN))
 	{
+		UINT32 hash = COM_HashName(variable->name);
+
 		variable->next = consvar_vars;
 		consvar_vars = variable;
+		variable->hashnext = consvar_hash[hash];
+		consvar_hash[hash] = variable;
+
+		COM_AddToNameIndex(&consvar_names, variable->name);
+
+		if (variable->flags & CV_NETVAR)
+		{
+			if (variable->netid >= consvar_netvars_size)
+			{
+				size_t oldsize = consvar_netvars_size;
+
+				consvar_netvars_size = max((size_t)variable->netid + 1, 2 * oldsize);
+				consvar_netvars = Z_Realloc(consvar_netvars, consvar_netvars_size * sizeof (*consvar_netvars), PU_STATIC, NULL);
+				memset(consvar_netvars + oldsize, 0, (consvar_netvars_size - oldsize) * sizeof (*consvar_netvars));
+			}
+
+			consvar_netvars[variable->netid] = variable;
+		}
 	}
 	variable->string = variable->zstring = NULL;
 	memset(&variable->revert, 0, sizeof variable->revert);
@@ -1361,21 +1484,7 @@ static const char *CV_StringValue(const char *var_name)
   */
 const char *CV_CompleteVar(char *partial, INT32 skips)
 {
-	consvar_t *cvar;
-	size_t len;
-
-	len = strlen(partial);
-
-	if (!len)
-		return NULL;
-
-	// check variables
-	for (cvar = consvar_vars; cvar; cvar = cvar->next)
-		if (!strncmp(partial, cvar->name, len))
-			if (!skips--)
-				return cvar->name;
-
-	return NULL;
+	return COM_CompleteFromNameIndex(&consvar_names, partial, skips);
 }
 
 /** Sets a value to a variable with less checking. Only for internal use.
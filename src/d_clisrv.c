@@ -28,6 +28,7 @@
 #include "m_menu.h"
 #include "console.h"
 #include "d_netfil.h"
+#include "d_snapshot.h"
 #include "byteptr.h"
 #include "p_saveg.h"
 #include "z_zone.h"
@@ -109,6 +110,25 @@ boolean nodeingame[MAXNETNODES]; // set false as nodes leave game
 tic_t servermaxping = 800; // server's max ping. Defaults to 800
 static tic_t nettics[MAXNETNODES]; // what tic the client have received
 static tic_t supposedtics[MAXNETNODES]; // nettics prevision for smaller packet
+static boolean deltatics[MAXNETNODES]; // can read PT_SERVERDELTATICS
+static boolean sendsnapshot[MAXNETNODES]; // can read chunked gamestates, else gets the old format
+static UINT8 savecodec[MAXNETNODES]; // snapcodec_t to send the gamestate with
+static tic_t deltafirsttic[MAXNETNODES]; // first tic the node got from us, not from a gamestate
+static ticcmd_t deltabase[MAXNETNODES][MAXPLAYERS]; // a tic the node has acknowledged
+static tic_t deltabasetic[MAXNETNODES];
+static boolean deltabaseready[MAXNETNODES];
+static tic_t deltaslotstic = 0; // tics before this may have been sent with another numslots
+static INT16 deltanumslots = -1;
+
+// What PT_SERVERTICS packets to each node would have been
+// without PT_SERVERDELTATICS, for the ticstats command
+typedef struct
+{
+	UINT32 packets, tics;
+	UINT64 bytes, rawbytes;
+} ticstats_t;
+
+static ticstats_t nodeticstats[MAXNETNODES];
 static UINT8 nodewaiting[MAXNETNODES];
 static tic_t firstticstosend; // min of the nettics
 static tic_t tictoclear = 0; // optimize d_clearticcmd
@@ -129,11 +149,12 @@ static boolean cl_packetmissed;
 // here it is for the secondary local player (splitscreen)
 static UINT8 mynode; // my address pointofview server
 static boolean cl_redownloadinggamestate = false;
+static boolean cl_snapshots = false; // server's PT_SERVERINFO said it sends chunked gamestates
 
 static UINT8 localtextcmd[MAXTEXTCMD];
 static UINT8 localtextcmd2[MAXTEXTCMD]; // splitscreen
 static tic_t neededtic;
-SINT8 servernode = 0; // the number of the server node
+INT16 servernode = 0; // the number of the server node
 
 /// \brief do we accept new players?
 /// \todo WORK!
@@ -196,6 +217,248 @@ static inline void *G_ScpyTiccmd(ticcmd_t* dest, void* src, const size_t n)
 	return ret+n;
 }
 
+#ifdef MANYPLAYERS
+// Marks the slots that have a ticcmd other than all zeroes in any
+// of the tics, which are all PT_SERVERTICS needs to have. Returns
+// how many there are.
+static INT32 SV_MarkTicSlots(UINT8 *slots, tic_t firsttic, tic_t lasttic)
+{
+	static const ticcmd_t zerocmd;
+	INT32 i, numused = 0;
+	tic_t tic;
+
+	memset(slots, 0, MAXPLAYERS/8);
+
+	for (i = 0; i < doomcom->numslots; i++)
+		for (tic = firsttic; tic < lasttic; tic++)
+			if (memcmp(&netcmds[tic%BACKUPTICS][i], &zerocmd, sizeof (ticcmd_t)))
+			{
+				slots[i/8] |= 1 << (i%8);
+				numused++;
+				break;
+			}
+
+	return numused;
+}
+#endif
+
+// How many ticcmds there are for each tic in a PT_SERVERTICS packet
+static INT32 ServerTicsSlotCount(const servertics_pak *pak)
+{
+#ifdef MANYPLAYERS
+	INT32 i, numused = 0;
+
+	for (i = 0; i < min(pak->numslots, MAXPLAYERS); i++)
+		if (pak->slots[i/8] & (1 << (i%8)))
+			numused++;
+
+	return numused;
+#else
+	return pak->numslots;
+#endif
+}
+
+static UINT8 *SV_WriteTicSlots(UINT8 *bufpos, const servertics_pak *pak, const ticcmd_t *cmds)
+{
+#ifdef MANYPLAYERS
+	INT32 i;
+
+	for (i = 0; i < pak->numslots; i++)
+		if (pak->slots[i/8] & (1 << (i%8)))
+			bufpos = G_DcpyTiccmd(bufpos, &cmds[i], sizeof (ticcmd_t));
+
+	return bufpos;
+#else
+	return G_DcpyTiccmd(bufpos, cmds, pak->numslots * sizeof (ticcmd_t));
+#endif
+}
+
+static UINT8 *CL_ReadTicSlots(ticcmd_t *cmds, const servertics_pak *pak, UINT8 *bufpos)
+{
+#ifdef MANYPLAYERS
+	INT32 i;
+
+	for (i = 0; i < min(pak->numslots, MAXPLAYERS); i++)
+	{
+		if (pak->slots[i/8] & (1 << (i%8)))
+			bufpos = G_ScpyTiccmd(&cmds[i], bufpos, sizeof (ticcmd_t));
+		else
+			memset(&cmds[i], 0, sizeof (ticcmd_t));
+	}
+
+	return bufpos;
+#else
+	return G_ScpyTiccmd(cmds, bufpos, pak->numslots * sizeof (ticcmd_t));
+#endif
+}
+
+// Send PT_SERVERDELTATICS to the clients that can read it
+consvar_t cv_deltatics = CVAR_INIT ("deltatics", "On", 0, CV_OnOff, NULL);
+
+// Bit-packed ticcmds, for PT_SERVERDELTATICS
+typedef struct
+{
+	UINT8 *p, *end;
+	UINT32 bits; // Not written out or read yet, lowest first
+	UINT8 numbits;
+	boolean overflow;
+} ticbits_t;
+
+#define TICDELTA_FORWARDMOVE 0x01
+#define TICDELTA_SIDEMOVE    0x02
+#define TICDELTA_ANGLETURN   0x04
+#define TICDELTA_AIMING      0x08
+#define TICDELTA_BUTTONS     0x10
+#define TICDELTA_LATENCY     0x20
+#define TICDELTA_BITS        6
+
+static const ticcmd_t nocmds[MAXPLAYERS];
+
+static void TicBits_Init(ticbits_t *tb, UINT8 *p, UINT8 *end)
+{
+	tb->p = p;
+	tb->end = end;
+	tb->bits = 0;
+	tb->numbits = 0;
+	tb->overflow = false;
+}
+
+// Up to 16 bits at a time
+static void TicBits_Write(ticbits_t *tb, UINT32 value, UINT8 n)
+{
+	tb->bits |= (value & ((1u << n) - 1)) << tb->numbits;
+	tb->numbits = (UINT8)(tb->numbits + n);
+
+	while (tb->numbits >= 8)
+	{
+		if (tb->p < tb->end)
+			*tb->p++ = (UINT8)tb->bits;
+		else
+			tb->overflow = true;
+		tb->bits >>= 8;
+		tb->numbits -= 8;
+	}
+}
+
+// Writes out the last partial byte
+static void TicBits_Flush(ticbits_t *tb)
+{
+	if (tb->numbits)
+		TicBits_Write(tb, 0, (UINT8)(8 - tb->numbits));
+}
+
+static UINT32 TicBits_Read(ticbits_t *tb, UINT8 n)
+{
+	UINT32 value;
+
+	while (tb->numbits < n)
+	{
+		if (tb->p < tb->end)
+			tb->bits |= (UINT32)*tb->p++ << tb->numbits;
+		else
+			tb->overflow = true;
+		tb->numbits += 8;
+	}
+
+	value = tb->bits & ((1u << n) - 1);
+	tb->bits >>= n;
+	tb->numbits = (UINT8)(tb->numbits - n);
+	return value;
+}
+
+// Small changes, like turning, as a byte, anything else as is
+static void TicBits_WriteShort(ticbits_t *tb, UINT16 value, UINT16 base)
+{
+	const INT16 delta = (INT16)(value - base);
+
+	if (delta >= INT8_MIN && delta <= INT8_MAX)
+	{
+		TicBits_Write(tb, 1, 1);
+		TicBits_Write(tb, (UINT8)delta, 8);
+	}
+	else
+	{
+		TicBits_Write(tb, 0, 1);
+		TicBits_Write(tb, value, 16);
+	}
+}
+
+static UINT16 TicBits_ReadShort(ticbits_t *tb, UINT16 base)
+{
+	if (TicBits_Read(tb, 1))
+		return (UINT16)(base + (SINT8)TicBits_Read(tb, 8));
+	return (UINT16)TicBits_Read(tb, 16);
+}
+
+// One bit per unchanged ticcmd, otherwise which fields changed and their values
+static void PackTiccmds(ticbits_t *tb, const ticcmd_t *cmds, const ticcmd_t *base, INT32 numslots)
+{
+	INT32 i;
+
+	for (i = 0; i < numslots; i++)
+	{
+		const ticcmd_t *cmd = &cmds[i], *old = &base[i];
+		UINT8 changed = 0;
+
+		if (cmd->forwardmove != old->forwardmove) changed |= TICDELTA_FORWARDMOVE;
+		if (cmd->sidemove    != old->sidemove)    changed |= TICDELTA_SIDEMOVE;
+		if (cmd->angleturn   != old->angleturn)   changed |= TICDELTA_ANGLETURN;
+		if (cmd->aiming      != old->aiming)      changed |= TICDELTA_AIMING;
+		if (cmd->buttons     != old->buttons)     changed |= TICDELTA_BUTTONS;
+		if (cmd->latency     != old->latency)     changed |= TICDELTA_LATENCY;
+
+		if (!changed)
+		{
+			TicBits_Write(tb, 0, 1);
+			continue;
+		}
+
+		TicBits_Write(tb, 1, 1);
+		TicBits_Write(tb, changed, TICDELTA_BITS);
+		if (changed & TICDELTA_FORWARDMOVE)
+			TicBits_Write(tb, (UINT8)cmd->forwardmove, 8);
+		if (changed & TICDELTA_SIDEMOVE)
+			TicBits_Write(tb, (UINT8)cmd->sidemove, 8);
+		if (changed & TICDELTA_ANGLETURN)
+			TicBits_WriteShort(tb, (UINT16)cmd->angleturn, (UINT16)old->angleturn);
+		if (changed & TICDELTA_AIMING)
+			TicBits_WriteShort(tb, (UINT16)cmd->aiming, (UINT16)old->aiming);
+		if (changed & TICDELTA_BUTTONS)
+			TicBits_Write(tb, cmd->buttons, 16);
+		if (changed & TICDELTA_LATENCY)
+			TicBits_Write(tb, cmd->latency, 8);
+	}
+}
+
+static void UnpackTiccmds(ticbits_t *tb, ticcmd_t *cmds, const ticcmd_t *base, INT32 numslots)
+{
+	INT32 i;
+
+	for (i = 0; i < numslots; i++)
+	{
+		ticcmd_t *cmd = &cmds[i];
+		UINT8 changed;
+
+		*cmd = base[i];
+		if (!TicBits_Read(tb, 1))
+			continue;
+
+		changed = (UINT8)TicBits_Read(tb, TICDELTA_BITS);
+		if (changed & TICDELTA_FORWARDMOVE)
+			cmd->forwardmove = (SINT8)TicBits_Read(tb, 8);
+		if (changed & TICDELTA_SIDEMOVE)
+			cmd->sidemove = (SINT8)TicBits_Read(tb, 8);
+		if (changed & TICDELTA_ANGLETURN)
+			cmd->angleturn = (INT16)TicBits_ReadShort(tb, (UINT16)cmd->angleturn);
+		if (changed & TICDELTA_AIMING)
+			cmd->aiming = (INT16)TicBits_ReadShort(tb, (UINT16)cmd->aiming);
+		if (changed & TICDELTA_BUTTONS)
+			cmd->buttons = (UINT16)TicBits_Read(tb, 16);
+		if (changed & TICDELTA_LATENCY)
+			cmd->latency = (UINT8)TicBits_Read(tb, 8);
+	}
+}
+
 
 
 // Some software don't support largest packet
@@ -1061,6 +1324,23 @@ static void CL_DrawConnectionStatusBox(const char *abortstring)
 		V_DrawCenteredString(BASEVIDWIDTH/2, BASEVIDHEIGHT-16-16, V_YELLOWMAP, abortstring);
 }
 
+// Download rate and how long is left, from the data actually received
+static const char *CL_DownloadRateString(UINT32 currentsize, UINT32 totalsize)
+{
+	UINT32 rate = CL_GetDownloadRate();
+	UINT32 eta;
+
+	if (!rate)
+		return "";
+
+	eta = (max(totalsize, currentsize) - currentsize + rate - 1) / rate;
+
+	if (rate >= 1024*1024)
+		return va("%3.1fM/s %u:%02u ", rate/(1024.0*1024), eta/60, eta%60);
+	else
+		return va("%3.1fK/s %u:%02u ", rate/1024.0, eta/60, eta%60);
+}
+
 //
 // CL_DrawConnectionStatus
 //
@@ -1116,7 +1396,6 @@ static void CL_DrawConnectionStatus(void)
 					INT32 dldlength;
 
 					cltext = M_GetText("Downloading game state...");
-					Net_GetNetStat();
 
 					dldlength = (INT32)((currentsize/(double)totalsize) * 256);
 					if (dldlength > 256)
@@ -1128,7 +1407,7 @@ static void CL_DrawConnectionStatus(void)
 						va(" %4uK/%4uK",currentsize>>10,totalsize>>10));
 
 					V_DrawRightAlignedString(BASEVIDWIDTH/2+128, BASEVIDHEIGHT-16, V_20TRANS|V_MONOSPACE,
-						va("%3.1fK/s ", ((double)getbps)/1024));
+						CL_DownloadRateString(currentsize, totalsize));
 				}
 				else
 					cltext = M_GetText("Waiting to download game state...");
@@ -1204,7 +1483,6 @@ static void CL_DrawConnectionStatus(void)
 			else
 				return;
 
-			Net_GetNetStat();
 			dldlength = (INT32)((file->currentsize/(double)file->totalsize) * 256);
 			if (dldlength > 256)
 				dldlength = 256;
@@ -1232,7 +1510,7 @@ static void CL_DrawConnectionStatus(void)
 			V_DrawString(BASEVIDWIDTH/2-128, BASEVIDHEIGHT-16, V_20TRANS|V_MONOSPACE,
 				va(" %4uK/%4uK",fileneeded[lastfilenum].currentsize>>10,file->totalsize>>10));
 			V_DrawRightAlignedString(BASEVIDWIDTH/2+128, BASEVIDHEIGHT-16, V_20TRANS|V_MONOSPACE,
-				va("%3.1fK/s ", ((double)getbps)/1024));
+				CL_DownloadRateString(file->currentsize, file->totalsize));
 		}
 		else
 		{
@@ -1290,10 +1568,20 @@ static boolean CL_SendJoin(void)
 	strncpy(netbuffer->u.clientcfg.names[0], cv_playername.zstring, MAXPLAYERNAME);
 	strncpy(netbuffer->u.clientcfg.names[1], cv_playername2.zstring, MAXPLAYERNAME);
 
+	netbuffer->u.clientcfg.netcaps = NETCAP_DELTATICS;
+	if (cl_snapshots)
+		netbuffer->u.clientcfg.netcaps |= NETCAP_SNAPSHOT;
+	if (D_SnapshotCodecs() & (1<<SNAPCODEC_DEFLATE))
+		netbuffer->u.clientcfg.netcaps |= NETCAP_DEFLATE;
+	if (D_SnapshotCodecs() & (1<<SNAPCODEC_ZSTD))
+		netbuffer->u.clientcfg.netcaps |= NETCAP_ZSTD;
+	if (Net_GetChecksum(servernode) == NETCHECKSUM_CRC32C)
+		netbuffer->u.clientcfg.netcaps |= NETCAP_CRC32C;
+
 	return HSendPacket(servernode, true, 0, sizeof (clientconfig_pak));
 }
 
-static INT32 FindRejoinerNum(SINT8 node)
+static INT32 FindRejoinerNum(INT32 node)
 {
 	char strippednodeaddress[64];
 	const char *nodeaddress;
@@ -1339,7 +1627,7 @@ GetRefuseReason (INT32 node)
 		return 0;
 }
 
-static void SV_SendServerInfo(INT32 node, tic_t servertime)
+static void SV_SendServerInfo(INT32 node, tic_t servertime, UINT8 netcaps)
 {
 	UINT8 *p;
 
@@ -1364,6 +1652,10 @@ static void SV_SendServerInfo(INT32 node, tic_t servertime)
 	netbuffer->u.serverinfo.modifiedgame = (UINT8)modifiedgame;
 	netbuffer->u.serverinfo.cheatsenabled = CV_CheatsEnabled();
 	netbuffer->u.serverinfo.flags = (dedicated ? SV_DEDICATED : 0);
+	if (netcaps & NETCAP_CRC32C)
+		netbuffer->u.serverinfo.flags |= SV_CRC32C;
+	if (netcaps & NETCAP_SNAPSHOT)
+		netbuffer->u.serverinfo.flags |= SV_SNAPSHOT;
 	strncpy(netbuffer->u.serverinfo.servername, cv_servername.string,
 		MAXSERVERNAME);
 	strncpy(netbuffer->u.serverinfo.mapname, G_BuildMapName(gamemap), 7);
@@ -1405,6 +1697,7 @@ static void SV_SendServerInfo(INT32 node, tic_t servertime)
 
 static void SV_SendPlayerInfo(INT32 node)
 {
+	plrinfo *info = netbuffer->u.playerinfo;
 	UINT8 i;
 	netbuffer->packettype = PT_PLAYERINFO;
 
@@ -1412,55 +1705,65 @@ static void SV_SendPlayerInfo(INT32 node)
 	{
 		if (!playeringame[i])
 		{
-			netbuffer->u.playerinfo[i].num = 255; // This slot is empty.
+#ifndef MANYPLAYERS
+			(info++)->num = 255; // This slot is empty.
+#endif
 			continue;
 		}
 
-		netbuffer->u.playerinfo[i].num = i;
-		strncpy(netbuffer->u.playerinfo[i].name, (const char *)&player_names[i], MAXPLAYERNAME+1);
-		netbuffer->u.playerinfo[i].name[MAXPLAYERNAME] = '\0';
+#ifdef MANYPLAYERS
+		// Only the players in game, as many as fit
+		if (info == &netbuffer->u.playerinfo[MAXPLAYERINFO])
+			break;
+#endif
+
+		info->num = i;
+		strncpy(info->name, (const char *)&player_names[i], MAXPLAYERNAME+1);
+		info->name[MAXPLAYERNAME] = '\0';
 
 		//fetch IP address
 		//No, don't do that, you fuckface.
-		memset(netbuffer->u.playerinfo[i].address, 0, 4);
+		memset(info->address, 0, 4);
 
 		if (G_GametypeHasTeams())
 		{
 			if (!players[i].ctfteam)
-				netbuffer->u.playerinfo[i].team = 255;
+				info->team = 255;
 			else
-				netbuffer->u.playerinfo[i].team = (UINT8)players[i].ctfteam;
+				info->team = (UINT8)players[i].ctfteam;
 		}
 		else
 		{
 			if (players[i].spectator)
-				netbuffer->u.playerinfo[i].team = 255;
+				info->team = 255;
 			else
-				netbuffer->u.playerinfo[i].team = 0;
+				info->team = 0;
 		}
 
-		netbuffer->u.playerinfo[i].score = LONG(players[i].score);
-		netbuffer->u.playerinfo[i].timeinserver = SHORT((UINT16)(players[i].jointime / TICRATE));
-		netbuffer->u.playerinfo[i].skin = (UINT8)(players[i].skin
+		info->score = LONG(players[i].score);
+		info->timeinserver = SHORT((UINT16)(players[i].jointime / TICRATE));
+		info->skin = (UINT8)(players[i].skin
 #ifdef DEVELOP // it's safe to do this only because PLAYERINFO isn't read by the game itself
 		% 3
 #endif
 		);
 
 		// Extra data
-		netbuffer->u.playerinfo[i].data = 0; //players[i].skincolor;
+		info->data = 0; //players[i].skincolor;
 
 		if (players[i].pflags & PF_TAGIT)
-			netbuffer->u.playerinfo[i].data |= 0x20;
+			info->data |= 0x20;
 
 		if (players[i].gotflag)
-			netbuffer->u.playerinfo[i].data |= 0x40;
+			info->data |= 0x40;
 
 		if (players[i].powers[pw_super])
-			netbuffer->u.playerinfo[i].data |= 0x80;
+			info->data |= 0x80;
+
+		info++;
 	}
 
-	HSendPacket(node, false, 0, sizeof(plrinfo) * MAXPLAYERS);
+	HSendPacket(node, false, 0, (UINT8 *)info - (UINT8 *)netbuffer->u.playerinfo);
 }
 
 /** Sends a PT_SERVERCFG packet
@@ -1517,8 +1820,6 @@ static boolean SV_SendServerConfig(INT32 node)
 }
 
 #ifndef NONET
-#define SAVEGAMESIZE (768*1024)
-
 static boolean SV_ResendingSavegameToAnyone(void)
 {
 	INT32 i;
@@ -1529,19 +1830,21 @@ static boolean SV_ResendingSavegameToAnyone(void)
 	return false;
 }
 
-static void SV_SendSaveGame(INT32 node, boolean resending)
+// Sends the gamestate the way older clients expect it: the uncompressed
+// length, or 0 if it isn't compressed, then one LZF block, all of it
+// compressed before the first fragment goes out
+static boolean SV_SendLegacySaveGame(INT32 node, boolean resending, UINT32 *length)
 {
-	size_t length, compressedlen;
+	size_t rawlength, compressedlen;
 	UINT8 *savebuffer;
 	UINT8 *compressedsave;
-	UINT8 *buffertosend;
 
 	// first save it in a malloced buffer
 	savebuffer = (UINT8 *)malloc(SAVEGAMESIZE);
 	if (!savebuffer)
 	{
 		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
-		return;
+		return false;
 	}
 
 	// Leave room for the uncompressed length.
@@ -1549,52 +1852,72 @@ static void SV_SendSaveGame(INT32 node, boolean resending)
 
 	P_SaveNetGame(resending);
 
-	length = save_p - savebuffer;
-	if (length > SAVEGAMESIZE)
+	rawlength = save_p - savebuffer;
+	save_p = NULL;
+	if (rawlength > SAVEGAMESIZE)
 	{
 		free(savebuffer);
-		save_p = NULL;
 		I_Error("Savegame buffer overrun");
 	}
 
 	// Allocate space for compressed save: one byte fewer than for the
 	// uncompressed data to ensure that the compression is worthwhile.
-	compressedsave = malloc(length - 1);
+	compressedsave = malloc(rawlength - 1);
 	if (!compressedsave)
 	{
+		free(savebuffer);
 		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
-		return;
+		return false;
 	}
 
 	// Attempt to compress it.
-	if((compressedlen = lzf_compress(savebuffer + sizeof(UINT32), length - sizeof(UINT32), compressedsave + sizeof(UINT32), length - sizeof(UINT32) - 1)))
+	if ((compressedlen = lzf_compress(savebuffer + sizeof(UINT32), rawlength - sizeof(UINT32), compressedsave + sizeof(UINT32), rawlength - sizeof(UINT32) - 1)))
 	{
 		// Compressing succeeded; send compressed data
-
+		UINT8 *p = compressedsave;
 		free(savebuffer);
-
-		// State that we're compressed.
-		buffertosend = compressedsave;
-		WRITEUINT32(compressedsave, length - sizeof(UINT32));
-		length = compressedlen + sizeof(UINT32);
+		WRITEUINT32(p, rawlength - sizeof(UINT32));
+		*length = (UINT32)(compressedlen + sizeof(UINT32));
+		AddRamToSendQueue(node, compressedsave, *length, SF_RAM, 0);
 	}
 	else
 	{
 		// Compression failed to make it smaller; send original
-
+		UINT8 *p = savebuffer;
 		free(compressedsave);
-
-		// State that we're not compressed
-		buffertosend = savebuffer;
-		WRITEUINT32(savebuffer, 0);
+		WRITEUINT32(p, 0);
+		*length = (UINT32)rawlength;
+		AddRamToSendQueue(node, savebuffer, *length, SF_RAM, 0);
 	}
 
-	AddRamToSendQueue(node, buffertosend, length, SF_RAM, 0);
-	save_p = NULL;
+	return true;
+}
+
+static void SV_SendSaveGame(INT32 node, boolean resending)
+{
+	UINT32 length;
+
+	if (sendsnapshot[node])
+	{
+		// Shared with anyone else who needs the gamestate this tic,
+		// and still being compressed while the first fragments go out
+		snapshot_t *snapshot = SV_GetSnapshot(resending, savecodec[node]);
+
+		if (!snapshot)
+			return;
+
+		length = SV_SnapshotMaxSize(snapshot);
+		AddSnapshotToSendQueue(node, snapshot, 0);
+	}
+	else if (!SV_SendLegacySaveGame(node, resending, &length))
+		return;
 
 	// Remember when we started sending the savegame so we can handle timeouts
 	sendingsavegame[node] = true;
 	freezetimeout[node] = I_GetTime() + jointimeout + length / 1024; // 1 extra tic for each kilobyte
+
+	// The client skips ahead to the gamestate's tic, over tics it never got
+	deltafirsttic[node] = gametic;
 }
 
 #ifdef DUMPCONSISTENCY
@@ -1646,7 +1969,7 @@ static void SV_SavedGame(void)
 static void CL_LoadReceivedSavegame(boolean reloading)
 {
 	UINT8 *savebuffer = NULL;
-	size_t length, decompressedlen;
+	size_t length;
 	char tmpsave[256];
 
 	FreeFileNeeded();
@@ -1662,16 +1985,37 @@ static void CL_LoadReceivedSavegame(boolean reloading)
 		return;
 	}
 
-	save_p = savebuffer;
-
-	// Decompress saved game if necessary.
-	decompressedlen = READUINT32(save_p);
-	if(decompressedlen > 0)
+	if (cl_snapshots)
 	{
-		UINT8 *decompressedbuffer = Z_Malloc(decompressedlen, PU_STATIC, NULL);
-		lzf_decompress(save_p, length - sizeof(UINT32), decompressedbuffer, decompressedlen);
+		// Decompress it, chunk by chunk
+		UINT8 *unpacked;
+		CL_UnpackSnapshot(savebuffer, length, &unpacked);
 		Z_Free(savebuffer);
-		save_p = savebuffer = decompressedbuffer;
+		save_p = savebuffer = unpacked;
+	}
+	else
+	{
+		// Older servers send one LZF block, or 0 if it isn't compressed
+		size_t decompressedlen;
+
+		if (length < sizeof(UINT32))
+			I_Error("Received gamestate is truncated");
+
+		save_p = savebuffer;
+		decompressedlen = READUINT32(save_p);
+		if (decompressedlen > 0)
+		{
+			UINT8 *decompressedbuffer;
+
+			if (decompressedlen > SAVEGAMESIZE)
+				I_Error("Received gamestate is too big (%s bytes)", sizeu1(decompressedlen));
+
+			decompressedbuffer = Z_Malloc(decompressedlen, PU_STATIC, NULL);
+			if (lzf_decompress(save_p, length - sizeof(UINT32), decompressedbuffer, decompressedlen) != decompressedlen)
+				I_Error("Received gamestate is corrupt");
+			Z_Free(savebuffer);
+			save_p = savebuffer = decompressedbuffer;
+		}
 	}
 
 	paused = false;
@@ -1750,6 +2094,7 @@ static void SendAskInfo(INT32 node)
 	netbuffer->packettype = PT_ASKINFO;
 	netbuffer->u.askinfo.version = VERSION;
 	netbuffer->u.askinfo.time = (tic_t)LONG(asktime);
+	netbuffer->u.askinfo.netcaps = NETCAP_CRC32C|NETCAP_SNAPSHOT;
 
 	// Even if this never arrives due to the host being firewalled, we've
 	// now allowed traffic from the host to us in, so once the MS relays
@@ -1785,7 +2130,7 @@ static UINT32 SL_SearchServer(INT32 node)
 	return UINT32_MAX;
 }
 
-static void SL_InsertServer(serverinfo_pak* info, SINT8 node)
+static void SL_InsertServer(serverinfo_pak* info, INT32 node)
 {
 	UINT32 i;
 
@@ -2265,6 +2610,9 @@ static boolean CL_ServerConnectionSearchTicker(tic_t *asksent)
 		{
 			serverinfo_pak *info = &serverlist[i].info;
 
+			// Older servers send the gamestate as one LZF block
+			cl_snapshots = (info->flags & SV_SNAPSHOT) != 0;
+
 			if (info->refusereason == REFUSE_SLOTS_FULL)
 				serverisfull = true;
 			else
@@ -2939,7 +3287,7 @@ static void Command_connect(void)
 		// used in menu to connect to a server in the list
 		if (netgame && !stricmp(COM_Argv(1), "node"))
 		{
-			servernode = (SINT8)atoi(COM_Argv(2));
+			servernode = (INT16)atoi(COM_Argv(2));
 		}
 		else if (netgame)
 		{
@@ -3237,6 +3585,184 @@ static void Command_Nodes(void)
 	}
 }
 
+static void Command_TicStats(void)
+{
+	INT32 n;
+	UINT64 bytes = 0, rawbytes = 0;
+	UINT32 tics = 0;
+
+	if (!server)
+	{
+		CONS_Printf(M_GetText("Only the server sends tics.\n"));
+		return;
+	}
+
+	for (n = 1; n < MAXNETNODES; n++)
+	{
+		const ticstats_t *stats = &nodeticstats[n];
+
+		if (!nodeingame[n] || !stats->tics)
+			continue;
+
+		CONS_Printf(M_GetText("node %.2d: %u bytes per tic, %u as PT_SERVERTICS (%u tics in %u packets, %s)"),
+			n, (UINT32)(stats->bytes / stats->tics), (UINT32)(stats->rawbytes / stats->tics),
+			stats->tics, stats->packets, (deltatics[n] && cv_deltatics.value) ? "delta" : "full");
+		if (nodetoplayer[n] != -1)
+			CONS_Printf(" - %s", player_names[(UINT8)nodetoplayer[n]]);
+		CONS_Printf("\n");
+
+		bytes += stats->bytes;
+		rawbytes += stats->rawbytes;
+		tics += stats->tics;
+	}
+
+	if (!tics)
+	{
+		CONS_Printf(M_GetText("No tics sent since the last ticstats.\n"));
+		return;
+	}
+
+	CONS_Printf(M_GetText("Total: %u bytes per tic, %u as PT_SERVERTICS (%d%% saved)\n"),
+		(UINT32)(bytes / tics), (UINT32)(rawbytes / tics),
+		rawbytes ? (INT32)(100 - (bytes * 100) / rawbytes) : 0);
+
+	// Count from here the next time
+	memset(nodeticstats, 0, sizeof (nodeticstats));
+}
+
+#ifdef _DEBUG
+// Random inputs for the playerbench players, the same every run
+static void PlayerBench_MakeCmd(ticcmd_t *cmd, UINT32 *seed)
+{
+	UINT32 r;
+
+	*seed = *seed * 1103515245u + 12345u;
+	r = *seed >> 8;
+
+	cmd->forwardmove = (SINT8)((r % (2*MAXPLMOVE + 1)) - MAXPLMOVE);
+	cmd->sidemove = (SINT8)(((r >> 7) % (2*MAXPLMOVE + 1)) - MAXPLMOVE);
+	cmd->angleturn = (INT16)((cmd->angleturn + (INT32)((r >> 4) & 1023) - 512) | TICCMD_RECEIVED);
+	cmd->aiming = 0;
+	cmd->buttons = (UINT16)(((r & 0x10000) ? BT_JUMP : 0) | ((r & 0x60000) == 0x60000 ? BT_SPIN : 0));
+	cmd->latency = (UINT8)(leveltime & 0xFF);
+}
+
+// Fills the level up with players driven by random ticcmds, 32, 64
+// and 128 of them as far as MAXPLAYERS goes, and times the server's
+// tics with each. The level is left however the players left it.
+static void Command_PlayerBench(void)
+{
+	static const INT32 steps[] = {32, 64, 128};
+	boolean benchplayer[MAXPLAYERS];
+	ticcmd_t cmds[MAXPLAYERS];
+	UINT32 seed = 0x5EED;
+	tic_t tics = 10*TICRATE;
+	size_t step;
+	INT32 i;
+
+	if (COM_Argc() > 1)
+		tics = max(atoi(COM_Argv(1)), 1) * TICRATE;
+
+	if (!server || gamestate != GS_LEVEL || demoplayback)
+	{
+		CONS_Printf(M_GetText("playerbench [seconds]: only works on the server, in a level\n"));
+		return;
+	}
+
+	// The tics it runs aren't real ones, so they can't be recorded
+	if (demorecording)
+	{
+		CONS_Printf(M_GetText("playerbench can't be used while recording a demo.\n"));
+		return;
+	}
+
+	// Nobody else knows about the players it adds
+	for (i = 1; i < MAXNETNODES; i++)
+		if (nodeingame[i])
+		{
+			CONS_Printf(M_GetText("playerbench can't be used with anyone else connected.\n"));
+			return;
+		}
+
+	memset(benchplayer, 0, sizeof (benchplayer));
+	memset(cmds, 0, sizeof (cmds));
+
+	for (step = 0; step < sizeof (steps) / sizeof (*steps) && steps[step] <= MAXPLAYERS; step++)
+	{
+		precise_t tickertime = 0, consistancytime = 0, worsttime = 0;
+		INT32 numused = doomcom->numslots;
+		tic_t t;
+
+		for (i = 0; i < MAXPLAYERS && D_NumPlayers() < steps[step]; i++)
+		{
+			if (playeringame[i])
+				continue;
+
+			CL_ClearPlayer(i);
+			playeringame[i] = true;
+			playernode[i] = UINT8_MAX;
+			benchplayer[i] = true;
+			G_AddPlayer(i);
+			sprintf(player_names[i], "Bench %d", i+1);
+			SetPlayerSkinByNum(i, 0);
+
+			if (i+1 > doomcom->numslots)
+				doomcom->numslots = (INT16)(i+1);
+		}
+
+		// A second for everyone to spawn before timing
+		for (t = 0; t < TICRATE + tics && gamestate == GS_LEVEL; t++)
+		{
+			precise_t start, ticked;
+
+			for (i = 0; i < MAXPLAYERS; i++)
+				if (benchplayer[i])
+				{
+					PlayerBench_MakeCmd(&cmds[i], &seed);
+					netcmds[gametic%BACKUPTICS][i] = cmds[i];
+				}
+
+			start = I_GetPreciseTime();
+			G_Ticker(true);
+			ticked = I_GetPreciseTime();
+			Consistancy();
+
+			if (t < TICRATE)
+				continue;
+
+			tickertime += ticked - start;
+			consistancytime += I_GetPreciseTime() - ticked;
+			if (ticked - start > worsttime)
+				worsttime = ticked - start;
+		}
+
+		if (gamestate != GS_LEVEL)
+		{
+			CONS_Printf(M_GetText("The level ended, stopping.\n"));
+			break;
+		}
+
+#ifdef MANYPLAYERS
+		{
+			UINT8 slots[MAXPLAYERS/8];
+			numused = SV_MarkTicSlots(slots, gametic, gametic + 1);
+		}
+#endif
+
+		CONS_Printf(M_GetText("%3d players: %.3f ms per tic, %.3f ms at worst, %.1f us of it in Consistancy, %s bytes of ticcmds\n"),
+			D_NumPlayers(),
+			I_PreciseToMicros(tickertime + consistancytime) / 1000.0 / tics,
+			I_PreciseToMicros(worsttime) / 1000.0,
+			I_PreciseToMicros(consistancytime) / (double)tics,
+			sizeu1(numused * sizeof (ticcmd_t)));
+	}
+
+	for (i = 0; i < MAXPLAYERS; i++)
+		if (benchplayer[i])
+			CL_RemovePlayer(i, KR_LEAVE);
+}
+#endif
+
 static void Command_Ban(void)
 {
 	if (COM_Argc() < 2)
@@ -3642,7 +4168,7 @@ consvar_t cv_netticbuffer = CVAR_INIT ("netticbuffer", "1", CV_SAVE, netticbuffe
 
 consvar_t cv_allownewplayer = CVAR_INIT ("allowjoin", "On", CV_SAVE|CV_NETVAR, CV_OnOff, NULL);
 consvar_t cv_joinnextround = CVAR_INIT ("joinnextround", "Off", CV_SAVE|CV_NETVAR, CV_OnOff, NULL); /// \todo not done
-static CV_PossibleValue_t maxplayers_cons_t[] = {{2, "MIN"}, {32, "MAX"}, {0, NULL}};
+static CV_PossibleValue_t maxplayers_cons_t[] = {{2, "MIN"}, {MAXPLAYERS, "MAX"}, {0, NULL}};
 consvar_t cv_maxplayers = CVAR_INIT ("maxplayers", "8", CV_SAVE|CV_NETVAR, maxplayers_cons_t, NULL);
 static CV_PossibleValue_t joindelay_cons_t[] = {{1, "MIN"}, {3600, "MAX"}, {0, "Off"}, {0, NULL}};
 consvar_t cv_joindelay = CVAR_INIT ("joindelay", "10", CV_SAVE|CV_NETVAR, joindelay_cons_t, NULL);
@@ -3662,6 +4188,10 @@ consvar_t cv_noticedownload = CVAR_INIT ("noticedownload", "Off", CV_SAVE|CV_NET
 static CV_PossibleValue_t downloadspeed_cons_t[] = {{1, "MIN"}, {300, "MAX"}, {0, NULL}};
 consvar_t cv_downloadspeed = CVAR_INIT ("downloadspeed", "16", CV_SAVE|CV_NETVAR, downloadspeed_cons_t, NULL);
 
+// Memory for addons being sent, shared between downloaders (in megabytes)
+static CV_PossibleValue_t sendcachesize_cons_t[] = {{0, "MIN"}, {1024, "MAX"}, {0, NULL}};
+consvar_t cv_sendcachesize = CVAR_INIT ("sendcachesize", "64", CV_SAVE, sendcachesize_cons_t, NULL);
+
 static void Got_AddPlayer(UINT8 **p, INT32 playernum);
 
 // called one time at init
@@ -3680,6 +4210,7 @@ void D_ClientServerInit(void)
 	COM_AddCommand("reloadbans", Command_ReloadBan);
 	COM_AddCommand("connect", Command_connect);
 	COM_AddCommand("nodes", Command_Nodes);
+	COM_AddCommand("ticstats", Command_TicStats);
 	COM_AddCommand("resendgamestate", Command_ResendGamestate);
 #ifdef PACKETDROP
 	COM_AddCommand("drop", Command_Drop);
@@ -3687,6 +4218,7 @@ void D_ClientServerInit(void)
 #endif
 #ifdef _DEBUG
 	COM_AddCommand("numnodes", Command_Numnodes);
+	COM_AddCommand("playerbench", Command_PlayerBench);
 #endif
 #endif
 
@@ -3717,6 +4249,13 @@ static void ResetNode(INT32 node)
 	nettics[node] = gametic;
 	supposedtics[node] = gametic;
 
+	deltatics[node] = false;
+	sendsnapshot[node] = false;
+	savecodec[node] = SNAPCODEC_LZF;
+	deltafirsttic[node] = gametic;
+	deltabaseready[node] = false;
+	memset(&nodeticstats[node], 0, sizeof (nodeticstats[node]));
+
 	nodetoplayer[node] = -1;
 	nodetoplayer2[node] = -1;
 	playerpernode[node] = 0;
@@ -3857,6 +4396,9 @@ static inline void SV_AddNode(INT32 node)
 {
 	nettics[node] = gametic;
 	supposedtics[node] = gametic;
+	deltafirsttic[node] = gametic;
+	deltabaseready[node] = false;
+	memset(&nodeticstats[node], 0, sizeof (nodeticstats[node]));
 	// little hack because the server connects to itself and puts
 	// nodeingame when connected not here
 	if (node)
@@ -4153,6 +4695,26 @@ static void SV_SendRefuse(INT32 node, const char *reason)
 	Net_CloseConnection(node);
 }
 
+// Keeps a copy of the last tic the node has acknowledged, so the next
+// tics can be sent to it as changes from that. The copy is made while
+// the tic is still in netcmds, since tics before firstticstosend get cleared.
+static void SV_UpdateDeltaBase(INT32 node)
+{
+	tic_t tic;
+
+	if (!deltatics[node] || !nettics[node])
+		return;
+
+	tic = nettics[node] - 1;
+	if (tic >= maketic || tic < tictoclear || tic < deltafirsttic[node]
+		|| (deltabaseready[node] && tic <= deltabasetic[node]))
+		return;
+
+	M_Memcpy(deltabase[node], netcmds[tic%BACKUPTICS], sizeof (deltabase[node]));
+	deltabasetic[node] = tic;
+	deltabaseready[node] = true;
+}
+
 // used at txtcmds received to check packetsize bound
 static size_t TotalTextCmdPerTic(tic_t tic)
 {
@@ -4170,7 +4732,7 @@ static size_t TotalTextCmdPerTic(tic_t tic)
 }
 
 static const char *
-ConnectionRefused (SINT8 node, INT32 rejoinernum)
+ConnectionRefused (INT32 node, INT32 rejoinernum)
 {
 	clientconfig_pak *cc = &netbuffer->u.clientcfg;
 
@@ -4246,12 +4808,13 @@ ConnectionRefused (SINT8 node, INT32 rejoinernum)
   * \param node The packet sender
   *
   */
-static void HandleConnect(SINT8 node)
+static void HandleConnect(INT32 node)
 {
 	char names[MAXSPLITSCREENPLAYERS][MAXPLAYERNAME + 1];
 	INT32 rejoinernum;
 	INT32 i;
 	const char *refuse;
+	UINT8 netcaps = 0;
 
 	rejoinernum = FindRejoinerNum(node);
 
@@ -4285,6 +4848,22 @@ static void HandleConnect(SINT8 node)
 #endif
 			SV_AddNode(node);
 
+			// Older clients' join packets end before netcaps
+			if (doomcom->datalength >= (INT16)(BASEPACKETSIZE + sizeof (clientconfig_pak)))
+				netcaps = netbuffer->u.clientcfg.netcaps;
+
+			deltatics[node] = (netcaps & NETCAP_DELTATICS) != 0;
+
+			// The client only asks for this if our PT_SERVERINFO offered it
+			if (netcaps & NETCAP_CRC32C)
+				Net_SetChecksum(node, NETCHECKSUM_CRC32C);
+
+			// Older clients only read one LZF block with its final size
+			sendsnapshot[node] = (netcaps & NETCAP_SNAPSHOT) != 0;
+			savecodec[node] = SV_PickSnapshotCodec((1<<SNAPCODEC_LZF)
+				| ((netcaps & NETCAP_DEFLATE) ? 1<<SNAPCODEC_DEFLATE : 0)
+				| ((netcaps & NETCAP_ZSTD) ? 1<<SNAPCODEC_ZSTD : 0));
+
 			if (cv_joinnextround.value && gameaction == ga_nothing)
 				G_SetGamestate(GS_WAITINGPLAYERS);
 			if (!SV_SendServerConfig(node))
@@ -4322,7 +4901,7 @@ static void HandleConnect(SINT8 node)
   * \param node The packet sender (should be the server)
   *
   */
-static void HandleShutdown(SINT8 node)
+static void HandleShutdown(INT32 node)
 {
 	(void)node;
 	LUA_HookBool(false, HOOK(GameQuit));
@@ -4337,7 +4916,7 @@ static void HandleShutdown(SINT8 node)
   * \param node The packet sender (should be the server)
   *
   */
-static void HandleTimeout(SINT8 node)
+static void HandleTimeout(INT32 node)
 {
 	(void)node;
 	LUA_HookBool(false, HOOK(GameQuit));
@@ -4354,7 +4933,7 @@ static void HandleTimeout(SINT8 node)
   * \note What happens if the packet comes from a client or something like that?
   *
   */
-static void HandleServerInfo(SINT8 node)
+static void HandleServerInfo(INT32 node)
 {
 	// compute ping in ms
 	const tic_t ticnow = I_GetTime();
@@ -4367,6 +4946,10 @@ static void HandleServerInfo(SINT8 node)
 	netbuffer->u.serverinfo.gametypename
 		[sizeof netbuffer->u.serverinfo.gametypename - 1] = '\0';
 
+	// Only set if our PT_ASKINFO said we could check it
+	if (netbuffer->u.serverinfo.flags & SV_CRC32C)
+		Net_SetChecksum(node, NETCHECKSUM_CRC32C);
+
 	SL_InsertServer(&netbuffer->u.serverinfo, node);
 }
 #endif
@@ -4399,7 +4982,7 @@ static void PT_WillResendGamestate(void)
 #endif
 }
 
-static void PT_CanReceiveGamestate(SINT8 node)
+static void PT_CanReceiveGamestate(INT32 node)
 {
 #ifndef NONET
 	if (client || sendingsavegame[node])
@@ -4422,7 +5005,7 @@ static void PT_CanReceiveGamestate(SINT8 node)
   * \sa GetPackets
   *
   */
-static void HandlePacketFromAwayNode(SINT8 node)
+static void HandlePacketFromAwayNode(INT32 node)
 {
 	if (node != servernode)
 		DEBFILE(va("Received packet from unknown host %d\n", node));
@@ -4477,7 +5060,11 @@ static void HandlePacketFromAwayNode(SINT8 node)
 		case PT_ASKINFO:
 			if (server && serverrunning)
 			{
-				SV_SendServerInfo(node, (tic_t)LONG(netbuffer->u.askinfo.time));
+				// Older clients' requests end before netcaps
+				UINT8 netcaps = 0;
+				if (doomcom->datalength >= (INT16)(BASEPACKETSIZE + sizeof (askinfo_pak)))
+					netcaps = netbuffer->u.askinfo.netcaps;
+				SV_SendServerInfo(node, (tic_t)LONG(netbuffer->u.askinfo.time), netcaps);
 				SV_SendPlayerInfo(node); // Send extra info
 			}
 			Net_CloseConnection(node);
@@ -4611,6 +5198,7 @@ static void HandlePacketFromAwayNode(SINT8 node)
 			break; // This is not an "unknown packet"
 
 		case PT_SERVERTICS:
+		case PT_SERVERDELTATICS:
 			// Do not remove my own server (we have just get a out of order packet)
 			if (node == servernode)
 				break;
@@ -4625,6 +5213,79 @@ static void HandlePacketFromAwayNode(SINT8 node)
 #undef SERVERONLY
 }
 
+/** Reads the tics from a PT_SERVERDELTATICS packet into netcmds,
+  * the same way as PT_SERVERTICS
+  */
+static void CL_ReadDeltaTics(void)
+{
+	serverdeltatics_pak *pak = &netbuffer->u.serverdeltapak;
+	const size_t cmdsize = SHORT(pak->cmdsize);
+	tic_t realstart, realend, i;
+	UINT8 *txtpak;
+	ticbits_t tb;
+
+	if (pak->numslots > MAXPLAYERS || doomcom->datalength < (INT16)(BASESERVERDELTATICSSIZE + cmdsize))
+	{
+		DEBFILE("bad PT_SERVERDELTATICS packet\n");
+		return;
+	}
+
+	realstart = pak->starttic;
+	realend = realstart + pak->numtics;
+	txtpak = pak->cmds + cmdsize;
+	Net_SampleTicArrival(servernode, realend);
+
+	if (realend > gametic + CLIENTBACKUPTICS)
+		realend = gametic + CLIENTBACKUPTICS;
+	cl_packetmissed = realstart > neededtic;
+
+	if (!(realstart <= neededtic && realend > neededtic))
+	{
+		DEBFILE(va("frame not in bound: %u\n", neededtic));
+		return;
+	}
+
+	// The base tic comes before realstart, so we already have it
+	TicBits_Init(&tb, pak->cmds, txtpak);
+
+	for (i = realstart; i < realend; i++)
+	{
+		const ticcmd_t *base;
+		UINT8 j, numtxtpak;
+
+		if (i != realstart)
+			base = netcmds[(i-1)%BACKUPTICS];
+		else if (pak->basetics)
+			base = netcmds[(realstart - pak->basetics)%BACKUPTICS];
+		else
+			base = nocmds;
+
+		// clear first
+		D_Clearticcmd(i);
+
+		UnpackTiccmds(&tb, netcmds[i%BACKUPTICS], base, pak->numslots);
+		if (tb.overflow)
+		{
+			CONS_Alert(CONS_WARNING, M_GetText("Malformed %s packet received\n"), "PT_SERVERDELTATICS");
+			return;
+		}
+
+		// copy the textcmds
+		numtxtpak = *txtpak++;
+		for (j = 0; j < numtxtpak; j++)
+		{
+			INT32 k = *txtpak++; // playernum
+			const size_t txtsize = txtpak[0]+1;
+
+			if (i >= gametic) // Don't copy old net commands
+				M_Memcpy(D_GetTextcmd(i, k), txtpak, txtsize);
+			txtpak += txtsize;
+		}
+	}
+
+	neededtic = realend;
+}
+
 /** Handles a packet received from a node that is in game
   *
   * \param node The packet sender
@@ -4633,7 +5294,7 @@ static void HandlePacketFromAwayNode(SINT8 node)
   * \sa GetPackets
   *
   */
-static void HandlePacketFromPlayer(SINT8 node)
+static void HandlePacketFromPlayer(INT32 node)
 {
 	INT32 netconsole;
 	tic_t realend, realstart;
@@ -4685,6 +5346,7 @@ static void HandlePacketFromPlayer(SINT8 node)
 
 			// Update the nettics
 			nettics[node] = realend;
+			SV_UpdateDeltaBase(node);
 
 			// Don't do anything for packets of type NODEKEEPALIVE?
 			if (netconsole == -1 || netbuffer->packettype == PT_NODEKEEPALIVE
@@ -4904,9 +5566,10 @@ static void HandlePacketFromPlayer(SINT8 node)
 
 			realstart = netbuffer->u.serverpak.starttic;
 			realend = realstart + netbuffer->u.serverpak.numtics;
+			Net_SampleTicArrival(node, realend);
 
 			if (!txtpak)
-				txtpak = (UINT8 *)&netbuffer->u.serverpak.cmds[netbuffer->u.serverpak.numslots
+				txtpak = (UINT8 *)&netbuffer->u.serverpak.cmds[ServerTicsSlotCount(&netbuffer->u.serverpak)
 					* netbuffer->u.serverpak.numtics];
 
 			if (realend > gametic + CLIENTBACKUPTICS)
@@ -4924,8 +5587,7 @@ static void HandlePacketFromPlayer(SINT8 node)
 					D_Clearticcmd(i);
 
 					// copy the tics
-					pak = G_ScpyTiccmd(netcmds[i%BACKUPTICS], pak,
-						netbuffer->u.serverpak.numslots*sizeof (ticcmd_t));
+					pak = CL_ReadTicSlots(netcmds[i%BACKUPTICS], &netbuffer->u.serverpak, pak);
 
 					// copy the textcmds
 					numtxtpak = *txtpak++;
@@ -4952,6 +5614,17 @@ static void HandlePacketFromPlayer(SINT8 node)
 							"IRC or Discord so it can be fixed.\n", (INT32)realstart, (INT32)realend, (INT32)neededtic);*/
 			}
 			break;
+		case PT_SERVERDELTATICS:
+			// Only accept PT_SERVERDELTATICS from the server.
+			if (node != servernode)
+			{
+				CONS_Alert(CONS_WARNING, M_GetText("%s received from non-host %d\n"), "PT_SERVERDELTATICS", node);
+				if (server)
+					SendKick(netconsole, KICK_MSG_CON_FAIL | KICK_MSG_KEEP_BODY);
+				break;
+			}
+			CL_ReadDeltaTics();
+			break;
 		case PT_PING:
 			// Only accept PT_PING from the server.
 			if (node != servernode)
@@ -5016,13 +5689,13 @@ static void HandlePacketFromPlayer(SINT8 node)
   */
 static void GetPackets(void)
 {
-	SINT8 node; // The packet sender
+	INT16 node; // The packet sender
 
 	player_joining = false;
 
 	while (HGetPacket())
 	{
-		node = (SINT8)doomcom->remotenode;
+		node = doomcom->remotenode;
 
 		if (netbuffer->packettype == PT_CLIENTJOIN && server)
 		{
@@ -5238,16 +5911,118 @@ static void CL_SendClientCmd(void)
 	}
 }
 
+static UINT8 *SV_WriteTextcmds(UINT8 *bufpos, tic_t firsttic, tic_t lasttic)
+{
+	tic_t i;
+	INT32 j;
+	UINT8 *ntextcmd;
+
+	for (i = firsttic; i < lasttic; i++)
+	{
+		ntextcmd = bufpos++;
+		*ntextcmd = 0;
+		for (j = 0; j < MAXPLAYERS; j++)
+		{
+			UINT8 *textcmd = D_GetExistingTextcmd(i, j);
+			INT32 size = textcmd ? textcmd[0] : 0;
+
+			if ((!j || playeringame[j]) && size)
+			{
+				(*ntextcmd)++;
+				WRITEUINT8(bufpos, j);
+				M_Memcpy(bufpos, textcmd, size + 1);
+				bufpos += size + 1;
+			}
+		}
+	}
+
+	return bufpos;
+}
+
+// Fills in a PT_SERVERDELTATICS packet with as many tics as fit,
+// and cuts lasttic to where it stopped. Returns the packet's size,
+// and in rawsize what it would have been as PT_SERVERTICS.
+static size_t SV_PackDeltaTics(INT32 node, tic_t firsttic, tic_t *lasttic, size_t *rawsize)
+{
+	serverdeltatics_pak *pak = &netbuffer->u.serverdeltapak;
+	const ticcmd_t *base = nocmds;
+	size_t packsize, textsize = 0;
+	ticbits_t tb;
+	tic_t i;
+
+	// Start from a tic the node is known to have, if there's one
+	// from since it last got a gamestate, and since numslots changed
+	pak->basetics = 0;
+	if (deltabaseready[node] && deltabasetic[node] >= deltafirsttic[node]
+		&& deltabasetic[node] >= deltaslotstic && deltabasetic[node] < firsttic
+		&& firsttic - deltabasetic[node] <= UINT8_MAX)
+	{
+		pak->basetics = (UINT8)(firsttic - deltabasetic[node]);
+		base = deltabase[node];
+	}
+
+	TicBits_Init(&tb, pak->cmds, (UINT8 *)netbuffer + MAXPACKETLENGTH);
+
+	for (i = firsttic; i < *lasttic; i++)
+	{
+		const ticbits_t before = tb;
+
+		PackTiccmds(&tb, netcmds[i%BACKUPTICS], base, doomcom->numslots);
+		textsize += TotalTextCmdPerTic(i);
+		packsize = BASESERVERDELTATICSSIZE + (tb.p - pak->cmds) + (tb.numbits ? 1 : 0) + textsize;
+
+		if (tb.overflow || packsize > software_MAXPACKETLENGTH)
+		{
+			DEBFILE(va("packet too large (%s) at tic %d (should be from %d to %d)\n",
+				sizeu1(packsize), i, firsttic, *lasttic));
+
+			if (i != firsttic)
+				tb = before;
+			else if (tb.overflow || packsize > MAXPACKETLENGTH)
+				I_Error("Too many players: can't send %s data for %d players to node %d\n"
+				        "Well sorry nobody is perfect....\n",
+				        sizeu1(packsize), doomcom->numslots, node);
+			else
+			{
+				i++; // send it anyway!
+				DEBFILE("sending it anyway\n");
+			}
+			break;
+		}
+
+		base = netcmds[i%BACKUPTICS];
+	}
+	*lasttic = i;
+
+	TicBits_Flush(&tb);
+	pak->starttic = firsttic;
+	pak->numtics = (UINT8)(*lasttic - firsttic);
+	pak->numslots = (UINT8)doomcom->numslots;
+	pak->cmdsize = SHORT((UINT16)(tb.p - pak->cmds));
+
+	*rawsize = BASESERVERTICSSIZE + (*lasttic - firsttic) * doomcom->numslots * sizeof (ticcmd_t);
+	for (i = firsttic; i < *lasttic; i++)
+		*rawsize += TotalTextCmdPerTic(i);
+
+	return SV_WriteTextcmds(tb.p, firsttic, *lasttic) - (UINT8 *)&netbuffer->u;
+}
+
 // send the server packet
 // send tic from firstticstosend to maketic-1
 static void SV_SendTics(void)
 {
 	tic_t realfirsttic, lasttictosend, i;
 	UINT32 n;
-	INT32 j;
-	size_t packsize;
+	size_t packsize, rawsize;
 	UINT8 *bufpos;
-	UINT8 *ntextcmd;
+
+	// Tics made before this may have been sent with the old numslots,
+	// so they can't be what PT_SERVERDELTATICS starts from
+	if (doomcom->numslots != deltanumslots)
+	{
+		deltanumslots = doomcom->numslots;
+		deltaslotstic = maketic;
+	}
 
 	// send to all client but not to me
 	// for each node create a packet with x tics and send it
@@ -5276,71 +6051,74 @@ static void SV_SendTics(void)
 			if (realfirsttic < firstticstosend)
 				realfirsttic = firstticstosend;
 
-			// compute the length of the packet and cut it if too large
-			packsize = BASESERVERTICSSIZE;
-			for (i = realfirsttic; i < lasttictosend; i++)
+			if (deltatics[n] && cv_deltatics.value)
+			{
+				netbuffer->packettype = PT_SERVERDELTATICS;
+				packsize = SV_PackDeltaTics(n, realfirsttic, &lasttictosend, &rawsize);
+			}
+			else
 			{
-				packsize += sizeof (ticcmd_t) * doomcom->numslots;
-				packsize += TotalTextCmdPerTic(i);
+				INT32 numused = doomcom->numslots;
 
-				if (packsize > software_MAXPACKETLENGTH)
+#ifdef MANYPLAYERS
+				numused = SV_MarkTicSlots(netbuffer->u.serverpak.slots, realfirsttic, lasttictosend);
+#endif
+
+				// compute the length of the packet and cut it if too large
+				packsize = BASESERVERTICSSIZE;
+				for (i = realfirsttic; i < lasttictosend; i++)
 				{
-					DEBFILE(va("packet too large (%s) at tic %d (should be from %d to %d)\n",
-						sizeu1(packsize), i, realfirsttic, lasttictosend));
-					lasttictosend = i;
-
-					// too bad: too much player have send extradata and there is too
-					//          much data in one tic.
-					// To avoid it put the data on the next tic. (see getpacket
-					// textcmd case) but when numplayer changes the computation can be different
-					if (lasttictosend == realfirsttic)
+					packsize += sizeof (ticcmd_t) * numused;
+					packsize += TotalTextCmdPerTic(i);
+
+					if (packsize > software_MAXPACKETLENGTH)
 					{
-						if (packsize > MAXPACKETLENGTH)
-							I_Error("Too many players: can't send %s data for %d players to node %d\n"
-							        "Well sorry nobody is perfect....\n",
-							        sizeu1(packsize), doomcom->numslots, n);
-						else
+						DEBFILE(va("packet too large (%s) at tic %d (should be from %d to %d)\n",
+							sizeu1(packsize), i, realfirsttic, lasttictosend));
+						lasttictosend = i;
+
+						// too bad: too much player have send extradata and there is too
+						//          much data in one tic.
+						// To avoid it put the data on the next tic. (see getpacket
+						// textcmd case) but when numplayer changes the computation can be different
+						if (lasttictosend == realfirsttic)
 						{
-							lasttictosend++; // send it anyway!
-							DEBFILE("sending it anyway\n");
+							if (packsize > MAXPACKETLENGTH)
+								I_Error("Too many players: can't send %s data for %d players to node %d\n"
+								        "Well sorry nobody is perfect....\n",
+								        sizeu1(packsize), doomcom->numslots, n);
+							else
+							{
+								lasttictosend++; // send it anyway!
+								DEBFILE("sending it anyway\n");
+							}
 						}
+						break;
 					}
-					break;
 				}
-			}
 
-			// Send the tics
-			netbuffer->packettype = PT_SERVERTICS;
-			netbuffer->u.serverpak.starttic = realfirsttic;
-			netbuffer->u.serverpak.numtics = (UINT8)(lasttictosend - realfirsttic);
-			netbuffer->u.serverpak.numslots = (UINT8)SHORT(doomcom->numslots);
-			bufpos = (UINT8 *)&netbuffer->u.serverpak.cmds;
+				// Send the tics
+				netbuffer->packettype = PT_SERVERTICS;
+				netbuffer->u.serverpak.starttic = realfirsttic;
+				netbuffer->u.serverpak.numtics = (UINT8)(lasttictosend - realfirsttic);
+				netbuffer->u.serverpak.numslots = (UINT8)SHORT(doomcom->numslots);
+				bufpos = (UINT8 *)&netbuffer->u.serverpak.cmds;
 
-			for (i = realfirsttic; i < lasttictosend; i++)
-			{
-				bufpos = G_DcpyTiccmd(bufpos, netcmds[i%BACKUPTICS], doomcom->numslots * sizeof (ticcmd_t));
-			}
-
-			// add textcmds
-			for (i = realfirsttic; i < lasttictosend; i++)
-			{
-				ntextcmd = bufpos++;
-				*ntextcmd = 0;
-				for (j = 0; j < MAXPLAYERS; j++)
+				for (i = realfirsttic; i < lasttictosend; i++)
 				{
-					UINT8 *textcmd = D_GetExistingTextcmd(i, j);
-					INT32 size = textcmd ? textcmd[0] : 0;
-
-					if ((!j || playeringame[j]) && size)
-					{
-						(*ntextcmd)++;
-						WRITEUINT8(bufpos, j);
-						M_Memcpy(bufpos, textcmd, size + 1);
-						bufpos += size + 1;
-					}
+					bufpos = SV_WriteTicSlots(bufpos, &netbuffer->u.serverpak, netcmds[i%BACKUPTICS]);
 				}
+
+				// add textcmds
+				bufpos = SV_WriteTextcmds(bufpos, realfirsttic, lasttictosend);
+				packsize = bufpos - (UINT8 *)&(netbuffer->u);
+				rawsize = BASEPACKETSIZE + packsize;
 			}
-			packsize = bufpos - (UINT8 *)&(netbuffer->u);
+
+			nodeticstats[n].packets++;
+			nodeticstats[n].tics += lasttictosend - realfirsttic;
+			nodeticstats[n].bytes += BASEPACKETSIZE + packsize;
+			nodeticstats[n].rawbytes += rawsize;
 
 			HSendPacket(n, false, 0, packsize);
 			// when tic are too large, only one tic is sent so don't go backward!
@@ -5479,6 +6257,7 @@ void TryRunTics(tic_t realtics)
 			while (neededtic > gametic)
 			{
 				boolean update_stats = !(paused || P_AutoPause());
+				precise_t tictime = I_GetPreciseTime();
 
 				DEBFILE(va("============ Running tic %d (local %d)\n", gametic, localgametic));
 
@@ -5491,10 +6270,13 @@ void TryRunTics(tic_t realtics)
 				consistancy[gametic%BACKUPTICS] = Consistancy();
 
 				if (update_stats)
-				{
 					PS_STOP_TIMING(ps_tictime);
+
+				// Collect Lua's garbage in the time the tic left over
+				LUA_StepGC(I_GetPreciseTime() - tictime, neededtic > gametic);
+
+				if (update_stats)
 					PS_UpdateTickStats();
-				}
 
 				// Leave a certain amount of tics present in the net buffer as long as we've ran at least one tic this frame.
 				if (client && gamestate == GS_LEVEL && leveltime > 3 && neededtic <= gametic + cv_netticbuffer.value)
@@ -5712,6 +6494,9 @@ void NetUpdate(void)
 	}
 
 	FileSendTicker();
+
+	if (I_NetFlush)
+		I_NetFlush();
 }
 
 /** Returns the number of players playing.
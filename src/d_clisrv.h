@@ -30,7 +30,14 @@ packet versions.
 If you change the struct or the meaning of a field
 therein, increment this number.
 */
+#if MAXPLAYERS > 32
+// More players than the usual packets have room for: PT_SERVERTICS
+// only has the slots in use, and PT_PLAYERINFO only the players in game
+#define MANYPLAYERS
+#define PACKETVERSION (128 + MAXPLAYERS/32)
+#else
 #define PACKETVERSION 4
+#endif
 
 // Network play related stuff.
 // There is a data struct that stores network
@@ -98,6 +105,8 @@ typedef enum
 	PT_MOREFILESNEEDED, // Server, to client: "you need these (+ more on top of those)"
 
 	PT_PING,          // Packet sent to tell clients the other client's latency to server.
+
+	PT_SERVERDELTATICS, // Same as PT_SERVERTICS, packed, for clients that can read it.
 	NUMPACKETTYPE
 } packettype_t;
 
@@ -143,9 +152,26 @@ typedef struct
 	tic_t starttic;
 	UINT8 numtics;
 	UINT8 numslots; // "Slots filled": Highest player number in use plus one.
+#ifdef MANYPLAYERS
+	UINT8 slots[MAXPLAYERS/8]; // Bit per slot with ticcmds, the rest are zero
+#endif
 	ticcmd_t cmds[45]; // Normally [BACKUPTIC][MAXPLAYERS] but too large
 } ATTRPACK servertics_pak;
 
+// Server to client packet, for clients that sent NETCAP_DELTATICS.
+// Each ticcmd is bit-packed as the fields that changed since the same
+// player's ticcmd in the tic before. For the first tic, that's the tic
+// basetics before it, one the client is known to have, or nothing.
+typedef struct
+{
+	tic_t starttic;
+	UINT8 numtics;
+	UINT8 numslots;
+	UINT8 basetics;
+	UINT16 cmdsize; // Bytes of packed ticcmds, the textcmds follow
+	UINT8 cmds[0];
+} ATTRPACK serverdeltatics_pak;
+
 typedef struct
 {
 	// Server launch stuffs
@@ -172,6 +198,10 @@ typedef struct
 	UINT8 data[0]; // Size is variable using hardware_MAXPACKETLENGTH
 } ATTRPACK filetx_pak;
 
+// Set in filesize while the file is still being made, and the
+// size is only what it won't grow past
+#define FILETX_SIZEPENDING 0x80000000
+
 typedef struct
 {
 	UINT32 start;
@@ -199,10 +229,19 @@ typedef struct
 	UINT8 localplayers;
 	UINT8 mode;
 	char names[MAXSPLITSCREENPLAYERS][MAXPLAYERNAME];
+	UINT8 netcaps; // NETCAP_ flags, missing from older clients' packets
 } ATTRPACK clientconfig_pak;
 
+#define NETCAP_DELTATICS 0x01 // can read PT_SERVERDELTATICS
+#define NETCAP_CRC32C    0x02 // can check CRC32C packet checksums
+#define NETCAP_DEFLATE   0x04 // can unpack deflate gamestates
+#define NETCAP_ZSTD      0x08 // can unpack zstd gamestates
+#define NETCAP_SNAPSHOT  0x10 // can unpack chunked gamestates (d_snapshot.c)
+
 #define SV_DEDICATED    0x40 // server is dedicated
 #define SV_LOTSOFADDONS 0x20 // flag used to ask for full file list in d_netfil
+#define SV_CRC32C       0x10 // answer to NETCAP_CRC32C, use CRC32C checksums
+#define SV_SNAPSHOT     0x08 // answer to NETCAP_SNAPSHOT, can send chunked gamestates
 
 enum {
 	REFUSE_JOINS_DISABLED = 1,
@@ -253,6 +292,7 @@ typedef struct
 {
 	UINT8 version;
 	tic_t time; // used for ping evaluation
+	UINT8 netcaps; // NETCAP_ flags, missing from older clients' packets
 } ATTRPACK askinfo_pak;
 
 typedef struct
@@ -309,6 +349,7 @@ typedef struct
 		clientcmd_pak clientpak;            //         144 bytes
 		client2cmd_pak client2pak;          //         200 bytes
 		servertics_pak serverpak;           //      132495 bytes (more around 360, no?)
+		serverdeltatics_pak serverdeltapak; //           9 bytes + data
 		serverconfig_pak servercfg;         //         773 bytes
 		UINT8 textcmd[MAXTEXTCMD+1];        //       66049 bytes (wut??? 64k??? More like 257 bytes...)
 		filetx_pak filetxpak;               //         139 bytes
@@ -335,7 +376,7 @@ typedef struct
 #define MAXSERVERLIST (MAXNETNODES-1)
 typedef struct
 {
-	SINT8 node;
+	INT16 node;
 	serverinfo_pak info;
 } serverelem_t;
 
@@ -348,10 +389,13 @@ extern doomdata_t *netbuffer;
 
 extern consvar_t cv_showjoinaddress;
 extern consvar_t cv_playbackspeed;
+extern consvar_t cv_deltatics;
 
 #define BASEPACKETSIZE      offsetof(doomdata_t, u)
 #define FILETXHEADER        offsetof(filetx_pak, data)
 #define BASESERVERTICSSIZE  offsetof(doomdata_t, u.serverpak.cmds[0])
+#define BASESERVERDELTATICSSIZE offsetof(doomdata_t, u.serverdeltapak.cmds[0])
+#define MAXPLAYERINFO       ((MAXPACKETLENGTH - BASEPACKETSIZE) / sizeof (plrinfo))
 
 #define KICK_MSG_GO_AWAY     1
 #define KICK_MSG_CON_FAIL    2
@@ -384,7 +428,7 @@ extern boolean serverrunning;
 extern boolean dedicated; // For dedicated server
 extern UINT16 software_MAXPACKETLENGTH;
 extern boolean acceptnewnode;
-extern SINT8 servernode;
+extern INT16 servernode;
 
 void Command_Ping_f(void);
 extern tic_t connectiontimeout;
@@ -396,7 +440,7 @@ extern tic_t servermaxping;
 
 extern consvar_t cv_netticbuffer, cv_allownewplayer, cv_joinnextround, cv_maxplayers, cv_joindelay, cv_rejointimeout;
 extern consvar_t cv_resynchattempts, cv_blamecfail;
-extern consvar_t cv_maxsend, cv_noticedownload, cv_downloadspeed;
+extern consvar_t cv_maxsend, cv_noticedownload, cv_downloadspeed, cv_sendcachesize;
 
 // Used in d_net, the only dependence
 tic_t ExpandTics(INT32 low, INT32 node);
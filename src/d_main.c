@@ -48,6 +48,7 @@
 #include "p_setup.h"
 #include "p_saveg.h"
 #include "r_main.h"
+#include "r_fps.h"
 #include "r_local.h"
 #include "s_sound.h"
 #include "st_stuff.h"
@@ -68,6 +69,7 @@
 #include "filesrch.h" // refreshdirmenu
 #include "g_input.h" // tutorial mode control scheming
 #include "m_perfstats.h"
+#include "m_md5cache.h"
 
 #ifdef CMAKECONFIG
 #include "config.h"
@@ -511,6 +513,7 @@ static void D_Display(void)
 			if (!automapactive && !dedicated && cv_renderview.value)
 			{
 				PS_START_TIMING(ps_rendercalltime);
+				R_ApplyLevelInterpolators(rendertimefrac);
 				if (players[displayplayer].mo || players[displayplayer].playerstate == PST_DEAD)
 				{
 					topleft = screens[0] + viewwindowy*vid.width + viewwindowx;
@@ -525,7 +528,10 @@ static void D_Display(void)
 				}
 
 				if (I_AppOnBackground())
+				{
+					R_RestoreLevelInterpolators();
 					return;
+				}
 
 				// render the second screen
 				if (splitscreen && players[secondarydisplayplayer].mo)
@@ -549,6 +555,8 @@ static void D_Display(void)
 					}
 				}
 
+				R_RestoreLevelInterpolators();
+
 				if (I_AppOnBackground())
 					return;
 
@@ -730,9 +738,37 @@ static void D_Display(void)
 
 tic_t rendergametic;
 
+// Has enough time passed since the last frame to draw another one?
+static boolean D_FrameCapReady(precise_t lastframetime)
+{
+	const UINT32 cap = R_GetFramerateCap();
+	int elapsed;
+
+	if (cap == 0) // Unlimited
+		return true;
+
+	elapsed = I_PreciseToMicros(I_GetPreciseTime() - lastframetime);
+	return (elapsed < 0 || elapsed >= 1000000 / (int)cap);
+}
+
+// How far the next frame should be drawn between the last two tics.
+static fixed_t D_GetRenderTimeFrac(boolean ticstalled)
+{
+	// Nothing moves, or we are waiting on the server for new tics
+	if (ticstalled || paused || P_AutoPause())
+		return FRACUNIT;
+
+	if (!(gamestate == GS_LEVEL || (gamestate == GS_TITLESCREEN && titlemapinaction)))
+		return FRACUNIT;
+
+	return I_GetTimeFrac();
+}
+
 void D_SRB2Loop(void)
 {
 	tic_t oldentertics = 0, entertic = 0, realtics = 0, rendertimeout = INFTICS;
+	precise_t lastframetime = 0;
+	boolean ticstalled = false;
 	static lumpnum_t gstartuplumpnum;
 
 #if defined(__ANDROID__)
@@ -802,6 +838,8 @@ void D_SRB2Loop(void)
 
 	for (;;)
 	{
+		const boolean interp = R_UsingFrameInterpolation();
+
 		if (lastwipetic)
 		{
 			oldentertics = lastwipetic;
@@ -823,8 +861,13 @@ void D_SRB2Loop(void)
 
 		if (!realtics && !singletics)
 		{
-			I_Sleep();
-			continue;
+			// With frame interpolation, keep drawing in between tics
+			// for as long as the framerate cap allows it
+			if (!interp || !D_FrameCapReady(lastframetime))
+			{
+				I_Sleep();
+				continue;
+			}
 		}
 
 #ifdef HW3SOUND
@@ -843,8 +886,27 @@ void D_SRB2Loop(void)
 		// process tics (but maybe not if realtic == 0)
 		TryRunTics(realtics);
 
-		if (lastdraw || singletics || gametic > rendergametic)
+		if (interp)
 		{
+			if (gametic > rendergametic)
+				ticstalled = false;
+			else if (realtics)
+				ticstalled = true; // time moved on, but the game didn't
+
+			rendergametic = gametic;
+			rendertimeout = entertic+TICRATE/17;
+			rendertimefrac = D_GetRenderTimeFrac(ticstalled);
+			lastframetime = I_GetPreciseTime();
+
+			// Update display, next frame, with current state.
+			D_Display();
+
+			if (takescreenshot) // Only take screenshots after drawing.
+				M_DoScreenShot();
+		}
+		else if (lastdraw || singletics || gametic > rendergametic)
+		{
+			rendertimefrac = FRACUNIT;
 			rendergametic = gametic;
 			rendertimeout = entertic+TICRATE/17;
 
@@ -858,6 +920,8 @@ void D_SRB2Loop(void)
 		}
 		else if (rendertimeout < entertic) // in case the server hang or netsplit
 		{
+			rendertimefrac = FRACUNIT;
+
 			// Lagless camera! Yay!
 			if (gamestate == GS_LEVEL && netgame)
 			{
@@ -1410,6 +1474,13 @@ void D_SRB2Main(void)
 	startuphandletype = FILEHANDLE_SDL;
 #endif
 
+#ifndef NOMD5
+	// Hash whatever isn't in the MD5 cache in the background,
+	// while the files before it are being loaded
+	M_PrefetchFileMD5s(startupwadfiles.files, startupwadfiles.numfiles);
+	M_PrefetchFileMD5s(startuppwads.files, startuppwads.numfiles);
+#endif
+
 	// load wad, including the main wad file
 	CONS_Printf("W_InitMultipleFiles(): Adding IWAD and main PWADs.\n");
 	W_InitMultipleFiles(&startupwadfiles, startuphandletype);
@@ -1463,6 +1534,11 @@ void D_SRB2Main(void)
 		D_CleanFile(&startuppwads);
 	}
 
+#ifndef NOMD5
+	M_SaveMD5Cache();
+	M_PrintMD5CacheStats();
+#endif
+
 	CON_StartRefresh(); // Restart the refresh!
 
 	CONS_Printf("HU_LoadGraphics()...\n");
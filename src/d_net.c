@@ -28,6 +28,7 @@
 #include "z_zone.h"
 #include "i_tcp.h"
 #include "d_main.h" // srb2home
+#include "m_crc.h"
 
 //
 // NETWORKING
@@ -66,12 +67,14 @@ INT32 net_bandwidth;
 INT16 hardware_MAXPACKETLENGTH;
 
 boolean (*I_NetGet)(void) = NULL;
+precise_t netpacketarrival = 0;
 void (*I_NetSend)(void) = NULL;
+void (*I_NetFlush)(void) = NULL;
 boolean (*I_NetCanSend)(void) = NULL;
 boolean (*I_NetCanGet)(void) = NULL;
 void (*I_NetCloseSocket)(void) = NULL;
 void (*I_NetFreeNodenum)(INT32 nodenum) = NULL;
-SINT8 (*I_NetMakeNodewPort)(const char *address, const char* port) = NULL;
+INT16 (*I_NetMakeNodewPort)(const char *address, const char* port) = NULL;
 boolean (*I_NetOpenSocket)(void) = NULL;
 boolean (*I_Ban) (INT32 node) = NULL;
 void (*I_ClearBans)(void) = NULL;
@@ -185,6 +188,15 @@ typedef struct
 	UINT8 nextacknum;
 
 	UINT8 flags;
+	UINT8 checksum; // netchecksum_t this node's packets are sent with
+
+	// Arrival times of packets stamped with the tic they were sent on
+	precise_t lastticarrival; // 0 until the first one
+	tic_t lasttic;
+	INT64 transit; // One-way delay, relative to the first packet, in microseconds
+	INT64 mintransit;
+	INT32 jitter; // Interarrival jitter as in RFC 3550, in microseconds
+	INT32 queuedelay; // How long packets waited before being read, in microseconds
 } node_t;
 
 static node_t nodes[MAXNETNODES];
@@ -629,6 +641,9 @@ static void InitNode(node_t *node)
 	node->nextacknum = 1;
 	node->remotefirstack = 0;
 	node->flags = 0;
+	node->checksum = NETCHECKSUM_LEGACY;
+	node->lastticarrival = 0;
+	node->jitter = node->queuedelay = 0;
 }
 
 static void InitAck(void)
@@ -725,20 +740,95 @@ void Net_CloseConnection(INT32 node)
 //
 // Checksum
 //
-static UINT32 NetbufferChecksum(void)
+static UINT32 LegacyChecksum(const UINT8 *buf, INT32 l)
 {
 	UINT32 c = 0x1234567;
-	const INT32 l = doomcom->datalength - 4;
-	const UINT8 *buf = (UINT8 *)netbuffer + 4;
 	INT32 i;
 
 	for (i = 0; i < l; i++, buf++)
 		c += (*buf) * (i+1);
 
-	return LONG(c);
+	return c;
+}
+
+static UINT32 NetbufferChecksum(netchecksum_t checksum)
+{
+	const INT32 l = doomcom->datalength - 4;
+	const UINT8 *buf = (UINT8 *)netbuffer + 4;
+
+	if (checksum == NETCHECKSUM_CRC32C && l > 0)
+		return LONG(M_CRC32C(buf, l));
+	return LONG(LegacyChecksum(buf, l));
+}
+
+// checksumbench [megabytes]: times both checksums on typical packet sizes
+void Command_ChecksumBench_f(void)
+{
+	static const INT32 sizes[] = {16, 64, 256, 512, 1024, MAXPACKETLENGTH - 4};
+	const char *names[] = {"legacy", "CRC32C table", "CRC32C"};
+	UINT8 *buf;
+	INT32 megabytes = 64;
+	size_t i;
+	INT32 j, method;
+	volatile UINT32 sink = 0;
+
+	if (COM_Argc() > 1)
+		megabytes = max(atoi(COM_Argv(1)), 1);
+
+	buf = Z_Malloc(MAXPACKETLENGTH, PU_STATIC, NULL);
+	for (j = 0; j < MAXPACKETLENGTH; j++)
+		buf[j] = (UINT8)(j * 151 + 7);
+
+	CONS_Printf(M_GetText("CRC32C is using: %s\n"), M_CRC32CImplementation());
+	CONS_Printf("%6s %14s %14s %14s\n", "Bytes", names[0], names[1], names[2]);
+
+	for (i = 0; i < sizeof sizes / sizeof *sizes; i++)
+	{
+		const INT32 len = sizes[i];
+		const INT32 packets = max((INT32)(((INT64)megabytes << 20) / len), 1);
+		double gbps[3];
+
+		for (method = 0; method < 3; method++)
+		{
+			precise_t start = I_GetPreciseTime();
+			UINT64 micros;
+
+			for (j = 0; j < packets; j++)
+			{
+				buf[0] = (UINT8)j; // don't let the compiler hoist it out
+				if (method == 0)
+					sink += LegacyChecksum(buf, len);
+				else if (method == 1)
+					sink += M_CRC32CSoftware(buf, len);
+				else
+					sink += M_CRC32C(buf, len);
+			}
+
+			micros = max(I_PreciseToMicros(I_GetPreciseTime() - start), 1);
+			gbps[method] = (double)packets * len / micros / 1000.0;
+		}
+
+		CONS_Printf("%6d %9.2f GB/s %9.2f GB/s %9.2f GB/s\n", len, gbps[0], gbps[1], gbps[2]);
+	}
+
+	(void)sink;
+	Z_Free(buf);
 }
 #endif
 
+void Net_SetChecksum(INT32 node, netchecksum_t checksum)
+{
+	if (node > 0 && node < MAXNETNODES)
+		nodes[node].checksum = (UINT8)checksum;
+}
+
+netchecksum_t Net_GetChecksum(INT32 node)
+{
+	if (node > 0 && node < MAXNETNODES)
+		return nodes[node].checksum;
+	return NETCHECKSUM_LEGACY;
+}
+
 #ifdef DEBUGFILE
 
 static void fprintfstring(char *s, size_t len)
@@ -817,7 +907,9 @@ static const char *packettypename[NUMPACKETTYPE] =
 	"LOGIN",
 	"TELLFILESNEEDED",
 	"MOREFILESNEEDED",
-	"PING"
+	"PING",
+
+	"SERVERDELTATICS",
 };
 
 static void DebugPrintpacket(const char *header)
@@ -855,6 +947,15 @@ static void DebugPrintpacket(const char *header)
 			fprintf(debugfile, "\n");*/
 			break;
 		}
+		case PT_SERVERDELTATICS:
+		{
+			serverdeltatics_pak *deltapak = &netbuffer->u.serverdeltapak;
+
+			fprintf(debugfile, "    firsttic %u ply %d tics %d basetics %d cmdsize %d\n",
+				(UINT32)deltapak->starttic, deltapak->numslots, deltapak->numtics,
+				deltapak->basetics, SHORT(deltapak->cmdsize));
+			break;
+		}
 		case PT_CLIENTCMD:
 		case PT_CLIENT2CMD:
 		case PT_CLIENTMIS:
@@ -1059,7 +1160,12 @@ boolean HSendPacket(INT32 node, boolean reliable, UINT8 acknum, size_t packetlen
 	else
 		netbuffer->ack = acknum;
 
-	netbuffer->checksum = NetbufferChecksum();
+	// Broadcasts, and asking for server info, have to be readable
+	// by anyone, so they always use the old checksum
+	if (node < MAXNETNODES && netbuffer->packettype != PT_ASKINFO && netbuffer->packettype != PT_SERVERINFO)
+		netbuffer->checksum = NetbufferChecksum(nodes[node].checksum);
+	else
+		netbuffer->checksum = NetbufferChecksum(NETCHECKSUM_LEGACY);
 	sendbytes += packetheaderlength + doomcom->datalength; // For stat
 
 #ifdef PACKETDROP
@@ -1126,11 +1232,16 @@ boolean HGetPacket(void)
 	while(true)
 	{
 		//nodejustjoined = I_NetGet();
+		netpacketarrival = 0;
 		I_NetGet();
 
 		if (doomcom->remotenode == -1) // No packet received
 			return false;
 
+		// Drivers without a network thread read packets just as they're handled
+		if (!netpacketarrival)
+			netpacketarrival = I_GetPreciseTime();
+
 		getbytes += packetheaderlength + doomcom->datalength; // For stat
 
 		if (doomcom->remotenode >= MAXNETNODES)
@@ -1140,8 +1251,16 @@ boolean HGetPacket(void)
 		}
 
 		nodes[doomcom->remotenode].lasttimepacketreceived = I_GetTime();
+		{
+			node_t *node = &nodes[doomcom->remotenode];
+			INT32 waited = I_PreciseToMicros(I_GetPreciseTime() - netpacketarrival);
+			node->queuedelay += (waited - node->queuedelay) / 16;
+		}
 
-		if (netbuffer->checksum != NetbufferChecksum())
+		// Try what the node should be using first; the other one is only
+		// checked while it and we are switching over
+		if (netbuffer->checksum != NetbufferChecksum(nodes[doomcom->remotenode].checksum)
+			&& netbuffer->checksum != NetbufferChecksum(!nodes[doomcom->remotenode].checksum))
 		{
 			DEBFILE("Bad packet checksum\n");
 			// Do not disconnect or anything, just ignore the packet.
@@ -1203,9 +1322,9 @@ static void Internal_FreeNodenum(INT32 nodenum)
 	(void)nodenum;
 }
 
-SINT8 I_NetMakeNode(const char *hostname)
+INT16 I_NetMakeNode(const char *hostname)
 {
-	SINT8 newnode = -1;
+	INT16 newnode = -1;
 	if (I_NetMakeNodewPort)
 	{
 		char *localhostname = strdup(hostname);
@@ -1254,6 +1373,7 @@ boolean D_CheckNetGame(void)
 
 	I_NetGet = Internal_Get;
 	I_NetSend = Internal_Send;
+	I_NetFlush = NULL;
 	I_NetCanSend = NULL;
 	I_NetCloseSocket = NULL;
 	I_NetFreeNodenum = Internal_FreeNodenum;
@@ -1357,6 +1477,50 @@ boolean D_CheckNetGame(void)
 	return ret;
 }
 
+/** Measures how evenly packets stamped with the tic they were sent on
+  * arrive, using the tics as the sender's clock. Call it while handling
+  * the packet.
+  *
+  * \param node The node the packet came from
+  * \param tic The tic the packet was sent on
+  *
+  */
+void Net_SampleTicArrival(INT32 node, tic_t tic)
+{
+	node_t *n = &nodes[node];
+
+	if (n->lastticarrival && tic <= n->lasttic)
+		return; // Resent or out of order
+
+	if (n->lastticarrival && tic - n->lasttic < 10*TICRATE)
+	{
+		// How much later than the tics say this one arrived, compared to the one before
+		INT32 d = I_PreciseToMicros(netpacketarrival - n->lastticarrival)
+			- (INT32)((tic - n->lasttic) * 1000000 / TICRATE);
+
+		n->transit += d;
+		n->mintransit = min(n->mintransit, n->transit);
+		n->jitter += (abs(d) - n->jitter) / 16;
+	}
+	else
+		n->transit = n->mintransit = 0; // Start over after a long gap
+
+	n->lastticarrival = netpacketarrival;
+	n->lasttic = tic;
+}
+
+// Prints the timing stats of packets from a node, if any were taken
+static void PrintPacketTiming(INT32 node)
+{
+	const node_t *n = &nodes[node];
+
+	if (!n->lastticarrival)
+		return;
+
+	CONS_Printf("Jitter %.1f ms, one-way delay %.1f ms over its lowest, packets waited %.1f ms to be read\n",
+		n->jitter / 1000.0, (n->transit - n->mintransit) / 1000.0, n->queuedelay / 1000.0);
+}
+
 struct pingcell
 {
 	INT32 num;
@@ -1423,6 +1587,8 @@ void Command_Ping_f(void)
 	if (!server && playeringame[consoleplayer])
 	{
 		CONS_Printf("\nYour ping is %d ms\n", playerpingtable[consoleplayer]);
+		if (servernode >= 0 && servernode < MAXNETNODES)
+			PrintPacketTiming(servernode);
 	}
 }
 
@@ -1446,6 +1612,7 @@ void D_CloseConnection(void)
 
 		I_NetGet = Internal_Get;
 		I_NetSend = Internal_Send;
+		I_NetFlush = NULL;
 		I_NetCanSend = NULL;
 		I_NetCloseSocket = NULL;
 		I_NetFreeNodenum = Internal_FreeNodenum;
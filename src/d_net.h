@@ -19,9 +19,15 @@
 #define __D_NET__
 
 // Max computers in a game
-// 127 is probably as high as this can go, because
-// SINT8 is used for nodes sometimes >:(
+// Nodes go out in packets as a byte, and 255 is "no node",
+// so 254 is as high as this can go.
+#ifndef MAXPLAYERS
+#error d_net.h needs doomdef.h first
+#elif MAXPLAYERS > 64
+#define MAXNETNODES 254
+#else
 #define MAXNETNODES 127
+#endif
 #define BROADCASTADDR MAXNETNODES
 #define MAXSPLITSCREENPLAYERS 2 // Max number of players on a single computer
 //#define NETSPLITSCREEN // Kart's splitscreen netgame feature
@@ -63,5 +69,19 @@ void Net_ConnectionTimeout(INT32 node);
 void Net_AbortPacketType(UINT8 packettype);
 void Net_SendAcks(INT32 node);
 void Net_WaitAllAckReceived(UINT32 timeout);
+void Net_SampleTicArrival(INT32 node, tic_t tic);
+
+// Packet checksums. Nodes start out on the old one, and switch to
+// CRC32C once both ends have said they can check it. Packets from
+// any node are accepted with either.
+typedef enum
+{
+	NETCHECKSUM_LEGACY,
+	NETCHECKSUM_CRC32C,
+} netchecksum_t;
+
+void Net_SetChecksum(INT32 node, netchecksum_t checksum);
+netchecksum_t Net_GetChecksum(INT32 node);
+void Command_ChecksumBench_f(void);
 
 #endif
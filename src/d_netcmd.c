@@ -31,6 +31,7 @@
 #include "am_map.h"
 #include "byteptr.h"
 #include "d_netfil.h"
+#include "d_snapshot.h"
 #include "p_spec.h"
 #include "m_cheat.h"
 #include "d_clisrv.h"
@@ -40,14 +41,18 @@
 #include "m_random.h"
 #include "f_finale.h"
 #include "filesrch.h"
+#include "w_decompress.h"
 #include "mserv.h"
 #include "z_zone.h"
 #include "lua_script.h"
 #include "lua_hook.h"
+#include "lua_alloc.h"
 #include "m_cond.h"
 #include "m_anigif.h"
 #include "md5.h"
+#include "m_md5cache.h"
 #include "m_perfstats.h"
+#include "p_saveg.h"
 
 #ifdef NETGAME_DEVMODE
 #define CV_RESTRICT CV_NETVAR
@@ -164,6 +169,7 @@ static void Command_Cheats_f(void);
 static void Command_Togglemodified_f(void);
 static void Command_Archivetest_f(void);
 #endif
+static void Command_SaveGameBench_f(void);
 
 // =========================================================================
 //                           CLIENT VARIABLES
@@ -392,7 +398,7 @@ consvar_t cv_thinkless = CVAR_INIT("thinkless", "Off", CV_SAVE, CV_OnOff, NULL);
 consvar_t cv_sleep = CVAR_INIT ("cpusleep", "1", CV_SAVE, sleeping_cons_t, NULL);
 
 static CV_PossibleValue_t perfstats_cons_t[] = {
-	{0, "Off"}, {1, "Rendering"}, {2, "Logic"}, {3, "ThinkFrame"}, {0, NULL}};
+	{0, "Off"}, {1, "Rendering"}, {2, "Logic"}, {3, "ThinkFrame"}, {4, "Hooks"}, {0, NULL}};
 consvar_t cv_perfstats = CVAR_INIT ("perfstats", "Off", CV_CALL, perfstats_cons_t, PS_PerfStats_OnChange);
 static CV_PossibleValue_t ps_samplesize_cons_t[] = {
 	{1, "MIN"}, {1000, "MAX"}, {0, NULL}};
@@ -401,6 +407,10 @@ static CV_PossibleValue_t ps_descriptor_cons_t[] = {
 	{1, "Average"}, {2, "SD"}, {3, "Minimum"}, {4, "Maximum"}, {0, NULL}};
 consvar_t cv_ps_descriptor = CVAR_INIT ("ps_descriptor", "Average", 0, ps_descriptor_cons_t, NULL);
 
+// Runs the same thinkers in the same order either way, so it's not a netvar
+consvar_t cv_batchthinkers = CVAR_INIT ("batchthinkers", "On", 0, CV_OnOff, NULL);
+consvar_t cv_thingindex = CVAR_INIT ("thingindex", "Off", CV_CALL, CV_OnOff, P_ThingIndex_OnChange);
+
 consvar_t cv_freedemocamera = CVAR_INIT("freedemocamera", "Off", CV_SAVE, CV_OnOff, NULL);
 
 char timedemo_name[256];
@@ -506,6 +516,18 @@ void D_RegisterServerCommands(void)
 	COM_AddCommand("addfolder", Command_Addfolder);
 	COM_AddCommand("addfile", Command_Addfile);
 	COM_AddCommand("listwad", Command_ListWADS_f);
+	COM_AddCommand("lumpbench", Command_Lumpbench_f);
+	COM_AddCommand("lumpcachestats", Command_LumpCacheStats_f);
+	COM_AddCommand("luafieldbench", Command_LuaFieldBench_f);
+	COM_AddCommand("luamemstats", Command_LuaMemStats_f);
+#ifndef NONET
+	COM_AddCommand("checksumbench", Command_ChecksumBench_f);
+#endif
+	COM_AddCommand("gamestatebench", Command_GamestateBench_f);
+	CV_RegisterVar(&cv_gamestatecodec);
+	CV_RegisterVar(&cv_luagcbudget);
+	CV_RegisterVar(&cv_batchthinkers);
+	CV_RegisterVar(&cv_thingindex);
 
 	COM_AddCommand("runsoc", Command_RunSOC);
 	COM_AddCommand("pause", Command_Pause);
@@ -529,6 +551,7 @@ void D_RegisterServerCommands(void)
 	COM_AddCommand("togglemodified", Command_Togglemodified_f);
 	COM_AddCommand("archivetest", Command_Archivetest_f);
 #endif
+	COM_AddCommand("savegamebench", Command_SaveGameBench_f);
 
 	COM_AddCommand("downloads", Command_Downloads_f);
 
@@ -610,10 +633,12 @@ void D_RegisterServerCommands(void)
 	CV_RegisterVar(&cv_maxsend);
 	CV_RegisterVar(&cv_noticedownload);
 	CV_RegisterVar(&cv_downloadspeed);
+	CV_RegisterVar(&cv_sendcachesize);
 #ifndef NONET
 	CV_RegisterVar(&cv_allownewplayer);
 	CV_RegisterVar(&cv_joinnextround);
 	CV_RegisterVar(&cv_showjoinaddress);
+	CV_RegisterVar(&cv_deltatics);
 	CV_RegisterVar(&cv_blamecfail);
 #endif
 
@@ -925,6 +950,8 @@ void D_RegisterClientCommands(void)
 	CV_RegisterVar(&cv_ps_samplesize);
 	CV_RegisterVar(&cv_ps_descriptor);
 
+	CV_RegisterVar(&cv_lumpcachesize);
+
 	// ingame object placing
 	COM_AddCommand("objectplace", Command_ObjectPlace_f);
 	COM_AddCommand("writethings", Command_Writethings_f);
@@ -3427,11 +3454,12 @@ static void Command_Addfile(void)
 
 			if ((fhandle = W_OpenWadFile(&fn, FILEHANDLE_STANDARD, true)) != NULL)
 			{
-				tic_t t = I_GetTime();
-				CONS_Debug(DBG_SETUP, "Making MD5 for %s\n",fn);
-				md5_stream(fhandle, md5sum);
-				CONS_Debug(DBG_SETUP, "MD5 calc for %s took %f second\n", fn, (float)(I_GetTime() - t)/TICRATE);
 				fclose(fhandle);
+
+				// Only hashed if it changed since the last time
+				if (!M_GetFileMD5(fn, md5sum))
+					continue;
+				M_SaveMD5Cache();
 			}
 			else // file not found
 				continue;
@@ -4750,6 +4778,94 @@ static void Command_Archivetest_f(void)
 }
 #endif
 
+/** Adds lots of mobjs pointing at each other to the level, saves it as
+  * a netgame and loads it back in, like a joining client would, and
+  * prints how long that took. Needs devmode, since it spawns rings.
+  */
+static void Command_SaveGameBench_f(void)
+{
+	UINT32 nummobjs = 10000, i, seed = 0x5EED;
+	mobj_t **spawned;
+	mobj_t *origin;
+	UINT8 *savebuffer;
+	size_t buffersize, length;
+	precise_t start, saved, loaded;
+	boolean matched;
+
+	if (!cv_debug)
+	{
+		CONS_Printf(M_GetText("DEVMODE must be enabled.\n"));
+		return;
+	}
+
+	if (COM_Argc() > 1)
+		nummobjs = (UINT32)max(atoi(COM_Argv(1)), 0);
+
+	if (gamestate != GS_LEVEL || netgame || demoplayback || !players[consoleplayer].mo)
+	{
+		CONS_Printf(M_GetText("savegamebench [mobjs]: only works in a level, outside netgames\n"));
+		return;
+	}
+
+	G_SetGameModified(multiplayer);
+
+	origin = players[consoleplayer].mo;
+	spawned = malloc(max(nummobjs, 1) * sizeof (*spawned));
+	if (!spawned)
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegamebench\n"));
+		return;
+	}
+
+	// A grid of rings around the player, each with a target and
+	// tracer from the ones before it to relink
+	for (i = 0; i < nummobjs; i++)
+	{
+		const fixed_t x = origin->x + ((INT32)(i % 100) - 50) * 64*FRACUNIT;
+		const fixed_t y = origin->y + ((INT32)((i / 100) % 100) - 50) * 64*FRACUNIT;
+
+		spawned[i] = P_SpawnMobj(x, y, origin->z, MT_RING);
+		spawned[i]->flags |= MF_NOCLIPHEIGHT;
+
+		if (i)
+		{
+			seed = seed * 1103515245u + 12345u;
+			P_SetTarget(&spawned[i]->target, spawned[(seed >> 8) % i]);
+			P_SetTarget(&spawned[i]->tracer, spawned[i - 1]);
+		}
+	}
+	free(spawned);
+
+	// Mobjs take a few dozen bytes each, so leave plenty of room
+	buffersize = SAVEGAMESIZE + (size_t)nummobjs * 256;
+	save_p = savebuffer = malloc(buffersize);
+	if (!savebuffer)
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegamebench\n"));
+		return;
+	}
+
+	start = I_GetPreciseTime();
+	P_SaveNetGame(false);
+	saved = I_GetPreciseTime();
+
+	length = save_p - savebuffer;
+	if (length > buffersize)
+		I_Error("Savegame buffer overrun");
+
+	save_p = savebuffer;
+	matched = P_LoadNetGame(true);
+	loaded = I_GetPreciseTime();
+
+	free(savebuffer);
+	save_p = NULL;
+
+	CONS_Printf(M_GetText("Saved %s bytes with %u extra mobjs in %.2f ms, loaded them in %.2f ms%s\n"),
+		sizeu1(length), nummobjs,
+		I_PreciseToMicros(saved - start) / 1000.0, I_PreciseToMicros(loaded - saved) / 1000.0,
+		matched ? "" : M_GetText(" (but it didn't match)"));
+}
+
 /** Makes a change to ::cv_forceskin take effect immediately.
   *
   * \todo Move the enforcement code out of SendNameAndColor() so this hack
@@ -122,6 +122,8 @@ extern consvar_t cv_thinkless;
 extern consvar_t cv_perfstats;
 extern consvar_t cv_ps_samplesize;
 extern consvar_t cv_ps_descriptor;
+extern consvar_t cv_batchthinkers;
+extern consvar_t cv_thingindex;
 
 extern char timedemo_name[256];
 extern boolean timedemo_csv;
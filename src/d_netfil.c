@@ -47,6 +47,7 @@
 #include "m_misc.h"
 #include "m_menu.h"
 #include "md5.h"
+#include "m_md5cache.h"
 #include "filesrch.h"
 
 #include <errno.h>
@@ -55,12 +56,35 @@
 static boolean AddFileToSendQueue(INT32 node, UINT8 fileid);
 
 // Sender structure
+// An addon kept in memory while it's being sent, so every node
+// downloading it at once is served from one copy. Entries are keyed
+// by MD5 and filled in a chunk at a time as fragments are needed.
+#define SENDCACHECHUNKSIZE (256*1024)
+
+typedef struct sendcache_s
+{
+	UINT8 md5sum[16];
+	char filename[MAX_WADPATH];
+	FILE *file; // Open while anyone is sending it
+	UINT8 *data;
+	boolean *chunkloaded;
+	UINT32 size;
+	INT32 refcount;
+	tic_t lastused;
+	struct sendcache_s *next;
+} sendcache_t;
+
+static sendcache_t *sendcache = NULL;
+static size_t sendcachesize = 0; // Total bytes allocated for entries
+
 typedef struct filetx_s
 {
 	INT32 ram;
 	union {
 		char *filename; // Name of the file
 		char *ram; // Pointer to the data in RAM
+		snapshot_t *snapshot; // Gamestate, streamed as it gets compressed
+		sendcache_t *cache; // Shared addon data
 	} id;
 	UINT32 size; // Size of the file
 	UINT8 fileid;
@@ -68,17 +92,83 @@ typedef struct filetx_s
 	struct filetx_s *next; // Next file in the list
 } filetx_t;
 
+// What happened to a fragment being sent
+#define FRAG_ACKED    1
+#define FRAG_INFLIGHT 2 // Sent, neither acknowledged nor given up on yet
+#define FRAG_LOST     4 // Waiting to be resent
+
+typedef struct
+{
+	precise_t senttime;
+	UINT32 seq; // When it was last sent, counted in fragments
+	UINT8 flags;
+	UINT8 sends;
+} fragmentstate_t;
+
+// Congestion window, in fragments
+#define FILEWINDOWMIN 4
+#define FILEWINDOWINIT 16
+#define FILEWINDOWMAX 1024
+
+// How many fragments sent after one must be acknowledged before
+// it's considered lost, rather than just late or reordered
+#define FILEREORDER 3
+
+// Resend timeout bounds, in microseconds
+#define FILERTOMIN 100000
+#define FILERTOINIT 1000000
+#define FILERTOMAX 3000000
+
+#define SENTQUEUESIZE (2*FILEWINDOWMAX)
+#define READAHEADSIZE (256*1024)
+
 // Current transfers (one for each node)
 typedef struct filetran_s
 {
 	filetx_t *txlist; // Linked list of all files for the node
-	UINT8 iteration;
-	UINT8 ackediteration;
-	UINT32 position; // The current position in the file
-	boolean *ackedfragments;
-	UINT32 ackedsize;
 	FILE *currentfile; // The file currently being sent/received
-	tic_t dontsenduntil;
+
+	fragmentstate_t *fragments;
+	UINT32 numfragments; // How many can be sent so far
+	boolean sizefinal; // False while a snapshot is still being compressed
+	UINT32 nextfragment; // First one never sent
+	UINT32 numacked;
+	UINT32 ackedsize;
+
+	// AIMD congestion control: the window grows by a fragment for
+	// each one acknowledged until the threshold, then by a fragment
+	// per window, and is halved once per window that loses any
+	float window;
+	float threshold;
+	UINT32 inflight;
+	UINT32 sendseq; // Fragments sent, including resends
+	UINT32 highestackedseq;
+	UINT32 recoveryseq; // Losses of fragments sent before this were already counted
+
+	// Round-trip time estimate, in microseconds
+	INT32 srtt, rttvar, rto;
+
+	// Fragments in the order they were sent, oldest first, for
+	// finding lost ones. Entries are skipped once acknowledged.
+	struct
+	{
+		UINT32 fragment;
+		UINT32 seq;
+	} *sent;
+	UINT32 senthead, senttail;
+
+	// Lost fragments to resend before anything new
+	UINT32 *lost;
+	UINT32 losthead, losttail;
+
+	// Read-ahead buffer for files
+	UINT8 *readahead;
+	UINT32 readaheadpos, readaheadlen;
+
+	// Acknowledged bytes per second, for the downloads command
+	UINT32 rate;
+	UINT32 ratebytes;
+	tic_t ratestart;
 } filetran_t;
 static filetran_t transfer[MAXNETNODES];
 
@@ -89,6 +179,11 @@ static filetran_t transfer[MAXNETNODES];
 INT32 fileneedednum; // Number of files needed to join the server
 fileneeded_t *fileneeded; // List of needed files
 static tic_t lasttimeackpacketsent = 0;
+
+// Bytes per second of new file data received, for the download screen
+static UINT32 downloadrate = 0;
+static UINT32 downloadratebytes = 0;
+static tic_t downloadratestart = 0;
 char downloaddir[512] = "DOWNLOAD";
 
 // For resuming failed downloads
@@ -549,6 +644,8 @@ INT32 CL_CheckFiles(void)
 	}
 
 	//now making it here means we've checked the entire list and no FS_NOTCHECKED files remain
+	M_SaveMD5Cache();
+
 	if (numwadfiles+filestoload > MAX_WADFILES)
 		return 3;
 	else if (downloadrequired)
@@ -804,6 +901,147 @@ void CL_PrepareDownloadLuaFile(void)
 // Little optimization to quickly test if there is a file in the queue
 static INT32 filestosend = 0;
 
+static void FreeSendCacheEntry(sendcache_t *entry)
+{
+	sendcache_t **prev;
+
+	for (prev = &sendcache; *prev != entry; prev = &(*prev)->next)
+		;
+	*prev = entry->next;
+
+	sendcachesize -= entry->size;
+	free(entry->chunkloaded);
+	free(entry->data);
+	free(entry);
+}
+
+// Frees idle entries, least recently used first, until
+// there's room for this many more bytes under the limit
+static boolean MakeRoomInSendCache(size_t size)
+{
+	const size_t limit = (size_t)cv_sendcachesize.value * 1024 * 1024;
+
+	if (size > limit)
+		return false;
+
+	while (sendcachesize + size > limit)
+	{
+		sendcache_t *entry, *oldest = NULL;
+
+		for (entry = sendcache; entry; entry = entry->next)
+			if (!entry->refcount && (!oldest || entry->lastused < oldest->lastused))
+				oldest = entry;
+
+		if (!oldest)
+			return false; // Everything is being sent right now
+
+		FreeSendCacheEntry(oldest);
+	}
+
+	return true;
+}
+
+/** Finds an addon in the shared send cache, adding it if it isn't
+  * there yet, and holds a reference to it
+  *
+  * \param wadnum The loaded addon to send
+  * \return The entry, or NULL if it doesn't fit within cv_sendcachesize
+  *
+  */
+static sendcache_t *SV_GetSendCacheEntry(UINT16 wadnum)
+{
+	const wadfile_t *wad = wadfiles[wadnum];
+	sendcache_t *entry;
+
+	if (wad->type == RET_FOLDER)
+		return NULL;
+
+	for (entry = sendcache; entry; entry = entry->next)
+		if (!memcmp(entry->md5sum, wad->md5sum, 16) && entry->size == wad->filesize)
+			break;
+
+	if (!entry)
+	{
+		if (!MakeRoomInSendCache(wad->filesize))
+			return NULL;
+
+		entry = calloc(1, sizeof (*entry));
+		if (!entry)
+			I_Error("SV_GetSendCacheEntry: No more memory\n");
+
+		entry->data = malloc(wad->filesize);
+		entry->chunkloaded = calloc(wad->filesize / SENDCACHECHUNKSIZE + 1, sizeof (*entry->chunkloaded));
+		if (!entry->data || !entry->chunkloaded)
+		{
+			// Just send it from the file instead
+			free(entry->data);
+			free(entry->chunkloaded);
+			free(entry);
+			return NULL;
+		}
+
+		M_Memcpy(entry->md5sum, wad->md5sum, 16);
+		strlcpy(entry->filename, wad->filename, MAX_WADPATH);
+		entry->size = wad->filesize;
+		sendcachesize += entry->size;
+
+		entry->next = sendcache;
+		sendcache = entry;
+	}
+
+	entry->refcount++;
+	entry->lastused = I_GetTime();
+	return entry;
+}
+
+static void SV_ReleaseSendCacheEntry(sendcache_t *entry)
+{
+	if (--entry->refcount)
+		return;
+
+	if (entry->file)
+	{
+		fclose(entry->file);
+		entry->file = NULL;
+	}
+	entry->lastused = I_GetTime();
+
+	// The limit may have been lowered while it was being sent
+	if (sendcachesize > (size_t)cv_sendcachesize.value * 1024 * 1024)
+		FreeSendCacheEntry(entry);
+}
+
+// Copies part of a cached addon, reading in the chunks it covers first
+static void ReadSendCache(sendcache_t *entry, UINT32 position, UINT8 *dest, size_t size)
+{
+	UINT32 chunk;
+
+	for (chunk = position / SENDCACHECHUNKSIZE; chunk * SENDCACHECHUNKSIZE < position + size; chunk++)
+	{
+		const UINT32 start = chunk * SENDCACHECHUNKSIZE;
+		const size_t toread = min(SENDCACHECHUNKSIZE, entry->size - start);
+
+		if (entry->chunkloaded[chunk])
+			continue;
+
+		if (!entry->file)
+		{
+			entry->file = fopen(entry->filename, "rb");
+			if (!entry->file)
+				I_Error("File %s does not exist", entry->filename);
+		}
+
+		fseek(entry->file, start, SEEK_SET);
+		if (fread(entry->data + start, 1, toread, entry->file) != toread)
+			I_Error("FileSendTicker: can't read %s byte on %s at %d because %s", sizeu1(toread), entry->filename, start, M_FileError(entry->file));
+
+		entry->chunkloaded[chunk] = true;
+	}
+
+	M_Memcpy(dest, entry->data + position, size);
+	entry->lastused = I_GetTime();
+}
+
 /** Adds a file to the file list for a node
   *
   * \param node The node to send the file to
@@ -817,6 +1055,7 @@ static boolean AddFileToSendQueue(INT32 node, UINT8 fileid)
 {
 	filetx_t **q; // A pointer to the "next" field of the last file in the list
 	filetx_t *p; // The new file request
+	sendcache_t *cache;
 	UINT16 wadnum;
 
 	// Find the last file in the list and set a pointer to its "next" field
@@ -874,8 +1113,21 @@ static boolean AddFileToSendQueue(INT32 node, UINT8 fileid)
 		CONS_Printf("Sending file \"%s\" to node %d (%s)\n", p->id.filename, node, I_GetNodeAddress(node));
 
 	DEBFILE(va("Sending file %s (id=%d) to %d\n", p->id.filename, fileid, node));
-	p->ram = SF_FILE; // It's a file, we need to close it and free its name once we're done sending it
 	p->fileid = fileid;
+
+	// Send it from memory if the cache has room, so nodes
+	// downloading it at the same time share one copy
+	cache = SV_GetSendCacheEntry(wadnum);
+	if (cache)
+	{
+		free(p->id.filename);
+		p->id.cache = cache;
+		p->size = cache->size;
+		p->ram = SF_CACHE; // Release it once we're done sending it
+	}
+	else
+		p->ram = SF_FILE; // It's a file, we need to close it and free its name once we're done sending it
+
 	p->next = NULL; // End of list
 	filestosend++;
 	return true;
@@ -921,6 +1173,20 @@ void AddRamToSendQueue(INT32 node, void *data, size_t size, freemethod_t freemet
 	filestosend++;
 }
 
+/** Adds a gamestate snapshot to the file list for a node.
+  * It starts being sent before it's done being compressed.
+  *
+  * \param node The node to send the snapshot to
+  * \param snapshot The snapshot, released once it's sent
+  * \param fileid The index of the file in the list of added files
+  * \sa AddRamToSendQueue
+  *
+  */
+void AddSnapshotToSendQueue(INT32 node, snapshot_t *snapshot, UINT8 fileid)
+{
+	AddRamToSendQueue(node, snapshot, SV_SnapshotMaxSize(snapshot), SF_SNAPSHOT, fileid);
+}
+
 /** Adds a file requested by Lua to the file list for a node
   *
   * \param node The node to send the file to
@@ -995,33 +1261,263 @@ static void SV_EndFileSend(INT32 node)
 			free(p->id.ram);
 		case SF_NOFREERAM: // Nothing to free
 			break;
+		case SF_SNAPSHOT: // Other nodes may still be sending it
+			SV_ReleaseSnapshot(p->id.snapshot);
+			break;
+		case SF_CACHE: // Other nodes may still be sending it
+			if (cv_noticedownload.value)
+				CONS_Printf("Ending file transfer for node %d\n", node);
+			SV_ReleaseSendCacheEntry(p->id.cache);
+			break;
 	}
 
+	// Indicate that the transmission is over
+	free(transfer[node].fragments);
+	free(transfer[node].sent);
+	free(transfer[node].lost);
+	free(transfer[node].readahead);
+	memset(&transfer[node], 0, sizeof (filetran_t));
+
 	// Remove the file request from the list
 	transfer[node].txlist = p->next;
 	free(p);
 
-	// Indicate that the transmission is over
-	transfer[node].currentfile = NULL;
-	if (transfer[node].ackedfragments)
-		free(transfer[node].ackedfragments);
-	transfer[node].ackedfragments = NULL;
-
 	filestosend--;
 }
 
 #define FILEFRAGMENTSIZE (software_MAXPACKETLENGTH - (FILETXHEADER + BASEPACKETSIZE))
 
+// Opens the file at the front of a node's list, and starts the transfer
+static void OpenTransfer(INT32 node)
+{
+	filetran_t *trans = &transfer[node];
+	filetx_t *f = trans->txlist;
+
+	if (f->ram == SF_FILE) // Sending a file
+	{
+		long filesize;
+
+		trans->currentfile = fopen(f->id.filename, "rb");
+
+		if (!trans->currentfile)
+			I_Error("File %s does not exist", f->id.filename);
+
+		fseek(trans->currentfile, 0, SEEK_END);
+		filesize = ftell(trans->currentfile);
+
+		// Nobody wants to transfer a file bigger
+		// than 4GB!
+		if (filesize >= LONG_MAX)
+			I_Error("filesize of %s is too large", f->id.filename);
+		if (filesize == -1)
+			I_Error("Error getting filesize of %s", f->id.filename);
+
+		f->size = (UINT32)filesize;
+		fseek(trans->currentfile, 0, SEEK_SET);
+
+		trans->readahead = malloc(READAHEADSIZE);
+		if (!trans->readahead)
+			I_Error("FileSendTicker: No more memory\n");
+	}
+	else // Sending RAM
+		trans->currentfile = (FILE *)1; // Set currentfile to a non-null value to indicate that it is open
+
+	// A snapshot's size only goes down once it's done
+	trans->fragments = calloc(f->size / FILEFRAGMENTSIZE + 1, sizeof (*trans->fragments));
+	trans->sent = malloc(SENTQUEUESIZE * sizeof (*trans->sent));
+	trans->lost = malloc(SENTQUEUESIZE * sizeof (*trans->lost));
+	if (!trans->fragments || !trans->sent || !trans->lost)
+		I_Error("FileSendTicker: No more memory\n");
+
+	trans->numfragments = (f->size + FILEFRAGMENTSIZE - 1) / FILEFRAGMENTSIZE;
+	trans->sizefinal = (f->ram != SF_SNAPSHOT);
+
+	trans->window = FILEWINDOWINIT;
+	trans->threshold = FILEWINDOWMAX;
+	trans->rto = FILERTOINIT;
+	trans->ratestart = I_GetTime();
+}
+
+// Snapshots can only be sent as far as they've been compressed
+static void UpdateSnapshotSize(filetran_t *trans)
+{
+	filetx_t *f = trans->txlist;
+	boolean done;
+	UINT32 ready = SV_SnapshotReadySize(f->id.snapshot, &done);
+
+	if (done)
+	{
+		// Compressed at last, so now we know how big it is
+		f->size = ready;
+		trans->numfragments = (ready + FILEFRAGMENTSIZE - 1) / FILEFRAGMENTSIZE;
+		trans->sizefinal = true;
+	}
+	else
+		trans->numfragments = ready / FILEFRAGMENTSIZE;
+}
+
+// Gives up on fragments that took too long to be acknowledged,
+// or that fragments sent after them were acknowledged before
+static void FindLostFragments(filetran_t *trans)
+{
+	const precise_t now = I_GetPreciseTime();
+
+	while (trans->senthead != trans->senttail)
+	{
+		const UINT32 fragment = trans->sent[trans->senthead % SENTQUEUESIZE].fragment;
+		const UINT32 seq = trans->sent[trans->senthead % SENTQUEUESIZE].seq;
+		fragmentstate_t *frag = &trans->fragments[fragment];
+		boolean timedout;
+
+		// Acknowledged, or sent again since
+		if (!(frag->flags & FRAG_INFLIGHT) || frag->seq != seq)
+		{
+			trans->senthead++;
+			continue;
+		}
+
+		timedout = (I_PreciseToMicros(now - frag->senttime) > trans->rto);
+		if (!timedout && seq + FILEREORDER > trans->highestackedseq)
+			break; // Everything after was sent later
+
+		frag->flags = (frag->flags & ~FRAG_INFLIGHT) | FRAG_LOST;
+		trans->inflight--;
+		trans->lost[trans->losttail++ % SENTQUEUESIZE] = fragment;
+		trans->senthead++;
+
+		// Only back off once for all the fragments lost from a window
+		if (seq >= trans->recoveryseq)
+		{
+			trans->threshold = max(trans->window / 2, FILEWINDOWMIN);
+			trans->window = trans->threshold;
+			trans->recoveryseq = trans->sendseq + 1;
+			if (timedout)
+				trans->rto = min(trans->rto * 2, FILERTOMAX);
+		}
+	}
+}
+
+static void ReadFragment(filetran_t *trans, UINT32 position, UINT8 *dest, size_t size)
+{
+	filetx_t *f = trans->txlist;
+
+	if (f->ram == SF_SNAPSHOT)
+		M_Memcpy(dest, SV_SnapshotData(f->id.snapshot) + position, size);
+	else if (f->ram == SF_CACHE)
+		ReadSendCache(f->id.cache, position, dest, size);
+	else if (f->ram)
+		M_Memcpy(dest, &f->id.ram[position], size);
+	else
+	{
+		// Refill the read-ahead buffer from here if it doesn't have it
+		if (position < trans->readaheadpos || position + size > trans->readaheadpos + trans->readaheadlen)
+		{
+			const size_t toread = min(READAHEADSIZE, f->size - position);
+
+			fseek(trans->currentfile, position, SEEK_SET);
+			if (fread(trans->readahead, 1, toread, trans->currentfile) != toread)
+				I_Error("FileSendTicker: can't read %s byte on %s at %d because %s", sizeu1(toread), f->id.filename, position, M_FileError(trans->currentfile));
+
+			trans->readaheadpos = position;
+			trans->readaheadlen = (UINT32)toread;
+		}
+
+		M_Memcpy(dest, trans->readahead + (position - trans->readaheadpos), size);
+	}
+}
+
+/** Sends a node the next fragment its window has room for
+  *
+  * \param node The node to send a fragment to
+  * \return 1 if a fragment was sent, 0 if there's nothing to send
+  *         right now, and -1 if sending failed
+  *
+  */
+static INT32 SendNextFragment(INT32 node)
+{
+	filetran_t *trans = &transfer[node];
+	filetx_t *f = trans->txlist;
+	filetx_pak *p = &netbuffer->u.filetxpak;
+	fragmentstate_t *frag;
+	boolean resend;
+	UINT32 fragment, position;
+	size_t fragmentsize;
+
+	// Open the file if it isn't open yet
+	if (!trans->currentfile)
+		OpenTransfer(node);
+
+	if (!trans->sizefinal)
+		UpdateSnapshotSize(trans);
+
+	FindLostFragments(trans);
+
+	if (trans->inflight >= (UINT32)trans->window
+		|| trans->senttail - trans->senthead >= SENTQUEUESIZE)
+		return 0;
+
+	// Lost fragments go first
+	while (trans->losthead != trans->losttail
+		&& (trans->fragments[trans->lost[trans->losthead % SENTQUEUESIZE]].flags & FRAG_ACKED))
+		trans->losthead++;
+
+	resend = (trans->losthead != trans->losttail);
+	if (resend)
+		fragment = trans->lost[trans->losthead % SENTQUEUESIZE];
+	else if (trans->nextfragment < trans->numfragments)
+		fragment = trans->nextfragment;
+	else
+		return 0;
+
+	// Build a packet containing a file fragment
+	position = fragment * FILEFRAGMENTSIZE;
+	fragmentsize = min(FILEFRAGMENTSIZE, f->size - position);
+	frag = &trans->fragments[fragment];
+
+	ReadFragment(trans, position, p->data, fragmentsize);
+
+	netbuffer->packettype = PT_FILEFRAGMENT;
+	p->iteration = (UINT8)(frag->sends + 1);
+	p->position = LONG(position);
+	p->fileid = f->fileid;
+	p->filesize = LONG(f->size);
+	if (!trans->sizefinal)
+		p->filesize = LONG(f->size | FILETX_SIZEPENDING);
+	p->size = SHORT((UINT16)FILEFRAGMENTSIZE);
+
+	// Send the packet
+	if (!HSendPacket(node, false, 0, FILETXHEADER + fragmentsize)) // Don't use the default acknowledgement system
+		return -1; // Not sent for some odd reason, retry at next call
+
+	if (resend)
+		trans->losthead++;
+	else
+		trans->nextfragment++;
+
+	frag->flags = FRAG_INFLIGHT;
+	frag->seq = ++trans->sendseq;
+	frag->senttime = I_GetPreciseTime();
+	if (frag->sends < UINT8_MAX)
+		frag->sends++;
+
+	trans->sent[trans->senttail % SENTQUEUESIZE].fragment = fragment;
+	trans->sent[trans->senttail % SENTQUEUESIZE].seq = frag->seq;
+	trans->senttail++;
+	trans->inflight++;
+
+	return 1;
+}
+
 /** Handles file transmission
+  *
+  * Each node gets as many fragments in flight as its congestion window
+  * allows, with cv_downloadspeed capping how many go out per call.
   *
   */
 void FileSendTicker(void)
 {
 	static INT32 currentnode = 0;
-	filetx_pak *p;
-	size_t fragmentsize;
-	filetx_t *f;
-	INT32 packetsent, ram, i, j;
+	INT32 packetsent, i, j;
 
 	// If someone is taking too long to download, kick them with a timeout
 	// to prevent blocking the rest of the server...
@@ -1044,125 +1540,92 @@ void FileSendTicker(void)
 
 	packetsent = cv_downloadspeed.value;
 
-	netbuffer->packettype = PT_FILEFRAGMENT;
-
-	// (((sendbytes-nowsentbyte)*TICRATE)/(I_GetTime()-starttime)<(UINT32)net_bandwidth)
-	while (packetsent-- && filestosend != 0)
+	// Go round the nodes a fragment at a time, until
+	// out of packets or every window is full
+	while (packetsent > 0)
 	{
-		for (i = currentnode, j = 0; j < MAXNETNODES;
-			i = (i+1) % MAXNETNODES, j++)
-		{
-			if (transfer[i].txlist)
-				break;
-		}
-		// no transfer to do
-		if (j >= MAXNETNODES)
-			I_Error("filestosend=%d but no file to send found\n", filestosend);
+		boolean sentany = false;
 
-		currentnode = (i+1) % MAXNETNODES;
-		f = transfer[i].txlist;
-		ram = f->ram;
-
-		// Open the file if it isn't open yet, or
-		if (!transfer[i].currentfile)
+		for (j = 0; j < MAXNETNODES && packetsent > 0; j++)
 		{
-			if (!ram) // Sending a file
-			{
-				long filesize;
+			INT32 sent;
 
-				transfer[i].currentfile =
-					fopen(f->id.filename, "rb");
+			i = currentnode;
+			currentnode = (currentnode + 1) % MAXNETNODES;
 
-				if (!transfer[i].currentfile)
-					I_Error("File %s does not exist",
-						f->id.filename);
+			if (!transfer[i].txlist)
+				continue;
 
-				fseek(transfer[i].currentfile, 0, SEEK_END);
-				filesize = ftell(transfer[i].currentfile);
+			sent = SendNextFragment(i);
+			if (sent < 0)
+				return; // Can't send this one so why should i send the next?
+			if (sent)
+			{
+				sentany = true;
+				packetsent--;
+			}
+		}
 
-				// Nobody wants to transfer a file bigger
-				// than 4GB!
-				if (filesize >= LONG_MAX)
-					I_Error("filesize of %s is too large", f->id.filename);
-				if (filesize == -1)
-					I_Error("Error getting filesize of %s", f->id.filename);
+		if (!sentany)
+			break;
+	}
+}
 
-				f->size = (UINT32)filesize;
-				fseek(transfer[i].currentfile, 0, SEEK_SET);
-			}
-			else // Sending RAM
-				transfer[i].currentfile = (FILE *)1; // Set currentfile to a non-null value to indicate that it is open
+static void SampleRoundTrip(filetran_t *trans, INT32 rtt)
+{
+	rtt = max(rtt, 1);
 
-			transfer[i].iteration = 1;
-			transfer[i].ackediteration = 0;
-			transfer[i].position = 0;
-			transfer[i].ackedsize = 0;
+	if (!trans->srtt)
+	{
+		trans->srtt = rtt;
+		trans->rttvar = rtt / 2;
+	}
+	else
+	{
+		trans->rttvar = (3 * trans->rttvar + abs(trans->srtt - rtt)) / 4;
+		trans->srtt = (7 * trans->srtt + rtt) / 8;
+	}
 
-			transfer[i].ackedfragments = calloc(f->size / FILEFRAGMENTSIZE + 1, sizeof(*transfer[i].ackedfragments));
-			if (!transfer[i].ackedfragments)
-				I_Error("FileSendTicker: No more memory\n");
+	trans->rto = min(max(trans->srtt + 4 * trans->rttvar, FILERTOMIN), FILERTOMAX);
+}
 
-			transfer[i].dontsenduntil = 0;
-		}
+static void AckFragment(filetran_t *trans, UINT32 fragment)
+{
+	fragmentstate_t *frag = &trans->fragments[fragment];
+	tic_t now;
 
-		// If the client hasn't acknowledged any fragment from the previous iteration,
-		// it is most likely because their acks haven't had enough time to reach the server
-		// yet, due to latency. In that case, we wait a little to avoid useless resend.
-		if (I_GetTime() < transfer[i].dontsenduntil)
-			continue;
+	if (frag->flags & FRAG_ACKED)
+		return;
 
-		// Find the first non-acknowledged fragment
-		while (transfer[i].ackedfragments[transfer[i].position / FILEFRAGMENTSIZE])
-		{
-			transfer[i].position += FILEFRAGMENTSIZE;
-			if (transfer[i].position >= f->size)
-			{
-				if (transfer[i].ackediteration < transfer[i].iteration)
-					transfer[i].dontsenduntil = I_GetTime() + TICRATE / 2;
+	if (frag->flags & FRAG_INFLIGHT)
+	{
+		trans->inflight--;
 
-				transfer[i].position = 0;
-				transfer[i].iteration++;
-			}
-		}
+		// Resent fragments can't tell which send was acknowledged
+		if (frag->sends == 1)
+			SampleRoundTrip(trans, I_PreciseToMicros(I_GetPreciseTime() - frag->senttime));
 
-		// Build a packet containing a file fragment
-		p = &netbuffer->u.filetxpak;
-		fragmentsize = FILEFRAGMENTSIZE;
-		if (f->size-transfer[i].position < fragmentsize)
-			fragmentsize = f->size-transfer[i].position;
-		if (ram)
-			M_Memcpy(p->data, &f->id.ram[transfer[i].position], fragmentsize);
+		if (trans->window < trans->threshold)
+			trans->window += 1;
 		else
-		{
-			fseek(transfer[i].currentfile, transfer[i].position, SEEK_SET);
+			trans->window += 1 / trans->window;
+		trans->window = min(trans->window, FILEWINDOWMAX);
+	}
 
-			if (fread(p->data, 1, fragmentsize, transfer[i].currentfile) != fragmentsize)
-				I_Error("FileSendTicker: can't read %s byte on %s at %d because %s", sizeu1(fragmentsize), f->id.filename, transfer[i].position, M_FileError(transfer[i].currentfile));
-		}
-		p->iteration = transfer[i].iteration;
-		p->position = LONG(transfer[i].position);
-		p->fileid = f->fileid;
-		p->filesize = LONG(f->size);
-		p->size = SHORT((UINT16)FILEFRAGMENTSIZE);
-
-		// Send the packet
-		if (HSendPacket(i, false, 0, FILETXHEADER + fragmentsize)) // Don't use the default acknowledgement system
-		{ // Success
-			transfer[i].position = (UINT32)(transfer[i].position + fragmentsize);
-			if (transfer[i].position >= f->size)
-			{
-				if (transfer[i].ackediteration < transfer[i].iteration)
-					transfer[i].dontsenduntil = I_GetTime() + TICRATE / 2;
+	if (frag->seq > trans->highestackedseq)
+		trans->highestackedseq = frag->seq;
 
-				transfer[i].position = 0;
-				transfer[i].iteration++;
-			}
-		}
-		else
-		{ // Not sent for some odd reason, retry at next call
-			// Exit the while (can't send this one so why should i send the next?)
-			break;
-		}
+	frag->flags = FRAG_ACKED;
+	trans->numacked++;
+	trans->ackedsize += FILEFRAGMENTSIZE;
+
+	trans->ratebytes += FILEFRAGMENTSIZE;
+	now = I_GetTime();
+	if (now - trans->ratestart >= TICRATE)
+	{
+		trans->rate = trans->ratebytes * TICRATE / (now - trans->ratestart);
+		trans->ratebytes = 0;
+		trans->ratestart = now;
 	}
 }
 
@@ -1174,7 +1637,7 @@ void PT_FileAck(void)
 	INT32 i, j;
 
 	// Wrong file id? Ignore it, it's probably a late packet
-	if (!(trans->txlist && packet->fileid == trans->txlist->fileid))
+	if (!(trans->txlist && trans->fragments && packet->fileid == trans->txlist->fileid))
 		return;
 
 	if (packet->numsegments * sizeof(*packet->segments) != doomcom->datalength - BASEPACKETSIZE - sizeof(*packet))
@@ -1183,13 +1646,6 @@ void PT_FileAck(void)
 		return;
 	}
 
-	if (packet->iteration > trans->ackediteration)
-	{
-		trans->ackediteration = packet->iteration;
-		if (trans->ackediteration >= trans->iteration - 1)
-			trans->dontsenduntil = 0;
-	}
-
 	for (i = 0; i < packet->numsegments; i++)
 	{
 		fileacksegment_t *segment = &packet->segments[i];
@@ -1197,26 +1653,21 @@ void PT_FileAck(void)
 		for (j = 0; j < 32; j++)
 			if (LONG(segment->acks) & (1 << j))
 			{
-				if (LONG(segment->start) * FILEFRAGMENTSIZE >= trans->txlist->size)
+				const UINT32 fragment = LONG(segment->start) + j;
+
+				if ((UINT64)fragment * FILEFRAGMENTSIZE >= trans->txlist->size)
 				{
 					Net_CloseConnection(node);
 					return;
 				}
 
-				if (!trans->ackedfragments[LONG(segment->start) + j])
-				{
-					trans->ackedfragments[LONG(segment->start) + j] = true;
-					trans->ackedsize += FILEFRAGMENTSIZE;
-
-					// If the last missing fragment was acked, finish!
-					if (trans->ackedsize == trans->txlist->size)
-					{
-						SV_EndFileSend(node);
-						return;
-					}
-				}
+				AckFragment(trans, fragment);
 			}
 	}
+
+	// If the last missing fragment was acked, finish!
+	if (trans->sizefinal && trans->numacked == trans->numfragments)
+		SV_EndFileSend(node);
 }
 
 void PT_FileReceived(void)
@@ -1274,9 +1725,22 @@ static void AddFragmentToAckPacket(fileack_pak *packet, UINT8 iteration, UINT32
 	segment->acks |= 1 << (fragmentpos - segment->start);
 }
 
+UINT32 CL_GetDownloadRate(void)
+{
+	return downloadrate;
+}
+
 void FileReceiveTicker(void)
 {
 	INT32 i;
+	tic_t now = I_GetTime();
+
+	if (now - downloadratestart >= TICRATE)
+	{
+		downloadrate = downloadratebytes * TICRATE / (now - downloadratestart);
+		downloadratebytes = 0;
+		downloadratestart = now;
+	}
 
 	for (i = 0; i < fileneedednum; i++)
 	{
@@ -1310,6 +1774,49 @@ void FileReceiveTicker(void)
 	}
 }
 
+// Where a download with this MD5 is kept: files in the cache are only
+// ever put there once their MD5 is checked, so they're named after it.
+// Returns false if the path doesn't fit in len.
+static boolean CL_DownloadCachePath(char *path, size_t len, const UINT8 *md5sum, const char *filename)
+{
+	char hex[33];
+	INT32 i, written;
+
+	for (i = 0; i < 16; i++)
+		sprintf(&hex[i*2], "%02x", md5sum[i]);
+
+	written = snprintf(path, len, "%s" PATHSEP "cache" PATHSEP "%s" PATHSEP "%s",
+		downloaddir, hex, &filename[strlen(filename) - nameonlylength(filename)]);
+	return written >= 0 && (size_t)written < len;
+}
+
+// Checks a finished download, and moves it into the download cache
+static filestatus_t CL_StoreDownload(fileneeded_t *file)
+{
+	char path[MAX_WADPATH];
+
+	if (checkfilemd5(file->filename, file->md5sum) != FS_FOUND)
+	{
+		remove(file->filename);
+		return FS_MD5SUMBAD;
+	}
+
+	// Keep it where it is if its place in the cache is too long a path
+	if (!CL_DownloadCachePath(path, sizeof path, file->md5sum, file->filename))
+		return FS_FOUND;
+
+	I_mkdir(va("%s" PATHSEP "cache", downloaddir), 0755);
+	*strrchr(path, PATHSEP[0]) = '\0';
+	I_mkdir(path, 0755);
+	CL_DownloadCachePath(path, sizeof path, file->md5sum, file->filename);
+
+	// Keep it where it is if it can't be moved
+	if (!rename(file->filename, path))
+		strlcpy(file->filename, path, MAX_WADPATH);
+
+	return FS_FOUND;
+}
+
 void PT_FileFragment(void)
 {
 	INT32 filenum = netbuffer->u.filetxpak.fileid;
@@ -1367,6 +1874,7 @@ void PT_FileFragment(void)
 
 			CONS_Printf("Resuming download...\n");
 			file->currentsize = pauseddownload->currentsize;
+			file->sizepending = false;
 			file->receivedfragments = pauseddownload->receivedfragments;
 			file->ackresendposition = 0;
 
@@ -1384,7 +1892,8 @@ void PT_FileFragment(void)
 			CONS_Printf("\r%s...\n",filename);
 
 			file->currentsize = 0;
-			file->totalsize = LONG(netbuffer->u.filetxpak.filesize);
+			file->totalsize = LONG(netbuffer->u.filetxpak.filesize) & ~FILETX_SIZEPENDING;
+			file->sizepending = (LONG(netbuffer->u.filetxpak.filesize) & FILETX_SIZEPENDING) != 0;
 			file->ackresendposition = UINT32_MAX; // Only used for resumed downloads
 
 			file->receivedfragments = calloc(file->totalsize / fragmentsize + 1, sizeof(*file->receivedfragments));
@@ -1397,6 +1906,17 @@ void PT_FileFragment(void)
 
 	if (file->status == FS_DOWNLOADING)
 	{
+		UINT32 filesize = LONG(netbuffer->u.filetxpak.filesize);
+
+		// The sender knows how big the file is now
+		if (file->sizepending && !(filesize & FILETX_SIZEPENDING))
+		{
+			if (filesize > file->totalsize)
+				I_Error("Invalid file fragment\n");
+			file->totalsize = filesize;
+			file->sizepending = false;
+		}
+
 		if (fragmentpos >= file->totalsize)
 			I_Error("Invalid file fragment\n");
 
@@ -1411,17 +1931,18 @@ void PT_FileFragment(void)
 			if (fragmentsize && fwrite(netbuffer->u.filetxpak.data, boundedfragmentsize, 1, file->file) != 1)
 				I_Error("Can't write to %s: %s\n",filename, M_FileError(file->file));
 			file->currentsize += boundedfragmentsize;
+			downloadratebytes += boundedfragmentsize;
 
 			AddFragmentToAckPacket(file->ackpacket, file->iteration, fragmentpos / fragmentsize, filenum);
 
 			// Finished?
-			if (file->currentsize == file->totalsize)
+			if (!file->sizepending && file->currentsize == file->totalsize)
 			{
 				fclose(file->file);
 				file->file = NULL;
 				free(file->receivedfragments);
 				free(file->ackpacket);
-				file->status = FS_FOUND;
+				file->status = (file->type == FILENEEDED_WAD) ? CL_StoreDownload(file) : FS_FOUND;
 				file->justdownloaded = true;
 				CONS_Printf(M_GetText("Downloading %s...(done)\n"),
 					filename);
@@ -1546,10 +2067,11 @@ void Command_Downloads_f(void)
 
 	for (node = 0; node < MAXNETNODES; node++)
 		if (transfer[node].txlist
-		&& transfer[node].txlist->ram == SF_FILE) // Node is downloading a file?
+		&& (transfer[node].txlist->ram == SF_FILE || transfer[node].txlist->ram == SF_CACHE)) // Node is downloading a file?
 		{
-			const char *name = transfer[node].txlist->id.filename;
-			UINT32 position = transfer[node].ackedsize;
+			const char *name = (transfer[node].txlist->ram == SF_CACHE)
+				? transfer[node].txlist->id.cache->filename : transfer[node].txlist->id.filename;
+			UINT32 position = min(transfer[node].ackedsize, transfer[node].txlist->size);
 			UINT32 size = transfer[node].txlist->size;
 			char ratecolor;
 
@@ -1570,6 +2092,8 @@ void Command_Downloads_f(void)
 			CONS_Printf("%2d  %c%s  ", node, ratecolor, name); // Node and file name
 			CONS_Printf("\x80%uK\x84/\x80%uK ", position / 1024, size / 1024); // Progress in kB
 			CONS_Printf("\x80(%c%u%%\x80)  ", ratecolor, (UINT32)(100.0 * position / size)); // Progress in %
+			CONS_Printf("%uK/s, %dms, %d in flight  ", transfer[node].rate / 1024,
+				transfer[node].srtt / 1000, transfer[node].inflight); // Rate, round trip and window
 			CONS_Printf("%s\n", I_GetNodeAddress(node)); // Address and newline
 		}
 }
@@ -1617,17 +2141,13 @@ filestatus_t checkfilemd5(char *filename, const UINT8 *wantedmd5sum)
 	(void)wantedmd5sum;
 	(void)filename;
 #else
-	FILE *fhandle;
 	UINT8 md5sum[16];
 
 	if (!wantedmd5sum)
 		return FS_FOUND;
 
-	fhandle = fopen(filename, "rb");
-	if (fhandle)
+	if (M_GetFileMD5(filename, md5sum))
 	{
-		md5_stream(fhandle,md5sum);
-		fclose(fhandle);
 		if (!memcmp(wantedmd5sum, md5sum, 16))
 			return FS_FOUND;
 		return FS_MD5SUMBAD;
@@ -1646,6 +2166,26 @@ filestatus_t findfile(char *filename, const UINT8 *wantedmd5sum, boolean complet
 	filestatus_t homecheck; // store result of last file search
 	boolean badmd5 = false; // store whether md5 was bad from either of the first two searches (if nothing was found in the third)
 
+	// check the download cache first, where the MD5 cache
+	// has usually seen the file already and it's cheap to check
+	if (wantedmd5sum)
+	{
+		char cachepath[MAX_WADPATH];
+		struct stat fsstat;
+
+		if (CL_DownloadCachePath(cachepath, sizeof cachepath, wantedmd5sum, filename)
+			&& stat(cachepath, &fsstat) == 0 && !S_ISDIR(fsstat.st_mode))
+		{
+			if (checkfilemd5(cachepath, wantedmd5sum) == FS_FOUND)
+			{
+				if (completepath)
+					strcpy(filename, cachepath);
+				return FS_FOUND;
+			}
+			badmd5 = true;
+		}
+	}
+
 	// first, check SRB2's "home" directory
 	homecheck = filesearch(filename, srb2home, wantedmd5sum, completepath, 10);
 
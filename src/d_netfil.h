@@ -16,13 +16,16 @@
 #include "d_net.h"
 #include "d_clisrv.h"
 #include "w_wad.h"
+#include "d_snapshot.h"
 
 typedef enum
 {
 	SF_FILE,
 	SF_Z_RAM,
 	SF_RAM,
-	SF_NOFREERAM
+	SF_NOFREERAM,
+	SF_SNAPSHOT, // A snapshot_t, released when we're done sending it
+	SF_CACHE // An addon in the shared send cache, released when we're done sending it
 } freemethod_t;
 
 typedef enum
@@ -61,6 +64,7 @@ typedef struct
 	fileack_pak *ackpacket;
 	UINT32 currentsize;
 	UINT32 totalsize;
+	boolean sizepending; // totalsize is only an upper bound so far
 	UINT32 ackresendposition; // Used when resuming downloads
 } fileneeded_t;
 
@@ -88,6 +92,7 @@ INT32 CL_CheckFiles(void);
 boolean CL_LoadServerFiles(void);
 void AddRamToSendQueue(INT32 node, void *data, size_t size, freemethod_t freemethod,
 	UINT8 fileid);
+void AddSnapshotToSendQueue(INT32 node, snapshot_t *snapshot, UINT8 fileid);
 
 void FileSendTicker(void);
 void PT_FileAck(void);
@@ -95,6 +100,7 @@ void PT_FileReceived(void);
 boolean SendingFile(INT32 node);
 
 void FileReceiveTicker(void);
+UINT32 CL_GetDownloadRate(void);
 void PT_FileFragment(void);
 
 boolean CL_CheckDownloadable(void);
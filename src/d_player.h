@@ -364,6 +364,8 @@ typedef struct player_s
 	fixed_t shieldscale;
 	// Focal origin above r.z
 	fixed_t viewz;
+	// viewz at the start of the tic, for interpolation
+	fixed_t old_viewz;
 	// Base height above floor for viewz.
 	fixed_t viewheight;
 	// Bob/squat speed.
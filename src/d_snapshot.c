@@ -0,0 +1,700 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2022 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  d_snapshot.c
+/// \brief Shared gamestate snapshots sent to joining nodes
+///
+///        Archiving the game for a joiner is done once per tic, and
+///        every node that needs a gamestate that tic gets the same
+///        snapshot. Compressing it is left to a thread, a chunk at a
+///        time, and the file transfer sends each chunk as it's done.
+///
+///        A snapshot is:
+///          UINT32 uncompressed length
+///          UINT8 codec (snapcodec_t)
+///          For each SNAPSHOTCHUNKSIZE bytes of it:
+///            UINT32 packed length, | SNAPSHOTCHUNK_STORED if not compressed
+///            the packed chunk
+///
+///        Deflate and zstd chunks are compressed with the uncompressed
+///        chunk before them as a dictionary, which the receiver has
+///        already unpacked by then, so splitting the archive up for
+///        streaming costs little ratio. LZF has no dictionaries.
+///
+///        Only nodes that sent NETCAP_SNAPSHOT get these. Older ones
+///        are sent the whole gamestate as one LZF block instead.
+///
+///        Snapshots stay allocated once nothing uses them anymore, so
+///        that the next join can archive into the same buffers.
+
+#ifdef HAVE_ZLIB
+#ifndef _MSC_VER
+#ifndef _LARGEFILE64_SOURCE
+#define _LARGEFILE64_SOURCE
+#endif
+#endif
+
+#ifndef _LFS64_LARGEFILE
+#define _LFS64_LARGEFILE
+#endif
+
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 0
+#endif
+
+#include <zlib.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "doomdef.h"
+#include "doomstat.h"
+#include "console.h"
+#include "command.h"
+#include "g_game.h"
+#include "i_system.h"
+#include "i_threads.h"
+#include "byteptr.h"
+#include "m_misc.h"
+#include "p_saveg.h"
+#include "z_zone.h"
+#include "lzf.h"
+
+#include "d_snapshot.h"
+
+#define SNAPSHOTHEADER (sizeof (UINT32) + 1)
+
+// How much of the previous chunk to use as a dictionary.
+// Deflate can't look further back than this anyway.
+#define SNAPSHOTDICTSIZE (32*1024)
+
+#define DEFLATELEVEL 6
+#define ZSTDLEVEL 3
+
+static CV_PossibleValue_t gamestatecodec_cons_t[] = {
+	{SNAPCODEC_AUTO, "Auto"},
+	{SNAPCODEC_LZF, "LZF"},
+	{SNAPCODEC_DEFLATE, "Deflate"},
+	{SNAPCODEC_ZSTD, "Zstd"},
+	{0, NULL}};
+consvar_t cv_gamestatecodec = CVAR_INIT ("gamestatecodec", "Auto", CV_SAVE, gamestatecodec_cons_t, NULL);
+
+static const char *snapcodecnames[NUMSNAPCODECS] = {"LZF", "Deflate", "Zstd"};
+
+// Compressor and decompressor state, kept across a snapshot's chunks
+typedef struct
+{
+	snapcodec_t codec;
+#ifdef HAVE_ZLIB
+	z_stream deflater, inflater;
+	boolean deflateready, inflateready;
+#endif
+#ifdef HAVE_ZSTD
+	ZSTD_CCtx *zstdc;
+	ZSTD_DCtx *zstdd;
+#endif
+} codecstate_t;
+
+struct snapshot_s
+{
+	// What was archived, to tell whether it can be shared
+	tic_t tic;
+	gamestate_t gamestate;
+	INT16 map;
+	boolean resending;
+	snapcodec_t codec;
+
+	UINT8 *raw; // SAVEGAMESIZE bytes
+	size_t rawlength;
+
+	UINT8 *packed;
+	size_t packedalloc;
+	UINT32 maxsize;
+
+	// Set by the compressing thread, under snapshot_mutex
+	UINT32 ready;
+	boolean done;
+
+	INT32 refcount; // transfers still sending it
+	struct snapshot_s *next;
+};
+
+static snapshot_t *snapshots = NULL; // newest first
+
+#ifdef HAVE_THREADS
+static I_mutex snapshot_mutex;
+
+#  define Lock_state()   I_lock_mutex  (&snapshot_mutex)
+#  define Unlock_state() I_unlock_mutex (snapshot_mutex)
+#else/*HAVE_THREADS*/
+#  define Lock_state()
+#  define Unlock_state()
+#endif/*HAVE_THREADS*/
+
+static void PublishProgress(snapshot_t *snapshot, UINT32 ready, boolean done)
+{
+	Lock_state();
+	{
+		snapshot->ready = ready;
+		snapshot->done = done;
+	}
+	Unlock_state();
+}
+
+UINT8 D_SnapshotCodecs(void)
+{
+	UINT8 codecs = 1<<SNAPCODEC_LZF;
+#ifdef HAVE_ZLIB
+	codecs |= 1<<SNAPCODEC_DEFLATE;
+#endif
+#ifdef HAVE_ZSTD
+	codecs |= 1<<SNAPCODEC_ZSTD;
+#endif
+	return codecs;
+}
+
+snapcodec_t SV_PickSnapshotCodec(UINT8 clientcodecs)
+{
+	const UINT8 usable = clientcodecs & D_SnapshotCodecs();
+
+	if (cv_gamestatecodec.value != SNAPCODEC_AUTO)
+		return (usable & (1<<cv_gamestatecodec.value)) ? cv_gamestatecodec.value : SNAPCODEC_LZF;
+
+	if (usable & (1<<SNAPCODEC_ZSTD))
+		return SNAPCODEC_ZSTD;
+	if (usable & (1<<SNAPCODEC_DEFLATE))
+		return SNAPCODEC_DEFLATE;
+	return SNAPCODEC_LZF;
+}
+
+static void FreeCodecState(codecstate_t *cs)
+{
+#ifdef HAVE_ZLIB
+	if (cs->deflateready)
+		deflateEnd(&cs->deflater);
+	if (cs->inflateready)
+		inflateEnd(&cs->inflater);
+#endif
+#ifdef HAVE_ZSTD
+	ZSTD_freeCCtx(cs->zstdc);
+	ZSTD_freeDCtx(cs->zstdd);
+#endif
+	memset(cs, 0, sizeof *cs);
+}
+
+// Returns the packed length, or 0 if it didn't fit in outlen
+static size_t PackChunk(codecstate_t *cs, const UINT8 *in, size_t inlen,
+	const UINT8 *dict, size_t dictlen, UINT8 *out, size_t outlen)
+{
+	(void)dict;
+	(void)dictlen;
+
+	switch (cs->codec)
+	{
+		case SNAPCODEC_LZF:
+			return lzf_compress(in, inlen, out, outlen);
+#ifdef HAVE_ZLIB
+		case SNAPCODEC_DEFLATE:
+		{
+			z_stream *zs = &cs->deflater;
+
+			if (!cs->deflateready)
+			{
+				if (deflateInit2(zs, DEFLATELEVEL, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+					return 0;
+				cs->deflateready = true;
+			}
+			else
+				deflateReset(zs);
+
+			if (dictlen)
+				deflateSetDictionary(zs, dict, (uInt)dictlen);
+
+			zs->next_in = (Bytef *)(size_t)in; // zlib doesn't write to it
+			zs->avail_in = (uInt)inlen;
+			zs->next_out = out;
+			zs->avail_out = (uInt)outlen;
+			if (deflate(zs, Z_FINISH) != Z_STREAM_END)
+				return 0;
+			return outlen - zs->avail_out;
+		}
+#endif
+#ifdef HAVE_ZSTD
+		case SNAPCODEC_ZSTD:
+		{
+			size_t packedlen;
+
+			if (!cs->zstdc && !(cs->zstdc = ZSTD_createCCtx()))
+				return 0;
+			packedlen = ZSTD_compress_usingDict(cs->zstdc, out, outlen, in, inlen, dict, dictlen, ZSTDLEVEL);
+			return ZSTD_isError(packedlen) ? 0 : packedlen;
+		}
+#endif
+		default:
+			return 0;
+	}
+}
+
+// Returns false if the chunk didn't unpack to exactly outlen bytes
+static boolean UnpackChunk(codecstate_t *cs, const UINT8 *in, size_t inlen,
+	const UINT8 *dict, size_t dictlen, UINT8 *out, size_t outlen)
+{
+	(void)dict;
+	(void)dictlen;
+
+	switch (cs->codec)
+	{
+		case SNAPCODEC_LZF:
+			return lzf_decompress(in, inlen, out, outlen) == outlen;
+#ifdef HAVE_ZLIB
+		case SNAPCODEC_DEFLATE:
+		{
+			z_stream *zs = &cs->inflater;
+
+			if (!cs->inflateready)
+			{
+				if (inflateInit2(zs, -MAX_WBITS) != Z_OK)
+					return false;
+				cs->inflateready = true;
+			}
+			else
+				inflateReset(zs);
+
+			// Raw streams take the dictionary up front
+			if (dictlen && inflateSetDictionary(zs, dict, (uInt)dictlen) != Z_OK)
+				return false;
+
+			zs->next_in = (Bytef *)(size_t)in; // zlib doesn't write to it
+			zs->avail_in = (uInt)inlen;
+			zs->next_out = out;
+			zs->avail_out = (uInt)outlen;
+			return inflate(zs, Z_FINISH) == Z_STREAM_END && zs->avail_out == 0;
+		}
+#endif
+#ifdef HAVE_ZSTD
+		case SNAPCODEC_ZSTD:
+			if (!cs->zstdd && !(cs->zstdd = ZSTD_createDCtx()))
+				return false;
+			return ZSTD_decompress_usingDict(cs->zstdd, out, outlen, in, inlen, dict, dictlen) == outlen;
+#endif
+		default:
+			return false;
+	}
+}
+
+// Packs one chunk with its header at out, and returns the bytes written
+static size_t WriteChunk(codecstate_t *cs, const UINT8 *raw, size_t pos, size_t chunk, UINT8 *out)
+{
+	const size_t dictlen = min(pos, SNAPSHOTDICTSIZE);
+	UINT8 *header = out;
+	size_t packedlen;
+
+	out += sizeof (UINT32);
+
+	// Only keep it compressed if that made it smaller
+	packedlen = PackChunk(cs, raw + pos, chunk, raw + pos - dictlen, dictlen, out, chunk - 1);
+	if (packedlen)
+		WRITEUINT32(header, packedlen);
+	else
+	{
+		M_Memcpy(out, raw + pos, chunk);
+		packedlen = chunk;
+		WRITEUINT32(header, chunk | SNAPSHOTCHUNK_STORED);
+	}
+
+	return sizeof (UINT32) + packedlen;
+}
+
+// Unpacks every chunk after the header, and returns false if any is bad
+static boolean ReadChunks(codecstate_t *cs, UINT8 *p, const UINT8 *end, UINT8 *raw, size_t rawlength)
+{
+	size_t pos = 0;
+
+	while (pos < rawlength)
+	{
+		const size_t chunk = min(rawlength - pos, SNAPSHOTCHUNKSIZE);
+		const size_t dictlen = min(pos, SNAPSHOTDICTSIZE);
+		UINT32 header;
+		size_t packedlen;
+
+		if (end - p < (ptrdiff_t)sizeof (UINT32))
+			return false;
+
+		header = READUINT32(p);
+		packedlen = header & ~SNAPSHOTCHUNK_STORED;
+		if ((size_t)(end - p) < packedlen)
+			return false;
+
+		if (header & SNAPSHOTCHUNK_STORED)
+		{
+			if (packedlen != chunk)
+				return false;
+			M_Memcpy(raw + pos, p, chunk);
+		}
+		else if (!UnpackChunk(cs, p, packedlen, raw + pos - dictlen, dictlen, raw + pos, chunk))
+			return false;
+
+		p += packedlen;
+		pos += chunk;
+	}
+
+	return true;
+}
+
+static void CompressSnapshot(snapshot_t *snapshot)
+{
+	codecstate_t cs;
+	size_t pos = 0;
+	UINT8 *out = snapshot->packed + SNAPSHOTHEADER;
+
+	memset(&cs, 0, sizeof cs);
+	cs.codec = snapshot->codec;
+
+	while (pos < snapshot->rawlength)
+	{
+		const size_t chunk = min(snapshot->rawlength - pos, SNAPSHOTCHUNKSIZE);
+
+		out += WriteChunk(&cs, snapshot->raw, pos, chunk, out);
+		pos += chunk;
+
+		if (pos < snapshot->rawlength)
+			PublishProgress(snapshot, (UINT32)(out - snapshot->packed), false);
+
+#ifdef HAVE_THREADS
+		if (I_thread_is_stopped())
+		{
+			FreeCodecState(&cs);
+			return;
+		}
+#endif
+	}
+
+	FreeCodecState(&cs);
+	PublishProgress(snapshot, (UINT32)(out - snapshot->packed), true);
+}
+
+static boolean SnapshotIsIdle(snapshot_t *snapshot)
+{
+	boolean done;
+
+	if (snapshot->refcount)
+		return false;
+
+	Lock_state();
+	done = snapshot->done;
+	Unlock_state();
+	return done;
+}
+
+static void FreeSnapshot(snapshot_t *snapshot)
+{
+	free(snapshot->raw);
+	free(snapshot->packed);
+	free(snapshot);
+}
+
+// Frees every idle snapshot but one, which is kept for reuse,
+// and unlinks and returns that one if asked to
+static snapshot_t *TrimSnapshots(boolean take)
+{
+	snapshot_t **link = &snapshots;
+	snapshot_t *spare = NULL;
+
+	while (*link)
+	{
+		snapshot_t *snapshot = *link;
+
+		if (!SnapshotIsIdle(snapshot))
+		{
+			link = &snapshot->next;
+			continue;
+		}
+
+		if (spare)
+		{
+			*link = snapshot->next;
+			FreeSnapshot(snapshot);
+		}
+		else
+		{
+			spare = snapshot;
+			if (take)
+				*link = snapshot->next;
+			else
+				link = &snapshot->next;
+		}
+	}
+
+	return spare;
+}
+
+static snapshot_t *NewSnapshot(void)
+{
+	snapshot_t *snapshot = calloc(1, sizeof (snapshot_t));
+
+	if (!snapshot)
+		return NULL;
+
+	snapshot->raw = malloc(SAVEGAMESIZE);
+	if (!snapshot->raw)
+	{
+		free(snapshot);
+		return NULL;
+	}
+
+	return snapshot;
+}
+
+snapshot_t *SV_GetSnapshot(boolean resending, snapcodec_t codec)
+{
+	snapshot_t *snapshot = snapshots;
+	size_t length, numchunks;
+	UINT8 *p;
+
+	// Everyone joining on the same tic can share one
+	if (snapshot && snapshot->tic == gametic && snapshot->gamestate == gamestate
+		&& snapshot->map == gamemap && snapshot->resending == resending
+		&& snapshot->codec == codec)
+	{
+		snapshot->refcount++;
+		return snapshot;
+	}
+
+	snapshot = TrimSnapshots(true);
+	if (!snapshot)
+		snapshot = NewSnapshot();
+	if (!snapshot)
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
+		return NULL;
+	}
+
+	save_p = snapshot->raw;
+	P_SaveNetGame(resending);
+	length = save_p - snapshot->raw;
+	save_p = NULL;
+
+	if (length > SAVEGAMESIZE)
+		I_Error("Savegame buffer overrun");
+
+	// Stored chunks are the worst case
+	numchunks = (length + SNAPSHOTCHUNKSIZE - 1) / SNAPSHOTCHUNKSIZE;
+	snapshot->maxsize = (UINT32)(SNAPSHOTHEADER + length + numchunks * sizeof (UINT32));
+	if (snapshot->packedalloc < snapshot->maxsize)
+	{
+		free(snapshot->packed);
+		snapshot->packed = malloc(snapshot->maxsize);
+		snapshot->packedalloc = snapshot->packed ? snapshot->maxsize : 0;
+		if (!snapshot->packed)
+		{
+			FreeSnapshot(snapshot);
+			CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
+			return NULL;
+		}
+	}
+
+	snapshot->tic = gametic;
+	snapshot->gamestate = gamestate;
+	snapshot->map = gamemap;
+	snapshot->resending = resending;
+	snapshot->codec = codec;
+	snapshot->rawlength = length;
+	snapshot->refcount = 1;
+
+	p = snapshot->packed;
+	WRITEUINT32(p, length);
+	WRITEUINT8(p, codec);
+	snapshot->ready = SNAPSHOTHEADER;
+	snapshot->done = false;
+
+	snapshot->next = snapshots;
+	snapshots = snapshot;
+
+#ifdef HAVE_THREADS
+	I_spawn_thread("snapshot-compress", (I_thread_fn)CompressSnapshot, snapshot);
+#else
+	CompressSnapshot(snapshot);
+#endif
+
+	return snapshot;
+}
+
+void SV_ReleaseSnapshot(snapshot_t *snapshot)
+{
+	if (--snapshot->refcount == 0)
+		TrimSnapshots(false);
+}
+
+const UINT8 *SV_SnapshotData(snapshot_t *snapshot)
+{
+	return snapshot->packed;
+}
+
+UINT32 SV_SnapshotReadySize(snapshot_t *snapshot, boolean *done)
+{
+	UINT32 ready;
+
+	Lock_state();
+	{
+		ready = snapshot->ready;
+		*done = snapshot->done;
+	}
+	Unlock_state();
+
+	return ready;
+}
+
+UINT32 SV_SnapshotMaxSize(snapshot_t *snapshot)
+{
+	return snapshot->maxsize;
+}
+
+size_t CL_UnpackSnapshot(UINT8 *data, size_t length, UINT8 **out)
+{
+	UINT8 *p = data;
+	UINT8 *buf;
+	size_t rawlength;
+	codecstate_t cs;
+	boolean ok;
+
+	if (length < SNAPSHOTHEADER)
+		I_Error("Received gamestate is truncated");
+
+	rawlength = READUINT32(p);
+	if (rawlength > SAVEGAMESIZE)
+		I_Error("Received gamestate is too big (%s bytes)", sizeu1(rawlength));
+
+	memset(&cs, 0, sizeof cs);
+	cs.codec = READUINT8(p);
+	if (cs.codec >= NUMSNAPCODECS || !(D_SnapshotCodecs() & (1<<cs.codec)))
+		I_Error("Received gamestate is compressed in a way this build can't read");
+
+	buf = Z_Malloc(max(rawlength, 1), PU_STATIC, NULL);
+	ok = ReadChunks(&cs, p, data + length, buf, rawlength);
+	FreeCodecState(&cs);
+
+	if (!ok)
+		I_Error("Received gamestate is corrupt");
+
+	*out = buf;
+	return rawlength;
+}
+
+// gamestatebench [file] [passes]: compresses the gamestate, or a raw
+// archive from a file (such as DUMPCONSISTENCY's), with every codec
+void Command_GamestateBench_f(void)
+{
+	UINT8 *raw, *packed, *unpacked;
+	size_t rawlength, maxsize;
+	INT32 passes = 3;
+	INT32 codec, pass;
+
+	if (COM_Argc() > 1)
+	{
+		UINT8 *file;
+		rawlength = FIL_ReadFile(COM_Argv(1), &file);
+		if (!rawlength)
+		{
+			CONS_Printf(M_GetText("Can't read %s\n"), COM_Argv(1));
+			return;
+		}
+		raw = malloc(rawlength);
+		if (raw)
+			M_Memcpy(raw, file, rawlength);
+		Z_Free(file);
+	}
+	else
+	{
+		if (gamestate != GS_LEVEL)
+		{
+			CONS_Printf(M_GetText("You must be in a level or give a file to use this.\n"));
+			return;
+		}
+		raw = malloc(SAVEGAMESIZE);
+		if (raw)
+		{
+			save_p = raw;
+			P_SaveNetGame(false);
+			rawlength = save_p - raw;
+			save_p = NULL;
+			if (rawlength > SAVEGAMESIZE)
+				I_Error("Savegame buffer overrun");
+		}
+		else
+			rawlength = 0;
+	}
+
+	if (COM_Argc() > 2)
+		passes = max(atoi(COM_Argv(2)), 1);
+
+	maxsize = rawlength + (rawlength / SNAPSHOTCHUNKSIZE + 1) * sizeof (UINT32);
+	packed = malloc(maxsize);
+	unpacked = malloc(max(rawlength, 1));
+	if (!raw || !packed || !unpacked)
+	{
+		free(raw);
+		free(packed);
+		free(unpacked);
+		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
+		return;
+	}
+
+	CONS_Printf(M_GetText("Gamestate: %s bytes, %d passes\n"), sizeu1(rawlength), passes);
+	CONS_Printf("%-8s %10s %7s %12s %12s\n", "Codec", "Bytes", "Ratio", "Pack", "Unpack");
+
+	for (codec = 0; codec < NUMSNAPCODECS; codec++)
+	{
+		codecstate_t cs;
+		precise_t packtime = 0, unpacktime = 0, t;
+		size_t packedlength = 0;
+		boolean ok = true;
+
+		if (!(D_SnapshotCodecs() & (1<<codec)))
+		{
+			CONS_Printf(M_GetText("%-8s not in this build\n"), snapcodecnames[codec]);
+			continue;
+		}
+
+		memset(&cs, 0, sizeof cs);
+		cs.codec = codec;
+
+		for (pass = 0; pass < passes; pass++)
+		{
+			size_t pos;
+
+			t = I_GetPreciseTime();
+			packedlength = 0;
+			for (pos = 0; pos < rawlength; pos += SNAPSHOTCHUNKSIZE)
+				packedlength += WriteChunk(&cs, raw, pos, min(rawlength - pos, SNAPSHOTCHUNKSIZE), packed + packedlength);
+			packtime += I_GetPreciseTime() - t;
+
+			t = I_GetPreciseTime();
+			ok = ReadChunks(&cs, packed, packed + packedlength, unpacked, rawlength) && ok;
+			unpacktime += I_GetPreciseTime() - t;
+		}
+
+		FreeCodecState(&cs);
+
+		if (!ok || memcmp(raw, unpacked, rawlength))
+		{
+			CONS_Alert(CONS_WARNING, M_GetText("%s didn't unpack to the same gamestate!\n"), snapcodecnames[codec]);
+			continue;
+		}
+
+		CONS_Printf("%-8s %10s %6.2f:1 %7.1f MB/s %7.1f MB/s\n", snapcodecnames[codec],
+			sizeu1(packedlength), (double)rawlength / max(packedlength, 1),
+			(double)rawlength * passes / max(I_PreciseToMicros(packtime), 1),
+			(double)rawlength * passes / max(I_PreciseToMicros(unpacktime), 1));
+	}
+
+	free(raw);
+	free(packed);
+	free(unpacked);
+}
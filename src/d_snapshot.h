@@ -0,0 +1,68 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2022 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  d_snapshot.h
+/// \brief Shared gamestate snapshots sent to joining nodes
+
+#ifndef __D_SNAPSHOT__
+#define __D_SNAPSHOT__
+
+#include "doomtype.h"
+#include "command.h"
+
+#define SAVEGAMESIZE (768*1024)
+
+// Uncompressed bytes per chunk. Each chunk is compressed on its own,
+// so it can be sent as soon as it's done.
+#define SNAPSHOTCHUNKSIZE (32*1024)
+
+// Set in a chunk's header when the chunk is stored uncompressed
+#define SNAPSHOTCHUNK_STORED 0x80000000
+
+// How chunks are compressed, stored after the length at the start
+typedef enum
+{
+	SNAPCODEC_LZF,
+	SNAPCODEC_DEFLATE, // needs HAVE_ZLIB
+	SNAPCODEC_ZSTD, // needs HAVE_ZSTD
+	NUMSNAPCODECS
+} snapcodec_t;
+
+#define SNAPCODEC_AUTO 255 // cv_gamestatecodec: best one the client has
+
+extern consvar_t cv_gamestatecodec;
+
+typedef struct snapshot_s snapshot_t;
+
+// Bit (1 << codec) is set for each codec this build can handle
+UINT8 D_SnapshotCodecs(void);
+
+// Picks the codec to send a node's gamestate with, out of
+// the ones it said it could read (1 << codec each)
+snapcodec_t SV_PickSnapshotCodec(UINT8 clientcodecs);
+
+// Archives the game into a snapshot, or returns the one already taken
+// this tic, and holds a reference to it. Compressing it carries on in
+// the background when threads are available.
+snapshot_t *SV_GetSnapshot(boolean resending, snapcodec_t codec);
+void SV_ReleaseSnapshot(snapshot_t *snapshot);
+
+const UINT8 *SV_SnapshotData(snapshot_t *snapshot);
+
+// Bytes of compressed data ready to send so far, and whether that's
+// all of it. Until it is, the snapshot won't be bigger than maxsize.
+UINT32 SV_SnapshotReadySize(snapshot_t *snapshot, boolean *done);
+UINT32 SV_SnapshotMaxSize(snapshot_t *snapshot);
+
+// Unpacks a snapshot as received from the server into a Z_Malloc'd
+// buffer, and returns its length
+size_t CL_UnpackSnapshot(UINT8 *data, size_t length, UINT8 **out);
+
+void Command_GamestateBench_f(void);
+
+#endif // __D_SNAPSHOT__
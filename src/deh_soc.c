@@ -3555,6 +3555,7 @@ void readmaincfg(MYFILE *f)
 				{
 					lumpnum_t lumpnum;
 					char newname[9];
+					char *text;
 
 					strncpy(newname, word2, 8);
 
@@ -3565,7 +3566,11 @@ void readmaincfg(MYFILE *f)
 					if (lumpnum == LUMPERROR || W_LumpLength(lumpnum) == 0)
 						CONS_Debug(DBG_SETUP, "SOC Error: script lump %s not found/not valid.\n", newname);
 					else
-						COM_BufInsertText(W_CacheLumpNum(lumpnum, PU_CACHE));
+					{
+						text = W_CacheTextLump(lumpnum, PU_STATIC);
+						COM_BufInsertText(text);
+						Z_Free(text);
+					}
 				}
 			}
 
@@ -249,9 +249,13 @@ extern char logfilename[1024];
 // =========================================================================
 
 // The maximum number of players, multiplayer/networking.
-// NOTE: it needs more than this to increase the number of players...
-
+// Builds for more than 32 players speak their own protocol, see PACKETVERSION.
+#ifndef MAXPLAYERS
 #define MAXPLAYERS 32
+#endif
+#if MAXPLAYERS != 32 && MAXPLAYERS != 64 && MAXPLAYERS != 128
+#error MAXPLAYERS must be 32, 64 or 128
+#endif
 #define MAXSKINS 32
 #define PLAYERSMASK (MAXPLAYERS-1)
 #define MAXPLAYERNAME 21
@@ -703,6 +707,16 @@ extern const char *compdate, *comptime, *comprevision, *compbranch;
 /// Maintain compatibility with older 2.2 demos
 #define OLD22DEMOCOMPAT
 
+/// Software renderer drawing with several threads, see r_threads.c
+/// \note	The column/span drawer state is kept per thread, so this needs native
+///      	thread-local storage, and the assembly drawers can't use it.
+#if defined (HAVE_THREADS) && !defined (USEASM) && defined (ATTRTHREADLOCAL)
+#define RENDERTHREADS
+#define RENDERLOCAL ATTRTHREADLOCAL
+#else
+#define RENDERLOCAL
+#endif
+
 #if defined (HAVE_CURL) && ! defined (NONET)
 #define MASTERSERVER
 #else
@@ -245,6 +245,7 @@ size_t strlcpy(char *dst, const char *src, size_t siz);
 		#define FUNCDEAD __attribute__ ((deprecated))
 		#define FUNCINLINE __attribute__((always_inline))
 		#define FUNCNONNULL __attribute__((nonnull))
+		#define PREFETCH(x) __builtin_prefetch(x)
 	#endif
 
 	#define FUNCNOINLINE __attribute__((noinline))
@@ -262,12 +263,18 @@ size_t strlcpy(char *dst, const char *src, size_t siz);
 	#endif
 
 	#define ATTRUNUSED __attribute__((unused))
+
+	// Only where thread-local storage is native; emulated TLS costs a call per access
+	#if !defined (__MINGW32__) && !defined (__ANDROID__)
+		#define ATTRTHREADLOCAL __thread
+	#endif
 #elif defined (_MSC_VER)
 	#define ATTRNORETURN __declspec(noreturn)
 	#define ATTRINLINE __forceinline
 	#if _MSC_VER > 1200 // >= MSVC 6.0
 		#define ATTRNOINLINE __declspec(noinline)
 	#endif
+	#define ATTRTHREADLOCAL __declspec(thread)
 #endif
 
 #ifndef FUNCPRINTF
@@ -315,6 +322,9 @@ size_t strlcpy(char *dst, const char *src, size_t siz);
 #ifndef ATTRNOINLINE
 #define ATTRNOINLINE
 #endif
+#ifndef PREFETCH
+#define PREFETCH(x) (void)0
+#endif
 
 /* Miscellaneous types that don't fit anywhere else (Can this be changed?) */
 
@@ -16,6 +16,11 @@ tic_t I_GetTime(void)
 	return 0;
 }
 
+fixed_t I_GetTimeFrac(void)
+{
+	return 0;
+}
+
 int I_GetTimeMicros(void)
 {
 	return 0;
@@ -437,12 +437,13 @@ void HU_AddChatText(const char *text, boolean playsound)
 #ifndef NONET
 
 /** Runs a say command, sending an ::XD_SAY message.
-  * A say command consists of a signed 8-bit integer for the target, an
+  * A say command consists of an 8-bit integer for the target, an
   * unsigned 8-bit flag variable, and then the message itself.
   *
-  * The target is 0 to say to everyone, 1 to 32 to say to that player, or -1
-  * to -32 to say to everyone on that player's team. Note: This means you
-  * have to add 1 to the player number, since they are 0 to 31 internally.
+  * The target is 0 to say to everyone, 1 to MAXPLAYERS to say to that
+  * player, or -1 (sent as 255) to say to everyone on your team. Note: This
+  * means you have to add 1 to the player number, since they are 0 to
+  * MAXPLAYERS-1 internally.
   *
   * The flag HU_SERVER_SAY will be set if it is the dedicated server speaking.
   *
@@ -456,7 +457,7 @@ void HU_AddChatText(const char *text, boolean playsound)
   */
 
 
-static void DoSayCommand(SINT8 target, size_t usedargs, UINT8 flags)
+static void DoSayCommand(INT32 target, size_t usedargs, UINT8 flags)
 {
 	char buf[2 + HU_MAXMSGLEN + 1];
 	size_t numwords, ix;
@@ -481,7 +482,7 @@ static void DoSayCommand(SINT8 target, size_t usedargs, UINT8 flags)
 	if(dedicated && !(flags & HU_CSAY))
 		flags |= HU_SERVER_SAY;
 
-	buf[0] = target;
+	buf[0] = (char)target;
 	buf[1] = flags;
 	msg[0] = '\0';
 
@@ -532,7 +533,7 @@ static void DoSayCommand(SINT8 target, size_t usedargs, UINT8 flags)
 			HU_AddChatText(va("\x82NOTICE: \x80Player %d does not exist.", target), false); // same
 			return;
 		}
-		buf[0] = target;
+		buf[0] = (char)target;
 		newmsg = msg+5+spc;
 		strlcpy(msg, newmsg, HU_MAXMSGLEN + 1);
 	}
@@ -577,7 +578,7 @@ static void Command_Sayto_f(void)
 	}
 	target++; // Internally we use 0 to 31, but say command uses 1 to 32.
 
-	DoSayCommand((SINT8)target, 2, 0);
+	DoSayCommand(target, 2, 0);
 }
 
 /** Send a message to members of the player's team.
@@ -628,7 +629,7 @@ static tic_t stop_spamming[MAXPLAYERS];
   */
 static void Got_Saycmd(UINT8 **p, INT32 playernum)
 {
-	SINT8 target;
+	INT32 target;
 	UINT8 flags;
 	const char *dispname;
 	char *msg;
@@ -638,11 +639,22 @@ static void Got_Saycmd(UINT8 **p, INT32 playernum)
 
 	CONS_Debug(DBG_NETPLAY,"Received SAY cmd from Player %d (%s)\n", playernum+1, player_names[playernum]);
 
-	target = READSINT8(*p);
+	// Read unsigned, so that targets past 127 in bigger builds fit
+	target = READUINT8(*p);
+	if (target == UINT8_MAX)
+		target = -1;
 	flags = READUINT8(*p);
 	msg = (char *)*p;
 	SKIPSTRINGL(*p, HU_MAXMSGLEN + 1);
 
+	if (target > MAXPLAYERS)
+	{
+		CONS_Alert(CONS_WARNING, M_GetText("Illegal say command received from %s with an invalid target\n"), player_names[playernum]);
+		if (server)
+			SendKick(playernum, KICK_MSG_CON_FAIL | KICK_MSG_KEEP_BODY);
+		return;
+	}
+
 	if ((cv_mute.value || flags & (HU_CSAY|HU_SERVER_SAY)) && playernum != serverplayer && !(IsPlayerAdmin(playernum)))
 	{
 		CONS_Alert(CONS_WARNING, cv_mute.value ?
@@ -87,6 +87,11 @@ extern doomcom_t *doomcom;
 */
 extern boolean (*I_NetGet)(void);
 
+/**	\brief when the packet I_NetGet returned came in, set by drivers
+	that timestamp packets as they arrive, 0 otherwise
+*/
+extern precise_t netpacketarrival;
+
 /**	\brief ask to driver if there is data waiting
 */
 extern boolean (*I_NetCanGet)(void);
@@ -95,6 +100,11 @@ extern boolean (*I_NetCanGet)(void);
 */
 extern void (*I_NetSend)(void);
 
+/**	\brief send anything the driver held back to send all at once,
+	called at the end of each NetUpdate, may be NULL
+*/
+extern void (*I_NetFlush)(void);
+
 /**	\brief ask to driver if all is ok to send data now
 */
 extern boolean (*I_NetCanSend)(void);
@@ -117,7 +127,7 @@ extern void (*I_NetFreeNodenum)(INT32 nodenum);
 
 
 */
-extern SINT8 I_NetMakeNode(const char *address);
+extern INT16 I_NetMakeNode(const char *address);
 
 /**	\brief	open a connection with specified address and port
 
@@ -129,7 +139,7 @@ extern SINT8 I_NetMakeNode(const char *address);
 
 
 */
-extern SINT8 (*I_NetMakeNodewPort)(const char *address, const char *port);
+extern INT16 (*I_NetMakeNodewPort)(const char *address, const char *port);
 
 /**	\brief open connection
 */
@@ -66,6 +66,10 @@ UINT32 I_GetFreeMem(UINT32 *total);
 */
 tic_t I_GetTime(void);
 
+/**	\brief  Returns how far along the current tic is, from 0 to FRACUNIT.
+*/
+fixed_t I_GetTimeFrac(void);
+
 /**	\brief	Returns precise time value for performance measurement.
   */
 precise_t I_GetPreciseTime(void);
@@ -12,6 +12,14 @@
 ///        This is not really OS-dependent because all OSes have the same socket API.
 ///        Just use ifdef for OS-dependent parts.
 
+#if defined (__linux__) && !defined (__ANDROID__) && !defined (NONET)
+	// Batched UDP I/O with recvmmsg and sendmmsg
+	#define HAVE_MMSG
+	#ifndef _GNU_SOURCE
+		#define _GNU_SOURCE
+	#endif
+#endif
+
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -137,6 +145,7 @@
 #include "d_netfil.h"
 #include "i_tcp.h"
 #include "m_argv.h"
+#include "i_threads.h"
 
 #include "doomstat.h"
 
@@ -427,13 +436,95 @@ static boolean SOCK_cmpaddr(mysockaddr_t *a, mysockaddr_t *b, UINT8 mask)
 			&& (b->ip4.sin_port == 0 || (a->ip4.sin_port == b->ip4.sin_port));
 #ifdef HAVE_IPV6
 	else if (b->any.sa_family == AF_INET6)
-		return memcmp(&a->ip6.sin6_addr, &b->ip6.sin6_addr, sizeof(b->ip6.sin6_addr))
+		return !memcmp(&a->ip6.sin6_addr, &b->ip6.sin6_addr, sizeof(b->ip6.sin6_addr))
 			&& (b->ip6.sin6_port == 0 || (a->ip6.sin6_port == b->ip6.sin6_port));
 #endif
 	else
 		return false;
 }
 
+// Nodes by address, so packets can be matched to their node without
+// comparing against every node. Ports aren't hashed, since a node's
+// port can be left as 0 to take packets from any port.
+#define NODEHASHBITS 8
+#define NODEHASHSIZE (1<<NODEHASHBITS)
+
+static INT16 nodehash[NODEHASHSIZE]; // first node in each bucket, 0 for none
+static INT16 nodehashnext[MAXNETNODES+1];
+static UINT16 nodehashbucket[MAXNETNODES+1]; // bucket + 1, 0 if not hashed
+
+static UINT32 SOCK_HashAddr(mysockaddr_t *sk)
+{
+	UINT32 hash;
+
+	if (sk->any.sa_family == AF_INET)
+		hash = sk->ip4.sin_addr.s_addr;
+#ifdef HAVE_IPV6
+	else if (sk->any.sa_family == AF_INET6)
+	{
+		UINT32 words[4];
+		memcpy(words, &sk->ip6.sin6_addr, sizeof words);
+		hash = words[0] ^ words[1] ^ words[2] ^ words[3];
+	}
+#endif
+	else
+		hash = 0;
+
+	return (hash * 2654435761u) >> (32 - NODEHASHBITS);
+}
+
+static void SOCK_UnhashNode(INT32 node)
+{
+	INT16 *link;
+
+	if (!nodehashbucket[node])
+		return;
+
+	for (link = &nodehash[nodehashbucket[node] - 1]; *link; link = &nodehashnext[(INT32)*link])
+	{
+		if (*link == node)
+		{
+			*link = nodehashnext[node];
+			break;
+		}
+	}
+	nodehashbucket[node] = 0;
+}
+
+// Call whenever a node's address changes
+static void SOCK_HashNode(INT32 node)
+{
+	UINT32 bucket;
+
+	SOCK_UnhashNode(node);
+
+	// Node 0 is ourselves, and never matched against
+	if (node <= 0 || node > MAXNETNODES)
+		return;
+
+	bucket = SOCK_HashAddr(&clientaddress[node]);
+	nodehashnext[node] = nodehash[bucket];
+	nodehash[bucket] = (INT16)node;
+	nodehashbucket[node] = (UINT16)(bucket + 1);
+}
+
+static void SOCK_ClearNodeHash(void)
+{
+	memset(nodehash, 0, sizeof (nodehash));
+	memset(nodehashbucket, 0, sizeof (nodehashbucket));
+}
+
+static INT32 SOCK_FindNode(mysockaddr_t *address)
+{
+	INT32 j;
+
+	for (j = nodehash[SOCK_HashAddr(address)]; j; j = nodehashnext[(INT32)j])
+		if (SOCK_cmpaddr(address, &clientaddress[(INT32)j], 0))
+			return j;
+
+	return -1;
+}
+
 // This is a hack. For some reason, nodes aren't being freed properly.
 // This goes through and cleans up what nodes were supposed to be freed.
 /** \warning This function causes the file downloading to stop if someone joins.
@@ -442,7 +533,7 @@ static boolean SOCK_cmpaddr(mysockaddr_t *a, mysockaddr_t *b, UINT8 mask)
   */
 static void cleanupnodes(void)
 {
-	SINT8 j;
+	INT32 j;
 
 	if (!Playing())
 		return;
@@ -453,9 +544,9 @@ static void cleanupnodes(void)
 			nodeconnected[j] = false;
 }
 
-static SINT8 getfreenode(void)
+static INT32 getfreenode(void)
 {
-	SINT8 j;
+	INT32 j;
 
 	cleanupnodes();
 
@@ -521,15 +612,351 @@ void Command_Numnodes(void)
 #endif
 
 #ifndef NONET
+#ifdef HAVE_MMSG
+// Packets are read and written up to this many at a time,
+// one system call per socket.
+#define MMSGBATCH 64
+
+typedef struct
+{
+	mysockaddr_t address;
+	socklen_t addrlen;
+	SOCKET_TYPE socket;
+	INT32 node; // for sends, -1 if errors don't matter
+	size_t length;
+	char data[MAXPACKETLENGTH];
+} sockpacket_t;
+
+static boolean usemmsg = true; // false if the kernel doesn't have them
+
+static sockpacket_t recvpackets[MMSGBATCH];
+static size_t numrecvpackets = 0, nextrecvpacket = 0;
+
+static sockpacket_t sendpackets[MMSGBATCH];
+static size_t numsendpackets = 0;
+
+static void SOCK_FlushSends(void);
+
+// Drains whatever is waiting on the sockets
+static void SOCK_ReceiveBatch(void)
+{
+	struct mmsghdr msgs[MMSGBATCH];
+	struct iovec iovs[MMSGBATCH];
+	size_t i, n, room;
+	int got;
+
+	numrecvpackets = nextrecvpacket = 0;
+
+	for (n = 0; n < mysocketses && numrecvpackets < MMSGBATCH; n++)
+	{
+		room = MMSGBATCH - numrecvpackets;
+		memset(msgs, 0, room * sizeof (*msgs));
+		for (i = 0; i < room; i++)
+		{
+			sockpacket_t *packet = &recvpackets[numrecvpackets + i];
+			iovs[i].iov_base = packet->data;
+			iovs[i].iov_len = MAXPACKETLENGTH;
+			msgs[i].msg_hdr.msg_name = &packet->address;
+			msgs[i].msg_hdr.msg_namelen = (socklen_t)sizeof (packet->address);
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		got = recvmmsg(mysockets[n], msgs, (unsigned int)room, MSG_DONTWAIT, NULL);
+		if (got == ERRSOCKET)
+		{
+			if (errno == ENOSYS)
+			{
+				usemmsg = false;
+				return;
+			}
+			continue;
+		}
+
+		for (i = 0; i < (size_t)got; i++)
+		{
+			sockpacket_t *packet = &recvpackets[numrecvpackets + i];
+			packet->addrlen = msgs[i].msg_hdr.msg_namelen;
+			packet->socket = mysockets[n];
+			packet->length = msgs[i].msg_len;
+		}
+		numrecvpackets += got;
+	}
+}
+#endif
+
+// Finds the node a packet came from, or gives it a new one.
+// Returns -1 if it's from a new address and there's no room for it.
+static INT32 SOCK_NodeForAddress(mysockaddr_t *fromaddress, socklen_t fromlen, SOCKET_TYPE socket, boolean *newnode)
+{
+	size_t i;
+	INT32 j;
+
+	*newnode = false;
+
+	// find remote node number
+	j = SOCK_FindNode(fromaddress);
+	if (j != -1)
+	{
+		nodesocket[j] = socket;
+		return j;
+	}
+	// not found
+
+	// find a free slot
+	j = getfreenode();
+	if (j <= 0)
+	{
+		DEBFILE("New node detected: No more free slots\n");
+		return -1;
+	}
+
+	M_Memcpy(&clientaddress[j], fromaddress, fromlen);
+	SOCK_HashNode(j);
+	nodesocket[j] = socket;
+	DEBFILE(va("New node detected: node:%d address:%s\n", j,
+			SOCK_GetNodeAddress(j)));
+
+	// check if it's a banned dude so we can send a refusal later
+	for (i = 0; i < numbans; i++)
+	{
+		if (SOCK_cmpaddr(fromaddress, &banned[i], bannedmask[i]))
+		{
+			SOCK_bannednode[j] = true;
+			DEBFILE("This dude has been banned\n");
+			break;
+		}
+	}
+	if (i == numbans)
+		SOCK_bannednode[j] = false;
+
+	*newnode = true;
+	return j;
+}
+
+#ifdef HAVE_THREADS
+// With -netthread, a thread of its own waits on the sockets and
+// timestamps packets as soon as they come in, so they don't sit in
+// the kernel's buffer while the main thread is busy with a frame.
+// It hands them over through a single-producer, single-consumer ring.
+#define NETRINGSIZE 1024 // Must be a power of two
+
+#if defined (__GNUC__) || defined (__clang__)
+#define NETRING_LOAD(x) __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define NETRING_STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#else // volatile accesses are acquire and release with MSVC
+#define NETRING_LOAD(x) (x)
+#define NETRING_STORE(x, v) ((x) = (v))
+#endif
+
+typedef struct
+{
+	mysockaddr_t address;
+	socklen_t addrlen;
+	SOCKET_TYPE socket;
+	INT32 length;
+	precise_t arrival;
+	char data[MAXPACKETLENGTH];
+} ringpacket_t;
+
+static ringpacket_t *netring = NULL;
+static volatile UINT32 netringhead = 0; // Only written by the network thread
+static volatile UINT32 netringtail = 0; // Only written by the main thread
+static UINT32 netringdropped = 0;
+
+static volatile INT32 netthreadstop = 0;
+static boolean netthreadrunning = false;
+static I_mutex netthread_mutex;
+static I_cond netthread_cond;
+
+static void SOCK_NetThread(void *userdata)
+{
+	SOCKET_TYPE maxsocket = 0;
+	size_t n;
+
+	(void)userdata;
+
+	for (n = 0; n < mysocketses; n++)
+		if (mysockets[n] > maxsocket)
+			maxsocket = mysockets[n];
+
+	while (!NETRING_LOAD(netthreadstop) && !I_thread_is_stopped())
+	{
+		struct timeval timeout = {0, 10000}; // Check for being stopped this often
+		fd_set readset;
+
+		FD_ZERO(&readset);
+		for (n = 0; n < mysocketses; n++)
+			FD_SET(mysockets[n], &readset);
+
+		if (select((int)maxsocket + 1, &readset, NULL, NULL, &timeout) <= 0)
+			continue;
+
+		for (n = 0; n < mysocketses; n++)
+		{
+			if (!FD_ISSET(mysockets[n], &readset))
+				continue;
+
+			for (;;)
+			{
+				const UINT32 head = netringhead;
+				ringpacket_t *packet;
+				ssize_t c;
+
+				if (head - NETRING_LOAD(netringtail) >= NETRINGSIZE)
+				{
+					// Full, so the packet has to be read to be dropped
+					char discard[MAXPACKETLENGTH];
+					if (recvfrom(mysockets[n], discard, MAXPACKETLENGTH, 0, NULL, NULL) == ERRSOCKET)
+						break;
+					netringdropped++;
+					continue;
+				}
+
+				packet = &netring[head & (NETRINGSIZE - 1)];
+				packet->addrlen = (socklen_t)sizeof (packet->address);
+				c = recvfrom(mysockets[n], packet->data, MAXPACKETLENGTH, 0,
+					(void *)&packet->address, &packet->addrlen);
+				if (c == ERRSOCKET)
+					break; // Nothing left on this socket
+
+				packet->arrival = I_GetPreciseTime();
+				packet->socket = mysockets[n];
+				packet->length = (INT32)c;
+				NETRING_STORE(netringhead, head + 1);
+			}
+		}
+	}
+
+	I_lock_mutex(&netthread_mutex);
+	netthreadrunning = false;
+	I_wake_all_cond(&netthread_cond);
+	I_unlock_mutex(netthread_mutex);
+}
+
+static void SOCK_StartNetThread(void)
+{
+	if (netthreadrunning || !mysocketses)
+		return;
+
+	if (!netring)
+	{
+		netring = malloc(NETRINGSIZE * sizeof (*netring));
+		if (!netring)
+			I_Error("SOCK_StartNetThread: No more memory\n");
+	}
+
+	netringhead = netringtail = 0;
+	netthreadstop = 0;
+	netthreadrunning = true;
+	I_spawn_thread("net-receive", (I_thread_fn)SOCK_NetThread, NULL);
+}
+
+// Has to be done before the sockets are closed
+static void SOCK_StopNetThread(void)
+{
+	if (!netthreadrunning)
+		return;
+
+	I_lock_mutex(&netthread_mutex);
+	if (netthreadrunning)
+	{
+		NETRING_STORE(netthreadstop, 1);
+		while (netthreadrunning)
+			I_hold_cond(&netthread_cond, netthread_mutex);
+	}
+	I_unlock_mutex(netthread_mutex);
+
+	if (netringdropped)
+		DEBFILE(va("Network thread dropped %u packets\n", netringdropped));
+	netringdropped = 0;
+}
+
+static boolean SOCK_GetFromRing(void)
+{
+	boolean newnode;
+	INT32 j;
+
+#ifdef HAVE_MMSG
+	// Whatever's being waited on may be a reply to something still queued
+	SOCK_FlushSends();
+#endif
+
+	while (netringtail != NETRING_LOAD(netringhead))
+	{
+		ringpacket_t *packet = &netring[netringtail & (NETRINGSIZE - 1)];
+
+		j = SOCK_NodeForAddress(&packet->address, packet->addrlen, packet->socket, &newnode);
+		if (j != -1)
+		{
+			M_Memcpy(doomcom->data, packet->data, packet->length);
+			doomcom->remotenode = (INT16)j; // good packet from a game player
+			doomcom->datalength = (INT16)packet->length;
+			netpacketarrival = packet->arrival;
+		}
+
+		NETRING_STORE(netringtail, netringtail + 1);
+
+		if (j != -1)
+			return newnode;
+	}
+
+	doomcom->remotenode = -1; // no packet
+	return false;
+}
+#endif
+
 // Returns true if a packet was received from a new node, false in all other cases
 static boolean SOCK_Get(void)
 {
-	size_t i, n;
-	int j;
+	size_t n;
+	INT32 j;
 	ssize_t c;
+	boolean newnode;
 	mysockaddr_t fromaddress;
 	socklen_t fromlen;
 
+#ifdef HAVE_THREADS
+	if (netthreadrunning)
+		return SOCK_GetFromRing();
+#endif
+
+#ifdef HAVE_MMSG
+	if (usemmsg)
+	{
+		// Whatever's being waited on may be a reply to something still queued
+		SOCK_FlushSends();
+
+		for (;;)
+		{
+			sockpacket_t *packet;
+
+			if (nextrecvpacket == numrecvpackets)
+			{
+				SOCK_ReceiveBatch();
+				if (!numrecvpackets)
+					break;
+			}
+
+			packet = &recvpackets[nextrecvpacket++];
+			j = SOCK_NodeForAddress(&packet->address, packet->addrlen, packet->socket, &newnode);
+			if (j != -1)
+			{
+				M_Memcpy(doomcom->data, packet->data, packet->length);
+				doomcom->remotenode = (INT16)j; // good packet from a game player
+				doomcom->datalength = (INT16)packet->length;
+				return newnode;
+			}
+		}
+
+		if (usemmsg)
+		{
+			doomcom->remotenode = -1; // no packet
+			return false;
+		}
+	}
+#endif
+
 	for (n = 0; n < mysocketses; n++)
 	{
 		fromlen = (socklen_t)sizeof(fromaddress);
@@ -537,46 +964,13 @@ static boolean SOCK_Get(void)
 			(void *)&fromaddress, &fromlen);
 		if (c != ERRSOCKET)
 		{
-			// find remote node number
-			for (j = 1; j <= MAXNETNODES; j++) //include LAN
-			{
-				if (SOCK_cmpaddr(&fromaddress, &clientaddress[j], 0))
-				{
-					doomcom->remotenode = (INT16)j; // good packet from a game player
-					doomcom->datalength = (INT16)c;
-					nodesocket[j] = mysockets[n];
-					return false;
-				}
-			}
-			// not found
-
-			// find a free slot
-			j = getfreenode();
-			if (j > 0)
+			j = SOCK_NodeForAddress(&fromaddress, fromlen, mysockets[n], &newnode);
+			if (j != -1)
 			{
-				M_Memcpy(&clientaddress[j], &fromaddress, fromlen);
-				nodesocket[j] = mysockets[n];
-				DEBFILE(va("New node detected: node:%d address:%s\n", j,
-						SOCK_GetNodeAddress(j)));
 				doomcom->remotenode = (INT16)j; // good packet from a game player
 				doomcom->datalength = (INT16)c;
-
-				// check if it's a banned dude so we can send a refusal later
-				for (i = 0; i < numbans; i++)
-				{
-					if (SOCK_cmpaddr(&fromaddress, &banned[i], bannedmask[i]))
-					{
-						SOCK_bannednode[j] = true;
-						DEBFILE("This dude has been banned\n");
-						break;
-					}
-				}
-				if (i == numbans)
-					SOCK_bannednode[j] = false;
-				return true;
+				return newnode;
 			}
-			else
-				DEBFILE("New node detected: No more free slots\n");
 		}
 	}
 
@@ -639,29 +1033,113 @@ static boolean SOCK_CanGet(void)
 #endif
 
 #ifndef NONET
-static inline ssize_t SOCK_SendToAddr(SOCKET_TYPE socket, mysockaddr_t *sockaddr)
+static inline socklen_t SOCK_AddrLen(mysockaddr_t *sockaddr)
 {
-	socklen_t d4 = (socklen_t)sizeof(struct sockaddr_in);
+	switch (sockaddr->any.sa_family)
+	{
+		case AF_INET:  return (socklen_t)sizeof(struct sockaddr_in);
 #ifdef HAVE_IPV6
-	socklen_t d6 = (socklen_t)sizeof(struct sockaddr_in6);
+		case AF_INET6: return (socklen_t)sizeof(struct sockaddr_in6);
 #endif
-	socklen_t d, da = (socklen_t)sizeof(mysockaddr_t);
+		default:       return (socklen_t)sizeof(mysockaddr_t);
+	}
+}
 
-	switch (sockaddr->any.sa_family)
+static void SOCK_CheckSendError(INT32 node, int e)
+{
+	if (node != -1 && e != ECONNREFUSED && e != EWOULDBLOCK)
+		I_Error("SOCK_Send, error sending to node %d (%s) #%u: %s", node,
+			SOCK_GetNodeAddress(node), e, strerror(e));
+}
+
+#ifdef HAVE_MMSG
+static void SOCK_SendPacket(sockpacket_t *packet)
+{
+	if (sendto(packet->socket, packet->data, packet->length, 0, &packet->address.any, packet->addrlen) == ERRSOCKET)
+		SOCK_CheckSendError(packet->node, errno);
+}
+
+// Sends everything queued since the last flush
+static void SOCK_FlushSends(void)
+{
+	struct mmsghdr msgs[MMSGBATCH];
+	struct iovec iovs[MMSGBATCH];
+	size_t i, start, end;
+	int sent;
+
+	memset(msgs, 0, numsendpackets * sizeof (*msgs));
+	for (i = 0; i < numsendpackets; i++)
 	{
-		case AF_INET:  d = d4; break;
-#ifdef HAVE_IPV6
-		case AF_INET6: d = d6; break;
+		iovs[i].iov_base = sendpackets[i].data;
+		iovs[i].iov_len = sendpackets[i].length;
+		msgs[i].msg_hdr.msg_name = &sendpackets[i].address;
+		msgs[i].msg_hdr.msg_namelen = sendpackets[i].addrlen;
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	for (start = 0; start < numsendpackets; start = end)
+	{
+		// One call for each run of packets going out the same socket
+		for (end = start + 1; end < numsendpackets; end++)
+			if (sendpackets[end].socket != sendpackets[start].socket)
+				break;
+
+		while (start < end)
+		{
+			sent = sendmmsg(sendpackets[start].socket, &msgs[start], (unsigned int)(end - start), 0);
+			if (sent > 0)
+			{
+				start += sent;
+				continue;
+			}
+
+			if (errno == ENOSYS)
+			{
+				usemmsg = false;
+				for (i = start; i < numsendpackets; i++)
+					SOCK_SendPacket(&sendpackets[i]);
+				numsendpackets = 0;
+				return;
+			}
+
+			// It stops at the first packet that couldn't be sent
+			SOCK_CheckSendError(sendpackets[start].node, errno);
+			start++;
+		}
+	}
+
+	numsendpackets = 0;
+}
 #endif
-		default:       d = da; break;
+
+static inline void SOCK_SendToAddr(SOCKET_TYPE socket, mysockaddr_t *sockaddr, INT32 node)
+{
+#ifdef HAVE_MMSG
+	if (usemmsg)
+	{
+		sockpacket_t *packet;
+
+		if (numsendpackets == MMSGBATCH)
+			SOCK_FlushSends();
+
+		packet = &sendpackets[numsendpackets++];
+		packet->address = *sockaddr;
+		packet->addrlen = SOCK_AddrLen(sockaddr);
+		packet->socket = socket;
+		packet->node = node;
+		packet->length = doomcom->datalength;
+		M_Memcpy(packet->data, doomcom->data, packet->length);
+		return;
 	}
+#endif
 
-	return sendto(socket, (char *)&doomcom->data, doomcom->datalength, 0, &sockaddr->any, d);
+	if (sendto(socket, (char *)&doomcom->data, doomcom->datalength, 0, &sockaddr->any, SOCK_AddrLen(sockaddr)) == ERRSOCKET)
+		SOCK_CheckSendError(node, errno);
 }
 
 static void SOCK_Send(void)
 {
-	ssize_t c = ERRSOCKET;
 	size_t i, j;
 
 	if (!nodeconnected[doomcom->remotenode])
@@ -674,32 +1152,20 @@ static void SOCK_Send(void)
 			for (j = 0; j < broadcastaddresses; j++)
 			{
 				if (myfamily[i] == broadcastaddress[j].any.sa_family)
-					SOCK_SendToAddr(mysockets[i], &broadcastaddress[j]);
+					SOCK_SendToAddr(mysockets[i], &broadcastaddress[j], -1);
 			}
 		}
-		return;
 	}
 	else if (nodesocket[doomcom->remotenode] == (SOCKET_TYPE)ERRSOCKET)
 	{
 		for (i = 0; i < mysocketses; i++)
 		{
 			if (myfamily[i] == clientaddress[doomcom->remotenode].any.sa_family)
-				SOCK_SendToAddr(mysockets[i], &clientaddress[doomcom->remotenode]);
+				SOCK_SendToAddr(mysockets[i], &clientaddress[doomcom->remotenode], -1);
 		}
-		return;
 	}
 	else
-	{
-		c = SOCK_SendToAddr(nodesocket[doomcom->remotenode], &clientaddress[doomcom->remotenode]);
-	}
-
-	if (c == ERRSOCKET)
-	{
-		int e = errno; // save error code so it can't be modified later
-		if (e != ECONNREFUSED && e != EWOULDBLOCK)
-			I_Error("SOCK_Send, error sending to node %d (%s) #%u: %s", doomcom->remotenode,
-				SOCK_GetNodeAddress(doomcom->remotenode), e, strerror(e));
-	}
+		SOCK_SendToAddr(nodesocket[doomcom->remotenode], &clientaddress[doomcom->remotenode], doomcom->remotenode);
 }
 #endif
 
@@ -717,6 +1183,7 @@ static void SOCK_FreeNodenum(INT32 numnode)
 
 	// put invalid address
 	memset(&clientaddress[numnode], 0, sizeof (clientaddress[numnode]));
+	SOCK_UnhashNode(numnode);
 }
 #endif
 
@@ -984,6 +1451,7 @@ static boolean UDP_Socket(void)
 		while (runp != NULL && s < MAXNETNODES+1)
 		{
 			memcpy(&clientaddress[s], runp->ai_addr, runp->ai_addrlen);
+			SOCK_HashNode((INT32)s);
 			s++;
 			runp = runp->ai_next;
 		}
@@ -1122,6 +1590,18 @@ boolean I_InitTcpDriver(void)
 static void SOCK_CloseSocket(void)
 {
 	size_t i;
+
+#ifdef HAVE_THREADS
+	SOCK_StopNetThread();
+#endif
+
+#ifdef HAVE_MMSG
+	// Get out anything still queued, like the goodbyes
+	if (numsendpackets)
+		SOCK_FlushSends();
+	numrecvpackets = nextrecvpacket = 0;
+#endif
+
 	for (i=0; i < MAXNETNODES+1; i++)
 	{
 		if (mysockets[i] != (SOCKET_TYPE)ERRSOCKET
@@ -1151,9 +1631,9 @@ void I_ShutdownTcpDriver(void)
 }
 
 #ifndef NONET
-static SINT8 SOCK_NetMakeNodewPort(const char *address, const char *port)
+static INT16 SOCK_NetMakeNodewPort(const char *address, const char *port)
 {
-	SINT8 newnode = -1;
+	INT16 newnode = -1;
 	struct my_addrinfo *ai = NULL, *runp, hints;
 	int gaie;
 
@@ -1187,6 +1667,7 @@ static SINT8 SOCK_NetMakeNodewPort(const char *address, const char *port)
 		if (sendto(mysockets[0], NULL, 0, 0, runp->ai_addr, runp->ai_addrlen) == 0)
 		{
 			memcpy(&clientaddress[newnode], runp->ai_addr, runp->ai_addrlen);
+			SOCK_HashNode(newnode);
 			break;
 		}
 		runp = runp->ai_next;
@@ -1202,6 +1683,7 @@ static boolean SOCK_OpenSocket(void)
 	size_t i;
 
 	memset(clientaddress, 0, sizeof (clientaddress));
+	SOCK_ClearNodeHash();
 
 	nodeconnected[0] = true; // always connected to self
 	for (i = 1; i < MAXNETNODES; i++)
@@ -1212,6 +1694,9 @@ static boolean SOCK_OpenSocket(void)
 	I_NetCloseSocket = SOCK_CloseSocket;
 	I_NetFreeNodenum = SOCK_FreeNodenum;
 	I_NetMakeNodewPort = SOCK_NetMakeNodewPort;
+#ifdef HAVE_MMSG
+	I_NetFlush = SOCK_FlushSends;
+#endif
 
 #ifdef SELECTTEST
 	// seem like not work with libsocket : (
@@ -1221,7 +1706,14 @@ static boolean SOCK_OpenSocket(void)
 
 	// build the socket but close it first
 	SOCK_CloseSocket();
-	return UDP_Socket();
+	if (!UDP_Socket())
+		return false;
+
+#ifdef HAVE_THREADS
+	if (M_CheckParm("-netthread"))
+		SOCK_StartNetThread();
+#endif
+	return true;
 #else
 	return false;
 #endif
@@ -0,0 +1,317 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2022 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  lua_alloc.c
+/// \brief Pooled memory allocator for Lua
+///
+///        Nearly everything Lua allocates is small: strings, tables,
+///        closures, upvalues. Going through the zone for each of those
+///        costs a block header and a trip through malloc, so small
+///        blocks are carved out of slabs instead, one pool per size
+///        class, and recycled through the pool's free list.
+///
+///        Lua always says how big a block is when it frees or resizes
+///        it, so the pool a block belongs to doesn't have to be stored
+///        anywhere. Slabs are kept once allocated; the pools only grow
+///        to the most Lua has ever had alive at once.
+
+#include "doomdef.h"
+#include "console.h"
+#include "i_system.h"
+#include "m_misc.h"
+
+#include "lua_alloc.h"
+
+#define SLABSIZE (64<<10)
+#define MAXPOOLBLOCK 512
+
+// Size of the slab header, so that blocks stay 16-byte aligned
+#define SLABHEADER 16
+
+typedef struct luaslab_s
+{
+	struct luaslab_s *next;
+} luaslab_t;
+
+typedef struct luafreeblock_s
+{
+	struct luafreeblock_s *next;
+#ifdef PARANOIA
+	size_t magic;
+#endif
+} luafreeblock_t;
+
+typedef struct
+{
+	size_t blocksize;
+	luafreeblock_t *freelist;
+	UINT8 *bump, *bumpend; // unused end of the newest slab
+	luaslab_t *slabs;
+	size_t numslabs;
+	size_t live, peak; // blocks in use
+	size_t numfree; // blocks on the free list
+} luapool_t;
+
+#define LUAPOOL(size) {size, NULL, NULL, NULL, NULL, 0, 0, 0, 0}
+
+static luapool_t luapools[] =
+{
+	LUAPOOL(16), LUAPOOL(32), LUAPOOL(48), LUAPOOL(64), LUAPOOL(96),
+	LUAPOOL(128), LUAPOOL(192), LUAPOOL(256), LUAPOOL(384), LUAPOOL(512)
+};
+
+#undef LUAPOOL
+
+#define NUMLUAPOOLS (sizeof luapools / sizeof *luapools)
+
+// Pool for each size, in steps of 16 bytes
+static const UINT8 luapoolforsize[(MAXPOOLBLOCK>>4) + 1] =
+{
+	0, 0, 1, 2, 3, 4, 4, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7,
+	8, 8, 8, 8, 8, 8, 8, 8, 9, 9, 9, 9, 9, 9, 9, 9
+};
+
+static struct
+{
+	size_t livebytes, peakbytes; // as asked for by Lua
+	size_t largelive, largepeak; // blocks too big for the pools
+	size_t largebytes;
+} luamemstats;
+
+#define POOLFORSIZE(size) (&luapools[luapoolforsize[((size) + 15)>>4]])
+
+#ifdef PARANOIA
+// Free blocks are filled with this, and are checked for it when they
+// get reused, to catch anything still writing to them after the free.
+#define FREEPOISON 0xDD
+#define FREEMAGIC ((size_t)0x4C7561467265654CULL)
+
+static void PoisonBlock(luapool_t *pool, luafreeblock_t *block)
+{
+	block->magic = FREEMAGIC;
+	memset(block + 1, FREEPOISON, pool->blocksize - sizeof *block);
+}
+
+static boolean BlockIsPoisoned(luapool_t *pool, luafreeblock_t *block)
+{
+	const UINT8 *p = (const UINT8 *)(block + 1);
+	const UINT8 *end = (const UINT8 *)block + pool->blocksize;
+
+	if (block->magic != FREEMAGIC)
+		return false;
+	while (p < end)
+		if (*p++ != FREEPOISON)
+			return false;
+	return true;
+}
+
+static boolean BlockInPool(luapool_t *pool, void *ptr)
+{
+	luaslab_t *slab;
+
+	for (slab = pool->slabs; slab; slab = slab->next)
+	{
+		UINT8 *start = (UINT8 *)slab + SLABHEADER;
+		if ((UINT8 *)ptr >= start && (UINT8 *)ptr < (UINT8 *)slab + SLABSIZE)
+			return (((UINT8 *)ptr - start) % pool->blocksize) == 0;
+	}
+	return false;
+}
+
+static boolean BlockOnFreeList(luapool_t *pool, void *ptr)
+{
+	luafreeblock_t *block;
+
+	for (block = pool->freelist; block; block = block->next)
+		if (block == ptr)
+			return true;
+	return false;
+}
+#endif
+
+static void *PoolAlloc(luapool_t *pool)
+{
+	void *ptr;
+
+	if (pool->freelist)
+	{
+		luafreeblock_t *block = pool->freelist;
+#ifdef PARANOIA
+		if (!BlockIsPoisoned(pool, block))
+			I_Error("Lua heap corrupted: %s-byte block %p was written to after being freed", sizeu1(pool->blocksize), (void *)block);
+#endif
+		pool->freelist = block->next;
+		pool->numfree--;
+		ptr = block;
+	}
+	else
+	{
+		if (pool->bump + pool->blocksize > pool->bumpend)
+		{
+			luaslab_t *slab = malloc(SLABSIZE);
+			if (!slab)
+				I_Error("Out of memory allocating a %s-byte Lua pool", sizeu1(pool->blocksize));
+			slab->next = pool->slabs;
+			pool->slabs = slab;
+			pool->numslabs++;
+			pool->bump = (UINT8 *)slab + SLABHEADER;
+			pool->bumpend = (UINT8 *)slab + SLABSIZE;
+		}
+		ptr = pool->bump;
+		pool->bump += pool->blocksize;
+	}
+
+	if (++pool->live > pool->peak)
+		pool->peak = pool->live;
+	return ptr;
+}
+
+static void PoolFree(luapool_t *pool, void *ptr)
+{
+	luafreeblock_t *block = ptr;
+
+#ifdef PARANOIA
+	if (!BlockInPool(pool, ptr))
+		I_Error("Lua heap corrupted: freed %p, which isn't a %s-byte block", ptr, sizeu1(pool->blocksize));
+	if (block->magic == FREEMAGIC && BlockOnFreeList(pool, ptr))
+		I_Error("Lua heap corrupted: %s-byte block %p was freed twice", sizeu1(pool->blocksize), ptr);
+	PoisonBlock(pool, block);
+#endif
+
+	block->next = pool->freelist;
+	pool->freelist = block;
+	pool->numfree++;
+	pool->live--;
+}
+
+static void *LargeAlloc(size_t size)
+{
+	void *ptr = malloc(size);
+	if (!ptr)
+		I_Error("Out of memory allocating %s bytes for Lua", sizeu1(size));
+	luamemstats.largebytes += size;
+	if (++luamemstats.largelive > luamemstats.largepeak)
+		luamemstats.largepeak = luamemstats.largelive;
+	return ptr;
+}
+
+static void LargeFree(void *ptr, size_t size)
+{
+	free(ptr);
+	luamemstats.largebytes -= size;
+	luamemstats.largelive--;
+}
+
+void *LUA_PoolRealloc(void *ptr, size_t osize, size_t nsize)
+{
+	void *newptr;
+
+	if (ptr == NULL)
+		osize = 0;
+
+	luamemstats.livebytes += nsize - osize;
+	if (luamemstats.livebytes > luamemstats.peakbytes)
+		luamemstats.peakbytes = luamemstats.livebytes;
+
+	if (nsize == 0)
+	{
+		if (osize > MAXPOOLBLOCK)
+			LargeFree(ptr, osize);
+		else if (osize != 0)
+			PoolFree(POOLFORSIZE(osize), ptr);
+		return NULL;
+	}
+
+	if (nsize > MAXPOOLBLOCK)
+	{
+		if (osize > MAXPOOLBLOCK)
+		{
+			// Both big, let the C library move it if it has to
+			newptr = realloc(ptr, nsize);
+			if (!newptr)
+				I_Error("Out of memory allocating %s bytes for Lua", sizeu1(nsize));
+			luamemstats.largebytes += nsize - osize;
+			return newptr;
+		}
+		newptr = LargeAlloc(nsize);
+	}
+	else
+	{
+		luapool_t *pool = POOLFORSIZE(nsize);
+		if (osize != 0 && osize <= MAXPOOLBLOCK && POOLFORSIZE(osize) == pool)
+			return ptr; // Still fits
+		newptr = PoolAlloc(pool);
+	}
+
+	if (osize != 0)
+	{
+		memcpy(newptr, ptr, min(osize, nsize));
+		if (osize > MAXPOOLBLOCK)
+			LargeFree(ptr, osize);
+		else
+			PoolFree(POOLFORSIZE(osize), ptr);
+	}
+
+	return newptr;
+}
+
+void LUA_CheckPools(void)
+{
+#ifdef PARANOIA
+	size_t i;
+
+	for (i = 0; i < NUMLUAPOOLS; i++)
+	{
+		luapool_t *pool = &luapools[i];
+		luafreeblock_t *block;
+		size_t count = 0;
+
+		for (block = pool->freelist; block; block = block->next)
+		{
+			if (!BlockInPool(pool, block))
+				I_Error("Lua heap corrupted: the %s-byte pool's free list points to %p", sizeu1(pool->blocksize), (void *)block);
+			if (!BlockIsPoisoned(pool, block))
+				I_Error("Lua heap corrupted: %s-byte block %p was written to after being freed", sizeu1(pool->blocksize), (void *)block);
+			if (++count > pool->numfree)
+				I_Error("Lua heap corrupted: the %s-byte pool's free list loops", sizeu1(pool->blocksize));
+		}
+
+		if (count != pool->numfree)
+			I_Error("Lua heap corrupted: the %s-byte pool lost %s free blocks", sizeu1(pool->blocksize), sizeu2(pool->numfree - count));
+	}
+#endif
+}
+
+void Command_LuaMemStats_f(void)
+{
+	size_t i, pooledbytes = 0;
+
+	CONS_Printf(M_GetText("Lua memory in use: %s KB (peak %s KB)\n"),
+		sizeu1(luamemstats.livebytes>>10), sizeu2(luamemstats.peakbytes>>10));
+
+	CONS_Printf(M_GetText("Block size    In use      Peak      Free  Slabs\n"));
+	for (i = 0; i < NUMLUAPOOLS; i++)
+	{
+		luapool_t *pool = &luapools[i];
+		size_t unused = (pool->bumpend - pool->bump) / pool->blocksize;
+
+		CONS_Printf("%10s %9s %9s %9s %6s\n",
+			sizeu1(pool->blocksize), sizeu2(pool->live), sizeu3(pool->peak),
+			sizeu4(pool->numfree + unused), sizeu5(pool->numslabs));
+		pooledbytes += pool->numslabs * SLABSIZE;
+	}
+
+	CONS_Printf(M_GetText("Larger blocks: %s (peak %s), %s KB\n"),
+		sizeu1(luamemstats.largelive), sizeu2(luamemstats.largepeak), sizeu3(luamemstats.largebytes>>10));
+	CONS_Printf(M_GetText("Pools: %s KB in %u-KB slabs\n"), sizeu1(pooledbytes>>10), SLABSIZE>>10);
+
+#ifdef PARANOIA
+	LUA_CheckPools();
+	CONS_Printf(M_GetText("Lua heap integrity check passed.\n"));
+#endif
+}
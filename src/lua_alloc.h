@@ -0,0 +1,28 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2022 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  lua_alloc.h
+/// \brief Pooled memory allocator for Lua
+
+#ifndef __LUA_ALLOC__
+#define __LUA_ALLOC__
+
+#include "doomtype.h"
+
+// Same contract as Lua's allocator function: osize is the block's
+// current size (0 for a new block), and a nsize of 0 frees it.
+// Small blocks come from per-size slab pools, the rest from malloc.
+void *LUA_PoolRealloc(void *ptr, size_t osize, size_t nsize);
+
+// Walks every pool, and errors out if anything was written
+// to a free block. Only does anything in PARANOIA builds.
+void LUA_CheckPools(void);
+
+void Command_LuaMemStats_f(void);
+
+#endif // __LUA_ALLOC__
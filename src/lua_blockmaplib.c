@@ -225,7 +225,7 @@ static UINT8 lib_searchBlockmap_PolyObjs(lua_State *L, INT32 x, INT32 y, mobj_t
 //   false = searching of at least one block stopped mid-way (including if the whole search was stopped)
 static int lib_searchBlockmap(lua_State *L)
 {
-	int searchtype = luaL_checkoption(L, 1, "objects", search_opt);
+	int searchtype = Lua_checkoption(L, 1, "objects", search_opt);
 	int n;
 	mobj_t *mobj;
 	INT32 xl, xh, yl, yh, bx, by;
@@ -41,9 +41,20 @@ LIST (stringHookNames, STRING_HOOK_LIST);
 
 #undef LIST
 
+typedef struct {
+	int id;/* for error reporting */
+	int ref;/* the function in the registry */
+} hookcall_t;
+
 typedef struct {
 	int numHooks;
 	int *ids;
+
+	/* ids resolved to their functions, run in this order; for mobj
+	   hooks, the generic MT_NULL hooks are merged in at the front */
+	int numCalls;
+	hookcall_t *calls;
+	int callsGeneration;
 } hook_t;
 
 typedef struct {
@@ -65,6 +76,21 @@ static int   nextid;
 // After a hook errors once, don't print the error again.
 static UINT8 * hooksErrored;
 
+// Bumped whenever a hook is added, so that call lists get rebuilt.
+static int hookGeneration = 1;
+
+// Call counts and time spent for every kind of hook, for perfstats.
+enum {
+	HOOKSTAT_MOBJ    = 0,
+	HOOKSTAT_GENERIC = HOOKSTAT_MOBJ    + MOBJ_HOOK(MAX),
+	HOOKSTAT_HUD     = HOOKSTAT_GENERIC + HOOK(MAX),
+	HOOKSTAT_STRING  = HOOKSTAT_HUD     + HUD_HOOK(MAX),
+	NUMHOOKSTATS     = HOOKSTAT_STRING  + STRING_HOOK(MAX)
+};
+
+ps_hookstat_t ps_lua_hookstats[NUMHOOKSTATS];
+const int ps_lua_numhookstats = NUMHOOKSTATS;
+
 static int errorRef;
 
 static boolean mobj_hook_available(int hook_type, mobjtype_t mobj_type)
@@ -194,6 +220,8 @@ static void add_hook_ref(lua_State *L, int idx)
 	// set the hook function in the registry.
 	lua_pushvalue(L, idx);
 	hookRefs[nextid++] = luaL_ref(L, LUA_REGISTRYINDEX);
+
+	hookGeneration++;
 }
 
 // Takes hook, function, and additional arguments (mobj type to act on, etc.)
@@ -235,11 +263,24 @@ static int lib_addHook(lua_State *L)
 	return 0;
 }
 
+static void name_hook_stats(int stat, const char * const * const list)
+{
+	int type;
+
+	for (type = 0; list[type] != NULL; ++type)
+		ps_lua_hookstats[stat + type].name = list[type];
+}
+
 int LUA_HookLib(lua_State *L)
 {
 	lua_pushcfunction(L, LUA_GetErrorMessage);
 	errorRef = luaL_ref(L, LUA_REGISTRYINDEX);
 
+	name_hook_stats(HOOKSTAT_MOBJ, mobjHookNames);
+	name_hook_stats(HOOKSTAT_GENERIC, hookNames);
+	name_hook_stats(HOOKSTAT_HUD, hudHookNames);
+	name_hook_stats(HOOKSTAT_STRING, stringHookNames);
+
 	lua_register(L, "addHook", lib_addHook);
 
 	return 0;
@@ -300,10 +341,37 @@ static boolean begin_hook_values(Hook_State *hook)
 	return true;
 }
 
+/*
+The error handler is left at the bottom of the stack after a hook
+runs, so the next hook doesn't have to fetch it again. Other code
+clears the stack though, and nested hooks start out with a stack
+of their own, so it's still checked for.
+*/
 static void start_hook_stack(void)
 {
-	lua_settop(gL, 0);
-	push_error_handler();
+	if (lua_gettop(gL) >= EINDEX && lua_tocfunction(gL, EINDEX) == LUA_GetErrorMessage)
+		lua_settop(gL, EINDEX);
+	else
+	{
+		lua_settop(gL, 0);
+		push_error_handler();
+	}
+}
+
+static void end_hook_stack(void)
+{
+	lua_settop(gL, EINDEX);
+}
+
+static boolean hook_stats_enabled(void)
+{
+	return (cv_perfstats.value == 4);
+}
+
+static void add_hook_stat(int stat, int calls, precise_t time_taken)
+{
+	ps_lua_hookstats[stat].tic_calls += calls;
+	ps_lua_hookstats[stat].tic_time += time_taken;
 }
 
 static boolean init_hook_type
@@ -387,10 +455,47 @@ static void init_hook_call
 	hook->results_handler = results_handler;
 }
 
-static void get_hook(Hook_State *hook, const int *ids, int n)
+/* build the call list, if hooks were added since it was last built */
+static const hook_t * get_call_list(hook_t *map, const hook_t *generic)
 {
-	hook->id = ids[n];
-	lua_getref(gL, hookRefs[hook->id]);
+	hookcall_t *call;
+	int k;
+
+	if (map->callsGeneration != hookGeneration)
+	{
+		map->numCalls = map->numHooks + (generic ? generic->numHooks : 0);
+
+		if (map->numCalls > 0)
+			Z_Realloc(map->calls, map->numCalls * sizeof *map->calls,
+					PU_STATIC, &map->calls);
+
+		call = map->calls;
+
+		if (generic)
+		{
+			for (k = 0; k < generic->numHooks; ++k, ++call)
+			{
+				call->id = generic->ids[k];
+				call->ref = hookRefs[call->id];
+			}
+		}
+
+		for (k = 0; k < map->numHooks; ++k, ++call)
+		{
+			call->id = map->ids[k];
+			call->ref = hookRefs[call->id];
+		}
+
+		map->callsGeneration = hookGeneration;
+	}
+
+	return map;
+}
+
+static void get_hook(Hook_State *hook, const hook_t *map, int n)
+{
+	hook->id = map->calls[n].id;
+	lua_getref(gL, map->calls[n].ref);
 }
 
 static void get_hook_from_table(Hook_State *hook, int n)
@@ -457,13 +562,13 @@ static int call_mapped(Hook_State *hook, const hook_t *map)
 {
 	int k;
 
-	for (k = 0; k < map->numHooks; ++k)
+	for (k = 0; k < map->numCalls; ++k)
 	{
-		get_hook(hook, map->ids, k);
+		get_hook(hook, map, k);
 		call_single_hook(hook);
 	}
 
-	return map->numHooks;
+	return map->numCalls;
 }
 
 static int call_string_hooks(Hook_State *hook)
@@ -486,7 +591,10 @@ static int call_string_hooks(Hook_State *hook)
 
 static int call_mobj_type_hooks(Hook_State *hook, mobjtype_t mobj_type)
 {
-	return call_mapped(hook, &mobjHookIds[mobj_type][hook->hook_type]);
+	/* generic mobj hooks are called first */
+	return call_mapped(hook, get_call_list(
+				&mobjHookIds[mobj_type][hook->hook_type],
+				&mobjHookIds[MT_NULL][hook->hook_type]));
 }
 
 static int call_hooks
@@ -495,26 +603,38 @@ static int call_hooks
 		int        results,
 		Hook_Callback results_handler
 ){
+	const boolean timed = hook_stats_enabled();
+	precise_t time_taken = 0;
 	int calls = 0;
+	int stat;
+
+	if (timed)
+		time_taken = I_GetPreciseTime();
 
 	init_hook_call(hook, results, results_handler);
 
 	if (hook->string)
 	{
 		calls += call_string_hooks(hook);
+		stat = HOOKSTAT_STRING + hook->hook_type;
 	}
 	else if (hook->mobj_type > 0)
 	{
-		/* call generic mobj hooks first */
-		calls += call_mobj_type_hooks(hook, MT_NULL);
 		calls += call_mobj_type_hooks(hook, hook->mobj_type);
+		stat = HOOKSTAT_MOBJ + hook->hook_type;
 
 		ps_lua_mobjhooks.value.i += calls;
 	}
 	else
-		calls += call_mapped(hook, &hookIds[hook->hook_type]);
+	{
+		calls += call_mapped(hook, get_call_list(&hookIds[hook->hook_type], NULL));
+		stat = HOOKSTAT_GENERIC + hook->hook_type;
+	}
 
-	lua_settop(gL, 0);
+	end_hook_stack();
+
+	if (timed)
+		add_hook_stat(stat, calls, I_GetPreciseTime() - time_taken);
 
 	return calls;
 }
@@ -649,6 +769,12 @@ void LUA_HookHUD(int hook_type)
 	Hook_State hook;
 	if (map->numHooks > 0)
 	{
+		const boolean timed = hook_stats_enabled();
+		precise_t time_taken = 0;
+
+		if (timed)
+			time_taken = I_GetPreciseTime();
+
 		start_hook_stack();
 		begin_hook_values(&hook);
 
@@ -656,8 +782,11 @@ void LUA_HookHUD(int hook_type)
 
 		hud_running = true; // local hook
 		init_hook_call(&hook, 0, res_none);
-		call_mapped(&hook, map);
+		call_mapped(&hook, get_call_list(&hudHookIds[hook_type], NULL));
 		hud_running = false;
+
+		if (timed)
+			add_hook_stat(HOOKSTAT_HUD + hook_type, map->numCalls, I_GetPreciseTime() - time_taken);
 	}
 }
 
@@ -675,16 +804,22 @@ void LUA_HookThinkFrame(void)
 
 	Hook_State hook;
 
-	const hook_t * map = &hookIds[type];
+	const hook_t * map = get_call_list(&hookIds[type], NULL);
 	int k;
 
 	if (prepare_hook(&hook, 0, type))
 	{
+		const boolean timed = hook_stats_enabled();
+		precise_t total_time = 0;
+
+		if (timed)
+			total_time = I_GetPreciseTime();
+
 		init_hook_call(&hook, 0, res_none);
 
-		for (k = 0; k < map->numHooks; ++k)
+		for (k = 0; k < map->numCalls; ++k)
 		{
-			get_hook(&hook, map->ids, k);
+			get_hook(&hook, map, k);
 
 			if (cv_perfstats.value == 3)
 			{
@@ -704,7 +839,10 @@ void LUA_HookThinkFrame(void)
 			}
 		}
 
-		lua_settop(gL, 0);
+		end_hook_stack();
+
+		if (timed)
+			add_hook_stat(HOOKSTAT_GENERIC + type, map->numCalls, I_GetPreciseTime() - total_time);
 	}
 }
 
@@ -937,7 +1075,7 @@ void LUA_HookNetArchive(lua_CFunction archFunc)
 		// stack: tables, archFunc
 
 		init_hook_call(&hook, 0, res_none);
-		call_mapped(&hook, map);
+		call_mapped(&hook, get_call_list(&hookIds[HOOK(NetVars)], NULL));
 
 		lua_pop(gL, 1); // pop archFunc
 		lua_remove(gL, EINDEX); // pop error handler
@@ -1106,7 +1244,7 @@ static void res_musicchange(Hook_State *hook)
 int LUA_HookMusicChange(const char *oldname, struct MusicChange *param)
 {
 	const int type = HOOK(MusicChange);
-	const hook_t * map = &hookIds[type];
+	const hook_t * map = get_call_list(&hookIds[type], NULL);
 
 	Hook_State hook;
 
@@ -1121,9 +1259,9 @@ int LUA_HookMusicChange(const char *oldname, struct MusicChange *param)
 		lua_pushstring(gL, oldname);/* the only constant value */
 		lua_pushstring(gL, param->newname);/* semi constant */
 
-		for (k = 0; k < map->numHooks; ++k)
+		for (k = 0; k < map->numCalls; ++k)
 		{
-			get_hook(&hook, map->ids, k);
+			get_hook(&hook, map, k);
 
 			lua_pushvalue(gL, -3);
 			lua_pushvalue(gL, -3);
@@ -1136,7 +1274,7 @@ int LUA_HookMusicChange(const char *oldname, struct MusicChange *param)
 			call_single_hook_no_copy(&hook);
 		}
 
-		lua_settop(gL, 0);
+		end_hook_stack();
 	}
 
 	return hook.status;
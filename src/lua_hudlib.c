@@ -217,7 +217,7 @@ static int lib_hudinfolen(lua_State *L)
 static int hudinfo_get(lua_State *L)
 {
 	hudinfo_t *info = *((hudinfo_t **)luaL_checkudata(L, 1, META_HUDINFO));
-	enum hudinfo field = luaL_checkoption(L, 2, hudinfo_opt[0], hudinfo_opt);
+	enum hudinfo field = Lua_checkoption(L, 2, hudinfo_opt[0], hudinfo_opt);
 	I_Assert(info != NULL); // huditems are always valid
 
 	switch(field)
@@ -238,7 +238,7 @@ static int hudinfo_get(lua_State *L)
 static int hudinfo_set(lua_State *L)
 {
 	hudinfo_t *info = *((hudinfo_t **)luaL_checkudata(L, 1, META_HUDINFO));
-	enum hudinfo field = luaL_checkoption(L, 2, hudinfo_opt[0], hudinfo_opt);
+	enum hudinfo field = Lua_checkoption(L, 2, hudinfo_opt[0], hudinfo_opt);
 	I_Assert(info != NULL);
 
 	switch(field)
@@ -276,7 +276,7 @@ static int colormap_get(lua_State *L)
 static int patch_get(lua_State *L)
 {
 	patch_t *patch = *((patch_t **)luaL_checkudata(L, 1, META_PATCH));
-	enum patch field = luaL_checkoption(L, 2, NULL, patch_opt);
+	enum patch field = Lua_checkoption(L, 2, NULL, patch_opt);
 
 	// patches are invalidated when switching renderers
 	if (!patch) {
@@ -316,7 +316,7 @@ static int patch_set(lua_State *L)
 static int camera_get(lua_State *L)
 {
 	camera_t *cam = *((camera_t **)luaL_checkudata(L, 1, META_CAMERA));
-	enum cameraf field = luaL_checkoption(L, 2, NULL, camera_opt);
+	enum cameraf field = Lua_checkoption(L, 2, NULL, camera_opt);
 
 	// cameras should always be valid unless I'm a nutter
 	I_Assert(cam != NULL);
@@ -372,7 +372,7 @@ static int camera_get(lua_State *L)
 static int camera_set(lua_State *L)
 {
 	camera_t *cam = *((camera_t **)luaL_checkudata(L, 1, META_CAMERA));
-	enum cameraf field = luaL_checkoption(L, 2, NULL, camera_opt);
+	enum cameraf field = Lua_checkoption(L, 2, NULL, camera_opt);
 
 	I_Assert(cam != NULL);
 
@@ -803,7 +803,7 @@ static int libd_drawString(lua_State *L)
 	fixed_t y = luaL_checkinteger(L, 2);
 	const char *str = luaL_checkstring(L, 3);
 	INT32 flags = luaL_optinteger(L, 4, V_ALLOWLOWERCASE);
-	enum align align = luaL_checkoption(L, 5, "left", align_opt);
+	enum align align = Lua_checkoption(L, 5, "left", align_opt);
 
 	flags &= ~V_PARAMMASK; // Don't let crashes happen.
 
@@ -975,7 +975,7 @@ static int libd_stringWidth(lua_State *L)
 {
 	const char *str = luaL_checkstring(L, 1);
 	INT32 flags = luaL_optinteger(L, 2, V_ALLOWLOWERCASE);
-	enum widtht widtht = luaL_checkoption(L, 3, "normal", widtht_opt);
+	enum widtht widtht = Lua_checkoption(L, 3, "normal", widtht_opt);
 
 	HUDONLY
 	switch(widtht)
@@ -1254,7 +1254,7 @@ static int lib_draw_ref;
 // enable vanilla HUD element
 static int lib_hudenable(lua_State *L)
 {
-	enum hud option = luaL_checkoption(L, 1, NULL, hud_disable_options);
+	enum hud option = Lua_checkoption(L, 1, NULL, hud_disable_options);
 	hud_enabled[option/8] |= 1<<(option%8);
 	return 0;
 }
@@ -1262,7 +1262,7 @@ static int lib_hudenable(lua_State *L)
 // disable vanilla HUD element
 static int lib_huddisable(lua_State *L)
 {
-	enum hud option = luaL_checkoption(L, 1, NULL, hud_disable_options);
+	enum hud option = Lua_checkoption(L, 1, NULL, hud_disable_options);
 	hud_enabled[option/8] &= ~(1<<(option%8));
 	return 0;
 }
@@ -1270,7 +1270,7 @@ static int lib_huddisable(lua_State *L)
 // 30/10/18: Lat': How come this wasn't here before?
 static int lib_hudenabled(lua_State *L)
 {
-	enum hud option = luaL_checkoption(L, 1, NULL, hud_disable_options);
+	enum hud option = Lua_checkoption(L, 1, NULL, hud_disable_options);
 	if (hud_enabled[option/8] & (1<<(option%8)))
 		lua_pushboolean(L, true);
 	else
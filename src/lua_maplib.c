@@ -470,7 +470,7 @@ static int sectorlines_get(lua_State *L)
 	lua_settop(L, 2);
 	if (!lua_isnumber(L, 2))
 	{
-		int field = luaL_checkoption(L, 2, NULL, valid_opt);
+		int field = Lua_checkoption(L, 2, NULL, valid_opt);
 		if (!seclines || !(*seclines))
 		{
 			if (field == 0) {
@@ -537,7 +537,7 @@ static int sectorlines_num(lua_State *L)
 static int sector_get(lua_State *L)
 {
 	sector_t *sector = *((sector_t **)luaL_checkudata(L, 1, META_SECTOR));
-	enum sector_e field = luaL_checkoption(L, 2, sector_opt[0], sector_opt);
+	enum sector_e field = Lua_checkoption(L, 2, sector_opt[0], sector_opt);
 	INT16 i;
 
 	if (!sector)
@@ -626,7 +626,7 @@ static int sector_get(lua_State *L)
 static int sector_set(lua_State *L)
 {
 	sector_t *sector = *((sector_t **)luaL_checkudata(L, 1, META_SECTOR));
-	enum sector_e field = luaL_checkoption(L, 2, sector_opt[0], sector_opt);
+	enum sector_e field = Lua_checkoption(L, 2, sector_opt[0], sector_opt);
 
 	if (!sector)
 		return luaL_error(L, "accessed sector_t doesn't exist anymore.");
@@ -711,7 +711,7 @@ static int sector_num(lua_State *L)
 static int subsector_get(lua_State *L)
 {
 	subsector_t *subsector = *((subsector_t **)luaL_checkudata(L, 1, META_SUBSECTOR));
-	enum subsector_e field = luaL_checkoption(L, 2, subsector_opt[0], subsector_opt);
+	enum subsector_e field = Lua_checkoption(L, 2, subsector_opt[0], subsector_opt);
 
 	if (!subsector)
 	{
@@ -795,7 +795,7 @@ static int linestringargs_len(lua_State *L)
 static int line_get(lua_State *L)
 {
 	line_t *line = *((line_t **)luaL_checkudata(L, 1, META_LINE));
-	enum line_e field = luaL_checkoption(L, 2, line_opt[0], line_opt);
+	enum line_e field = Lua_checkoption(L, 2, line_opt[0], line_opt);
 
 	if (!line)
 	{
@@ -923,7 +923,7 @@ static int sidenum_get(lua_State *L)
 	lua_settop(L, 2);
 	if (!lua_isnumber(L, 2))
 	{
-		int field = luaL_checkoption(L, 2, NULL, valid_opt);
+		int field = Lua_checkoption(L, 2, NULL, valid_opt);
 		if (!sidenum)
 		{
 			if (field == 0) {
@@ -951,7 +951,7 @@ static int sidenum_get(lua_State *L)
 static int side_get(lua_State *L)
 {
 	side_t *side = *((side_t **)luaL_checkudata(L, 1, META_SIDE));
-	enum side_e field = luaL_checkoption(L, 2, side_opt[0], side_opt);
+	enum side_e field = Lua_checkoption(L, 2, side_opt[0], side_opt);
 
 	if (!side)
 	{
@@ -1004,7 +1004,7 @@ static int side_get(lua_State *L)
 static int side_set(lua_State *L)
 {
 	side_t *side = *((side_t **)luaL_checkudata(L, 1, META_SIDE));
-	enum side_e field = luaL_checkoption(L, 2, side_opt[0], side_opt);
+	enum side_e field = Lua_checkoption(L, 2, side_opt[0], side_opt);
 
 	if (!side)
 	{
@@ -1060,7 +1060,7 @@ static int side_num(lua_State *L)
 static int vertex_get(lua_State *L)
 {
 	vertex_t *vertex = *((vertex_t **)luaL_checkudata(L, 1, META_VERTEX));
-	enum vertex_e field = luaL_checkoption(L, 2, vertex_opt[0], vertex_opt);
+	enum vertex_e field = Lua_checkoption(L, 2, vertex_opt[0], vertex_opt);
 
 	if (!vertex)
 	{
@@ -1114,7 +1114,7 @@ static int vertex_num(lua_State *L)
 static int seg_get(lua_State *L)
 {
 	seg_t *seg = *((seg_t **)luaL_checkudata(L, 1, META_SEG));
-	enum seg_e field = luaL_checkoption(L, 2, seg_opt[0], seg_opt);
+	enum seg_e field = Lua_checkoption(L, 2, seg_opt[0], seg_opt);
 
 	if (!seg)
 	{
@@ -1178,7 +1178,7 @@ static int seg_num(lua_State *L)
 static int node_get(lua_State *L)
 {
 	node_t *node = *((node_t **)luaL_checkudata(L, 1, META_NODE));
-	enum node_e field = luaL_checkoption(L, 2, node_opt[0], node_opt);
+	enum node_e field = Lua_checkoption(L, 2, node_opt[0], node_opt);
 
 	if (!node)
 	{
@@ -1239,7 +1239,7 @@ static int nodebbox_get(lua_State *L)
 	lua_settop(L, 2);
 	if (!lua_isnumber(L, 2))
 	{
-		int field = luaL_checkoption(L, 2, NULL, valid_opt);
+		int field = Lua_checkoption(L, 2, NULL, valid_opt);
 		if (!bbox)
 		{
 			if (field == 0) {
@@ -1272,7 +1272,7 @@ static int nodebbox_call(lua_State *L)
 		return luaL_error(L, "arguments 2 and/or 3 not given (expected node.bbox(child, coord))");
 	// get child
 	if (!lua_isnumber(L, 2)) {
-		enum nodechild_e field = luaL_checkoption(L, 2, nodechild_opt[0], nodechild_opt);
+		enum nodechild_e field = Lua_checkoption(L, 2, nodechild_opt[0], nodechild_opt);
 		switch (field) {
 			case nodechild_right: i = 0; break;
 			case nodechild_left:  i = 1; break;
@@ -1287,7 +1287,7 @@ static int nodebbox_call(lua_State *L)
 	}
 	// get bbox coord
 	if (!lua_isnumber(L, 3)) {
-		enum bbox_e field = luaL_checkoption(L, 3, bbox_opt[0], bbox_opt);
+		enum bbox_e field = Lua_checkoption(L, 3, bbox_opt[0], bbox_opt);
 		switch (field) {
 			case bbox_top:    j = BOXTOP;    break;
 			case bbox_bottom: j = BOXBOTTOM; break;
@@ -1318,7 +1318,7 @@ static int nodechildren_get(lua_State *L)
 	lua_settop(L, 2);
 	if (!lua_isnumber(L, 2))
 	{
-		enum nodechild_e field = luaL_checkoption(L, 2, nodechild_opt[0], nodechild_opt);
+		enum nodechild_e field = Lua_checkoption(L, 2, nodechild_opt[0], nodechild_opt);
 		if (!children)
 		{
 			if (field == nodechild_valid) {
@@ -1358,7 +1358,7 @@ static int bbox_get(lua_State *L)
 	lua_settop(L, 2);
 	if (!lua_isnumber(L, 2))
 	{
-		enum bbox_e field = luaL_checkoption(L, 2, bbox_opt[0], bbox_opt);
+		enum bbox_e field = Lua_checkoption(L, 2, bbox_opt[0], bbox_opt);
 		if (!bbox)
 		{
 			if (field == bbox_valid) {
@@ -1464,7 +1464,7 @@ static int lib_getSubsector(lua_State *L)
 		LUA_PushUserdata(L, &subsectors[i], META_SUBSECTOR);
 		return 1;
 	}
-	field = luaL_checkoption(L, 1, NULL, array_opt);
+	field = Lua_checkoption(L, 1, NULL, array_opt);
 	switch(field)
 	{
 	case 0: // iterate
@@ -1558,7 +1558,7 @@ static int lib_getSide(lua_State *L)
 		LUA_PushUserdata(L, &sides[i], META_SIDE);
 		return 1;
 	}
-	field = luaL_checkoption(L, 1, NULL, array_opt);
+	field = Lua_checkoption(L, 1, NULL, array_opt);
 	switch(field)
 	{
 	case 0: // iterate
@@ -1610,7 +1610,7 @@ static int lib_getVertex(lua_State *L)
 		LUA_PushUserdata(L, &vertexes[i], META_VERTEX);
 		return 1;
 	}
-	field = luaL_checkoption(L, 1, NULL, array_opt);
+	field = Lua_checkoption(L, 1, NULL, array_opt);
 	switch(field)
 	{
 	case 0: // iterate
@@ -1664,7 +1664,7 @@ static int lib_getSeg(lua_State *L)
 		LUA_PushUserdata(L, &segs[i], META_SEG);
 		return 1;
 	}
-	field = luaL_checkoption(L, 1, NULL, array_opt);
+	field = Lua_checkoption(L, 1, NULL, array_opt);
 	switch(field)
 	{
 	case 0: // iterate
@@ -1716,7 +1716,7 @@ static int lib_getNode(lua_State *L)
 		LUA_PushUserdata(L, &nodes[i], META_NODE);
 		return 1;
 	}
-	field = luaL_checkoption(L, 1, NULL, array_opt);
+	field = Lua_checkoption(L, 1, NULL, array_opt);
 	switch(field)
 	{
 	case 0: // iterate
@@ -1740,7 +1740,7 @@ static int lib_numnodes(lua_State *L)
 static int ffloor_get(lua_State *L)
 {
 	ffloor_t *ffloor = *((ffloor_t **)luaL_checkudata(L, 1, META_FFLOOR));
-	enum ffloor_e field = luaL_checkoption(L, 2, ffloor_opt[0], ffloor_opt);
+	enum ffloor_e field = Lua_checkoption(L, 2, ffloor_opt[0], ffloor_opt);
 	INT16 i;
 
 	if (!ffloor)
@@ -1819,7 +1819,7 @@ static int ffloor_get(lua_State *L)
 static int ffloor_set(lua_State *L)
 {
 	ffloor_t *ffloor = *((ffloor_t **)luaL_checkudata(L, 1, META_FFLOOR));
-	enum ffloor_e field = luaL_checkoption(L, 2, ffloor_opt[0], ffloor_opt);
+	enum ffloor_e field = Lua_checkoption(L, 2, ffloor_opt[0], ffloor_opt);
 
 	if (!ffloor)
 		return luaL_error(L, "accessed ffloor_t doesn't exist anymore.");
@@ -1904,7 +1904,7 @@ static int ffloor_set(lua_State *L)
 static int slope_get(lua_State *L)
 {
 	pslope_t *slope = *((pslope_t **)luaL_checkudata(L, 1, META_SLOPE));
-	enum slope_e field = luaL_checkoption(L, 2, slope_opt[0], slope_opt);
+	enum slope_e field = Lua_checkoption(L, 2, slope_opt[0], slope_opt);
 
 	if (!slope)
 	{
@@ -1948,7 +1948,7 @@ static int slope_get(lua_State *L)
 static int slope_set(lua_State *L)
 {
 	pslope_t *slope = *((pslope_t **)luaL_checkudata(L, 1, META_SLOPE));
-	enum slope_e field = luaL_checkoption(L, 2, slope_opt[0], slope_opt);
+	enum slope_e field = Lua_checkoption(L, 2, slope_opt[0], slope_opt);
 
 	if (!slope)
 		return luaL_error(L, "accessed pslope_t doesn't exist anymore.");
@@ -2038,7 +2038,7 @@ static int slope_set(lua_State *L)
 static int vector2_get(lua_State *L)
 {
 	vector2_t *vec = *((vector2_t **)luaL_checkudata(L, 1, META_VECTOR2));
-	enum vector_e field = luaL_checkoption(L, 2, vector_opt[0], vector_opt);
+	enum vector_e field = Lua_checkoption(L, 2, vector_opt[0], vector_opt);
 
 	if (!vec)
 		return luaL_error(L, "accessed vector2_t doesn't exist anymore.");
@@ -2056,7 +2056,7 @@ static int vector2_get(lua_State *L)
 static int vector3_get(lua_State *L)
 {
 	vector3_t *vec = *((vector3_t **)luaL_checkudata(L, 1, META_VECTOR3));
-	enum vector_e field = luaL_checkoption(L, 2, vector_opt[0], vector_opt);
+	enum vector_e field = Lua_checkoption(L, 2, vector_opt[0], vector_opt);
 
 	if (!vec)
 		return luaL_error(L, "accessed vector3_t doesn't exist anymore.");
@@ -2092,7 +2092,7 @@ static int lib_getMapheaderinfo(lua_State *L)
 		//CONS_Printf(mapheaderinfo[i]->lvlttl);
 		return 1;
 	}/*
-	field = luaL_checkoption(L, 1, NULL, array_opt);
+	field = Lua_checkoption(L, 1, NULL, array_opt);
 	switch(field)
 	{
 	case 0: // iterate
@@ -85,7 +85,7 @@ static int polyobjvertices_get(lua_State *L)
 	lua_settop(L, 2);
 	if (!lua_isnumber(L, 2))
 	{
-		int field = luaL_checkoption(L, 2, NULL, valid_opt);
+		int field = Lua_checkoption(L, 2, NULL, valid_opt);
 		if (!polyverts || !(*polyverts))
 		{
 			if (field == 0) {
@@ -142,7 +142,7 @@ static int polyobjlines_get(lua_State *L)
 	lua_settop(L, 2);
 	if (!lua_isnumber(L, 2))
 	{
-		int field = luaL_checkoption(L, 2, NULL, valid_opt);
+		int field = Lua_checkoption(L, 2, NULL, valid_opt);
 		if (!polylines || !(*polylines))
 		{
 			if (field == 0) {
@@ -261,7 +261,7 @@ static int lib_polyobj_rotate(lua_State *L)
 static int polyobj_get(lua_State *L)
 {
 	polyobj_t *polyobj = *((polyobj_t **)luaL_checkudata(L, 1, META_POLYOBJ));
-	enum polyobj_e field = luaL_checkoption(L, 2, NULL, polyobj_opt);
+	enum polyobj_e field = Lua_checkoption(L, 2, NULL, polyobj_opt);
 
 	if (!polyobj) {
 		if (field == polyobj_valid) {
@@ -334,7 +334,7 @@ static int polyobj_get(lua_State *L)
 static int polyobj_set(lua_State *L)
 {
 	polyobj_t *polyobj = *((polyobj_t **)luaL_checkudata(L, 1, META_POLYOBJ));
-	enum polyobj_e field = luaL_checkoption(L, 2, NULL, polyobj_opt);
+	enum polyobj_e field = Lua_checkoption(L, 2, NULL, polyobj_opt);
 
 	if (!polyobj)
 		return LUA_ErrInvalid(L, "polyobj_t");
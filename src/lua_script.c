@@ -27,11 +27,14 @@
 #include "p_local.h"
 #include "p_slopes.h" // for P_SlopeById and slopelist
 #include "p_polyobj.h" // polyobj_t, PolyObjects
+#include "i_system.h" // I_GetPreciseTime
+#include "m_perfstats.h"
 #ifdef LUA_ALLOW_BYTECODE
 #include "d_netfil.h" // for LUA_DumpFile
 #endif
 
 #include "lua_script.h"
+#include "lua_alloc.h"
 #include "lua_libs.h"
 #include "lua_hook.h"
 
@@ -63,15 +66,29 @@ static lua_CFunction liblist[] = {
 };
 
 // Lua asks for memory using this.
+// Lua's garbage collector is stepped after each tic, in the time left
+// over, for as much as Lua allocated during it. It's kept from running
+// in the middle of a tic unless it falls too far behind, and then only
+// until it's caught up again.
+#define LUAGC_STEPSIZE 1024 // Bytes allocated per step, same as the collector's own
+#define LUAGC_MINSTEPS 4 // Taken every tic, even with no time to spare
+#define LUAGC_MAXDEBT (8<<20) // Let the collector run on its own past this
+
+static void LUA_GCBudget_OnChange(void);
+
+static CV_PossibleValue_t luagcbudget_cons_t[] = {{0, "MIN"}, {20000, "MAX"}, {0, NULL}};
+consvar_t cv_luagcbudget = CVAR_INIT ("luagcbudget", "2000", CV_SAVE|CV_CALL, luagcbudget_cons_t, LUA_GCBudget_OnChange);
+
+static size_t luagc_allocated = 0; // since the last tic
+static size_t luagc_debt = 0; // allocated and not collected for yet
+static boolean luagc_running = false; // running on its own until the debt is paid off
+
 static void *LUA_Alloc(void *ud, void *ptr, size_t osize, size_t nsize)
 {
 	(void)ud;
-	if (nsize == 0) {
-		if (osize != 0)
-			Z_Free(ptr);
-		return NULL;
-	} else
-		return Z_Realloc(ptr, nsize, PU_LUA, NULL);
+	if (nsize > osize)
+		luagc_allocated += nsize - osize;
+	return LUA_PoolRealloc(ptr, osize, nsize);
 }
 
 // Panic function Lua calls when there's an unprotected error.
@@ -1638,7 +1655,61 @@ void LUA_Step(void)
 	if (!gL)
 		return;
 	lua_settop(gL, 0);
-	lua_gc(gL, LUA_GCSTEP, 1);
+	if (!cv_luagcbudget.value)
+		lua_gc(gL, LUA_GCSTEP, 1);
+}
+
+static void LUA_GCBudget_OnChange(void)
+{
+	// LUA_StepGC stops it again if there's a budget
+	if (gL)
+		lua_gc(gL, LUA_GCRESTART, 0);
+	luagc_allocated = luagc_debt = 0;
+	luagc_running = false;
+}
+
+void LUA_StepGC(precise_t tictime, boolean behind)
+{
+	INT32 budget, elapsed = 0, steps = 0;
+	precise_t start;
+
+	if (!gL || !cv_luagcbudget.value)
+		return;
+
+	PS_START_TIMING(ps_lua_gctime);
+	start = I_GetPreciseTime();
+
+	// While the collector runs on its own, it keeps up with
+	// what gets allocated, and the steps here pay off the rest
+	if (!luagc_running)
+		luagc_debt += luagc_allocated;
+	luagc_allocated = 0;
+
+	// No time to spare if there are more tics to catch up on
+	if (behind)
+		budget = 0;
+	else
+		budget = min(cv_luagcbudget.value, 1000000/TICRATE - I_PreciseToMicros(tictime));
+
+	while (luagc_debt >= LUAGC_STEPSIZE && (steps < LUAGC_MINSTEPS || elapsed < budget))
+	{
+		lua_gc(gL, LUA_GCSTEP, 0);
+		luagc_debt -= LUAGC_STEPSIZE;
+		steps++;
+		elapsed = I_PreciseToMicros(I_GetPreciseTime() - start);
+	}
+
+	// Out of time for too long, so the collector will have to
+	// run during the tic to keep memory use down, until it's
+	// caught up with everything allocated before then.
+	if (luagc_debt > LUAGC_MAXDEBT)
+		luagc_running = true;
+	else if (luagc_debt < LUAGC_STEPSIZE)
+		luagc_running = false;
+
+	lua_gc(gL, luagc_running ? LUA_GCRESTART : LUA_GCSTOP, 0);
+
+	PS_STOP_TIMING(ps_lua_gctime);
 }
 
 void LUA_Archive(void)
@@ -1680,7 +1751,7 @@ void LUA_UnArchive(void)
 {
 	UINT32 mobjnum;
 	INT32 i;
-	thinker_t *th;
+	mobj_t *mobj;
 
 	if (gL)
 		lua_newtable(gL); // tables to be read
@@ -1694,14 +1765,8 @@ void LUA_UnArchive(void)
 
 	do {
 		mobjnum = READUINT32(save_p); // read a mobjnum
-		for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
-		{
-			if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
-				continue;
-			if (((mobj_t *)th)->mobjnum != mobjnum) // find matching mobj
-				continue;
-			UnArchiveExtVars(th); // apply variables
-		}
+		if (mobjnum != UINT32_MAX && (mobj = P_FindNewPosition(mobjnum)) != NULL) // find matching mobj
+			UnArchiveExtVars(mobj); // apply variables
 	} while(mobjnum != UINT32_MAX); // repeat until end of mobjs marker.
 
 	LUA_HookNetArchive(NetUnArchive); // call the NetArchive hook in unarchive mode
@@ -1711,18 +1776,143 @@ void LUA_UnArchive(void)
 		lua_pop(gL, 1); // pop tables
 }
 
+// Field names get looked up through a table mapping each option to its
+// index, built once per option list and keyed by the list itself, in a
+// table kept in the registry under lua_fieldcachekey's address. Lua
+// strings are interned, so that's a single hash lookup instead of
+// comparing against every option in turn.
+static boolean lua_fieldcache = true;
+static char lua_fieldcachekey;
+
 // For mobj_t, player_t, etc. to take custom variables.
 int Lua_optoption(lua_State *L, int narg,
 	const char *def, const char *const lst[])
 {
-	const char *name = (def) ? luaL_optstring(L, narg, def) :  luaL_checkstring(L, narg);
+	const char *name;
 	int i;
+
+	if (lua_fieldcache && (lua_type(L, narg) == LUA_TSTRING || (def && lua_isnoneornil(L, narg))))
+	{
+		// Only ever compared, never written through
+		void *key = (void *)(size_t)lst;
+
+		lua_pushlightuserdata(L, &lua_fieldcachekey);
+		lua_rawget(L, LUA_REGISTRYINDEX);
+		if (!lua_istable(L, -1))
+		{
+			lua_pop(L, 1);
+			lua_newtable(L);
+			lua_pushlightuserdata(L, &lua_fieldcachekey);
+			lua_pushvalue(L, -2);
+			lua_rawset(L, LUA_REGISTRYINDEX);
+		}
+
+		lua_pushlightuserdata(L, key);
+		lua_rawget(L, -2);
+		if (!lua_istable(L, -1))
+		{
+			lua_pop(L, 1);
+			lua_newtable(L);
+			for (i = 0; lst[i]; i++)
+				;
+			while (i--) // backwards, so the first of any duplicates wins
+			{
+				lua_pushinteger(L, i);
+				lua_setfield(L, -2, lst[i]);
+			}
+			lua_pushlightuserdata(L, key);
+			lua_pushvalue(L, -2);
+			lua_rawset(L, -4);
+		}
+
+		if (lua_isnoneornil(L, narg))
+			lua_pushstring(L, def);
+		else
+			lua_pushvalue(L, narg);
+		lua_rawget(L, -2);
+		i = lua_isnumber(L, -1) ? (int)lua_tointeger(L, -1) : -1;
+		lua_pop(L, 3);
+		return i;
+	}
+
+	name = (def) ? luaL_optstring(L, narg, def) : luaL_checkstring(L, narg);
 	for (i=0; lst[i]; i++)
 		if (fastcmp(lst[i], name))
 			return i;
 	return -1;
 }
 
+// Same as luaL_checkoption, for fields of userdata.
+int Lua_checkoption(lua_State *L, int narg,
+	const char *def, const char *const lst[])
+{
+	int i = Lua_optoption(L, narg, def, lst);
+	if (i == -1)
+		return luaL_argerror(L, narg,
+			lua_pushfstring(L, "invalid option " LUA_QS, (def) ? luaL_optstring(L, narg, def) : luaL_checkstring(L, narg)));
+	return i;
+}
+
+// Times reading a few mobj_t and sector_t fields from Lua,
+// with and without the field lookup tables.
+void Command_LuaFieldBench_f(void)
+{
+	static const char *benchcode =
+		"local mo, n = ...\n"
+		"for i = 1, n do\n"
+		"	local x, momz = mo.x, mo.momz\n"
+		"	local floor = mo.subsector.sector.floorheight\n"
+		"end\n";
+	const INT32 readsperloop = 5;
+	INT32 loops = 200000;
+	precise_t start;
+	UINT32 micros[2];
+	mobj_t *mo;
+	int pass;
+
+	if (COM_Argc() > 1)
+		loops = max(1, atoi(COM_Argv(1)) / readsperloop);
+
+	mo = (gamestate == GS_LEVEL && playeringame[consoleplayer]) ? players[consoleplayer].mo : NULL;
+	if (!gL || !mo)
+	{
+		CONS_Printf(M_GetText("You must be in a level to use this.\n"));
+		return;
+	}
+
+	for (pass = 0; pass < 2; pass++)
+	{
+		lua_fieldcache = (pass == 1);
+
+		lua_settop(gL, 0);
+		if (luaL_loadstring(gL, benchcode) != 0)
+		{
+			CONS_Alert(CONS_WARNING, "%s\n", lua_tostring(gL, -1));
+			lua_settop(gL, 0);
+			lua_fieldcache = true;
+			return;
+		}
+		LUA_PushUserdata(gL, mo, META_MOBJ);
+		lua_pushinteger(gL, loops);
+
+		start = I_GetPreciseTime();
+		if (lua_pcall(gL, 2, 0, 0) != 0)
+		{
+			CONS_Alert(CONS_WARNING, "%s\n", lua_tostring(gL, -1));
+			lua_settop(gL, 0);
+			lua_fieldcache = true;
+			return;
+		}
+		micros[pass] = max(1, I_PreciseToMicros(I_GetPreciseTime() - start));
+	}
+
+	lua_fieldcache = true;
+
+	CONS_Printf(M_GetText("%d field reads:\n"), loops * readsperloop);
+	CONS_Printf(M_GetText("  linear search: %u us, %.0f reads/sec\n"), micros[0], (double)loops * readsperloop * 1000000.0 / micros[0]);
+	CONS_Printf(M_GetText("  lookup table:  %u us, %.0f reads/sec\n"), micros[1], (double)loops * readsperloop * 1000000.0 / micros[1]);
+}
+
 void LUA_PushTaggableObjectArray
 (		lua_State *L,
 		const char *field,
@@ -18,6 +18,7 @@
 #include "d_player.h"
 #include "g_state.h"
 #include "taglist.h"
+#include "command.h"
 
 #include "blua/lua.h"
 #include "blua/lualib.h"
@@ -51,6 +52,9 @@ void LUA_DumpFile(const char *filename);
 #endif
 fixed_t LUA_EvalMath(const char *word);
 void LUA_Step(void);
+// Steps the garbage collector after a tic that took tictime to run.
+void LUA_StepGC(precise_t tictime, boolean behind);
+extern consvar_t cv_luagcbudget;
 void LUA_Archive(void);
 void LUA_UnArchive(void);
 int LUA_PushGlobals(lua_State *L, const char *word);
@@ -59,6 +63,9 @@ void Got_Luacmd(UINT8 **cp, INT32 playernum); // lua_consolelib.c
 void LUA_CVarChanged(void *cvar); // lua_consolelib.c
 int Lua_optoption(lua_State *L, int narg,
 	const char *def, const char *const lst[]);
+int Lua_checkoption(lua_State *L, int narg,
+	const char *def, const char *const lst[]);
+void Command_LuaFieldBench_f(void);
 void LUA_HookNetArchive(lua_CFunction archFunc);
 
 void LUA_PushTaggableObjectArray
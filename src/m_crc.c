@@ -0,0 +1,158 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2022 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  m_crc.c
+/// \brief CRC32C (Castagnoli) checksums
+///
+///        x86 CPUs since SSE4.2 and most ARMv8 CPUs can compute CRC32C
+///        eight bytes at a time in hardware. Everything else gets a
+///        slicing-by-8 table version, which also works a word at a time
+///        instead of a byte at a time.
+
+#include "doomdef.h"
+#include "m_crc.h"
+
+#if (defined (__GNUC__) || defined (__clang__)) && (defined (__x86_64__) || defined (__i386__))
+#define CRC32C_SSE42
+#include <nmmintrin.h>
+#elif defined (__ARM_FEATURE_CRC32) && defined (__aarch64__)
+#define CRC32C_ARMV8
+#include <arm_acle.h>
+#endif
+
+#define CRC32C_POLY 0x82F63B78 // reversed
+
+static UINT32 crctable[8][256];
+static boolean crctableready = false;
+
+static void InitCRCTable(void)
+{
+	UINT32 i, j, crc;
+
+	for (i = 0; i < 256; i++)
+	{
+		crc = i;
+		for (j = 0; j < 8; j++)
+			crc = (crc >> 1) ^ (CRC32C_POLY & (0 - (crc & 1)));
+		crctable[0][i] = crc;
+	}
+
+	// Table n is for a byte followed by n zero bytes
+	for (i = 0; i < 256; i++)
+		for (j = 1; j < 8; j++)
+			crctable[j][i] = (crctable[j-1][i] >> 8) ^ crctable[0][crctable[j-1][i] & 0xFF];
+
+	crctableready = true;
+}
+
+static UINT32 CRC32C_Table(UINT32 crc, const UINT8 *p, size_t len)
+{
+	if (!crctableready)
+		InitCRCTable();
+
+	for (; len >= 8; len -= 8, p += 8)
+	{
+		crc ^= p[0] | (p[1] << 8) | (p[2] << 16) | ((UINT32)p[3] << 24);
+		crc = crctable[7][crc & 0xFF] ^ crctable[6][(crc >> 8) & 0xFF]
+			^ crctable[5][(crc >> 16) & 0xFF] ^ crctable[4][crc >> 24]
+			^ crctable[3][p[4]] ^ crctable[2][p[5]]
+			^ crctable[1][p[6]] ^ crctable[0][p[7]];
+	}
+
+	while (len--)
+		crc = (crc >> 8) ^ crctable[0][(crc ^ *p++) & 0xFF];
+
+	return crc;
+}
+
+#ifdef CRC32C_SSE42
+__attribute__((target("sse4.2")))
+static UINT32 CRC32C_Hardware(UINT32 crc, const UINT8 *p, size_t len)
+{
+#ifdef __x86_64__
+	UINT64 crc64 = crc;
+	UINT64 word;
+
+	for (; len >= 8; len -= 8, p += 8)
+	{
+		memcpy(&word, p, 8);
+		crc64 = _mm_crc32_u64(crc64, word);
+	}
+	crc = (UINT32)crc64;
+#endif
+	{
+		UINT32 word32;
+		for (; len >= 4; len -= 4, p += 4)
+		{
+			memcpy(&word32, p, 4);
+			crc = _mm_crc32_u32(crc, word32);
+		}
+	}
+	while (len--)
+		crc = _mm_crc32_u8(crc, *p++);
+	return crc;
+}
+#elif defined (CRC32C_ARMV8)
+static UINT32 CRC32C_Hardware(UINT32 crc, const UINT8 *p, size_t len)
+{
+	UINT64 word;
+
+	for (; len >= 8; len -= 8, p += 8)
+	{
+		memcpy(&word, p, 8);
+		crc = __crc32cd(crc, word);
+	}
+	while (len--)
+		crc = __crc32cb(crc, *p++);
+	return crc;
+}
+#endif
+
+static UINT32 (*crc32cfunc)(UINT32, const UINT8 *, size_t) = NULL;
+
+static void PickCRCFunction(void)
+{
+#ifdef CRC32C_SSE42
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse4.2"))
+	{
+		crc32cfunc = CRC32C_Hardware;
+		return;
+	}
+#elif defined (CRC32C_ARMV8)
+	crc32cfunc = CRC32C_Hardware;
+	return;
+#endif
+	crc32cfunc = CRC32C_Table;
+}
+
+UINT32 M_CRC32C(const void *data, size_t len)
+{
+	if (!crc32cfunc)
+		PickCRCFunction();
+	return ~crc32cfunc(0xFFFFFFFF, data, len);
+}
+
+UINT32 M_CRC32CSoftware(const void *data, size_t len)
+{
+	return ~CRC32C_Table(0xFFFFFFFF, data, len);
+}
+
+const char *M_CRC32CImplementation(void)
+{
+	if (!crc32cfunc)
+		PickCRCFunction();
+#ifdef CRC32C_SSE42
+	if (crc32cfunc == CRC32C_Hardware)
+		return "SSE4.2";
+#elif defined (CRC32C_ARMV8)
+	if (crc32cfunc == CRC32C_Hardware)
+		return "ARMv8 CRC";
+#endif
+	return "table";
+}
@@ -0,0 +1,26 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2022 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  m_crc.h
+/// \brief CRC32C (Castagnoli) checksums
+
+#ifndef __M_CRC__
+#define __M_CRC__
+
+#include "doomtype.h"
+
+// CRC32C of a buffer, using the CPU's CRC instructions when it has them
+UINT32 M_CRC32C(const void *data, size_t len);
+
+// Same result as M_CRC32C, but always uses the lookup tables
+UINT32 M_CRC32CSoftware(const void *data, size_t len);
+
+// Name of the implementation M_CRC32C ends up using
+const char *M_CRC32CImplementation(void);
+
+#endif // __M_CRC__
@@ -0,0 +1,422 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2022 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  m_md5cache.c
+/// \brief Persistent cache of file MD5s, keyed by path, size and time
+///
+///        Hashing every addon in full at startup and again when joining
+///        takes seconds with a few gigabytes of them. Each file's MD5 is
+///        kept in md5cache.txt in the home folder along with its size and
+///        modification time, and only files where those changed get
+///        hashed again. Files that do need hashing at startup are handed
+///        to worker threads, while the main thread loads the ones before.
+
+#include <sys/stat.h>
+
+#include "doomdef.h"
+#include "d_main.h"
+#include "i_system.h"
+#include "i_threads.h"
+#include "md5.h"
+#include "m_md5cache.h"
+
+#define MD5CACHEFILENAME "md5cache.txt"
+#define MD5CACHEHEADER "SRB2 MD5 cache 1"
+
+#define MD5CACHEHASHSIZE 256 // Must be a power of two
+
+#define MD5HASHTHREADS 4
+
+typedef enum
+{
+	MD5_DONE,
+	MD5_QUEUED, // Waiting for a worker thread
+	MD5_HASHING
+} md5state_t;
+
+typedef struct md5entry_s
+{
+	char *path;
+	unsigned long size;
+	long mtime;
+	UINT8 md5sum[16];
+	UINT32 hashtime; // How many microseconds hashing it took
+	md5state_t state;
+	boolean valid; // False if it couldn't be read
+	struct md5entry_s *next; // In the same hash bucket
+	struct md5entry_s *nextjob;
+} md5entry_t;
+
+static md5entry_t *md5cache[MD5CACHEHASHSIZE];
+static boolean md5cacheloaded = false;
+static boolean md5cachedirty = false;
+
+static md5entry_t *md5jobs = NULL; // Queued for worker threads
+
+// For M_PrintMD5CacheStats
+static UINT32 numhashed = 0, numcached = 0;
+static double hashedtime = 0.0, savedtime = 0.0, waitedtime = 0.0; // Seconds
+
+#ifdef HAVE_THREADS
+static I_mutex md5cache_mutex;
+static I_cond md5cache_cond;
+
+#  define Lock_state()   I_lock_mutex  (&md5cache_mutex)
+#  define Unlock_state() I_unlock_mutex (md5cache_mutex)
+#else/*HAVE_THREADS*/
+#  define Lock_state()
+#  define Unlock_state()
+#endif/*HAVE_THREADS*/
+
+static UINT32 HashPath(const char *path)
+{
+	UINT32 hash = 2166136261u;
+
+	while (*path)
+		hash = (hash ^ (UINT8)*path++) * 16777619u;
+
+	return hash & (MD5CACHEHASHSIZE - 1);
+}
+
+static md5entry_t *FindEntry(const char *path)
+{
+	md5entry_t *entry;
+
+	for (entry = md5cache[HashPath(path)]; entry; entry = entry->next)
+		if (!strcmp(entry->path, path))
+			return entry;
+
+	return NULL;
+}
+
+static md5entry_t *AddEntry(const char *path)
+{
+	md5entry_t *entry = calloc(1, sizeof (*entry));
+	const UINT32 bucket = HashPath(path);
+
+	if (!entry || !(entry->path = strdup(path)))
+		I_Error("M_GetFileMD5: No more memory\n");
+
+	entry->next = md5cache[bucket];
+	md5cache[bucket] = entry;
+	return entry;
+}
+
+static boolean StatFile(const char *path, unsigned long *size, long *mtime)
+{
+	struct stat fsstat;
+
+	if (stat(path, &fsstat) < 0 || S_ISDIR(fsstat.st_mode))
+		return false;
+
+	*size = (unsigned long)fsstat.st_size;
+	*mtime = (long)fsstat.st_mtime;
+	return true;
+}
+
+static void LoadMD5Cache(void)
+{
+	char line[MAX_WADPATH + 128];
+	FILE *f;
+
+	md5cacheloaded = true;
+
+	f = fopen(va("%s" PATHSEP MD5CACHEFILENAME, srb2home), "r");
+	if (!f)
+		return;
+
+	if (!fgets(line, sizeof line, f) || strncmp(line, MD5CACHEHEADER, strlen(MD5CACHEHEADER)))
+	{
+		fclose(f);
+		return;
+	}
+
+	while (fgets(line, sizeof line, f))
+	{
+		char md5text[33], path[MAX_WADPATH];
+		unsigned long size;
+		long mtime;
+		unsigned hashtime;
+		md5entry_t *entry;
+		INT32 i;
+
+		if (sscanf(line, "%32s %lu %ld %u %511[^\n]", md5text, &size, &mtime, &hashtime, path) != 5
+			|| strlen(md5text) != 32 || FindEntry(path))
+			continue;
+
+		entry = AddEntry(path);
+		entry->size = size;
+		entry->mtime = mtime;
+		entry->hashtime = hashtime;
+		entry->valid = true;
+		for (i = 0; i < 16; i++)
+		{
+			unsigned byte;
+			sscanf(&md5text[i*2], "%2x", &byte);
+			entry->md5sum[i] = (UINT8)byte;
+		}
+	}
+
+	fclose(f);
+}
+
+// Hashes a file, without holding the lock
+static boolean HashFile(const char *path, UINT8 *md5sum, UINT32 *hashtime)
+{
+	precise_t start = I_GetPreciseTime();
+	FILE *f = fopen(path, "rb");
+	boolean ok;
+
+	if (!f)
+		return false;
+
+	ok = (md5_stream(f, md5sum) == 0);
+	fclose(f);
+
+	*hashtime = (UINT32)I_PreciseToMicros(I_GetPreciseTime() - start);
+	return ok;
+}
+
+static void FinishEntry(md5entry_t *entry, boolean ok, const UINT8 *md5sum, UINT32 hashtime)
+{
+	entry->valid = ok;
+	if (ok)
+	{
+		memcpy(entry->md5sum, md5sum, 16);
+		entry->hashtime = hashtime;
+		numhashed++;
+		hashedtime += hashtime / 1000000.0;
+		md5cachedirty = true;
+	}
+	entry->state = MD5_DONE;
+}
+
+#ifdef HAVE_THREADS
+static void HashWorker(void *userdata)
+{
+	(void)userdata;
+
+	while (!I_thread_is_stopped())
+	{
+		md5entry_t *entry;
+		UINT8 md5sum[16];
+		UINT32 hashtime = 0;
+		boolean ok;
+
+		// Take the next job nobody has started on yet
+		Lock_state();
+		while (md5jobs && md5jobs->state != MD5_QUEUED)
+			md5jobs = md5jobs->nextjob;
+		entry = md5jobs;
+		if (entry)
+		{
+			md5jobs = entry->nextjob;
+			entry->state = MD5_HASHING;
+		}
+		Unlock_state();
+
+		if (!entry)
+			break;
+
+		// Only this thread touches the path while it's hashing
+		ok = HashFile(entry->path, md5sum, &hashtime);
+
+		Lock_state();
+		FinishEntry(entry, ok, md5sum, hashtime);
+		I_wake_all_cond(&md5cache_cond);
+		Unlock_state();
+	}
+}
+#endif
+
+void M_PrefetchFileMD5s(char **files, size_t numfiles)
+{
+#ifdef HAVE_THREADS
+	md5entry_t **tail;
+	size_t i, numjobs = 0;
+
+	Lock_state();
+
+	if (!md5cacheloaded)
+		LoadMD5Cache();
+
+	for (tail = &md5jobs; *tail; tail = &(*tail)->nextjob)
+		;
+
+	for (i = 0; i < numfiles; i++)
+	{
+		md5entry_t *entry = FindEntry(files[i]);
+		unsigned long size;
+		long mtime;
+
+		if (!StatFile(files[i], &size, &mtime))
+			continue; // Folders, or files that need finding first
+
+		if (entry && (entry->state != MD5_DONE
+			|| (entry->valid && entry->size == size && entry->mtime == mtime)))
+			continue; // Already hashed or being hashed
+
+		if (!entry)
+			entry = AddEntry(files[i]);
+		else
+		{
+			md5entry_t *job;
+
+			// Hashed here while it was still queued, and then changed
+			for (job = md5jobs; job && job != entry; job = job->nextjob)
+				;
+			if (job)
+				continue;
+		}
+		entry->size = size;
+		entry->mtime = mtime;
+		entry->state = MD5_QUEUED;
+		entry->nextjob = NULL;
+
+		*tail = entry;
+		tail = &entry->nextjob;
+		numjobs++;
+	}
+
+	Unlock_state();
+
+	for (i = 0; i < min(numjobs, MD5HASHTHREADS); i++)
+		I_spawn_thread("md5-hash", (I_thread_fn)HashWorker, NULL);
+#else
+	(void)files;
+	(void)numfiles;
+#endif
+}
+
+boolean M_GetFileMD5(const char *filename, UINT8 *md5sum)
+{
+	md5entry_t *entry;
+	unsigned long size;
+	long mtime;
+	UINT8 newmd5sum[16];
+	UINT32 hashtime = 0;
+	boolean ok;
+
+	if (!StatFile(filename, &size, &mtime))
+		return false;
+
+	Lock_state();
+
+	if (!md5cacheloaded)
+		LoadMD5Cache();
+
+	entry = FindEntry(filename);
+
+#ifdef HAVE_THREADS
+	// A worker is on it already, so wait for it to finish
+	if (entry && entry->state == MD5_HASHING)
+	{
+		precise_t start = I_GetPreciseTime();
+
+		while (entry->state == MD5_HASHING)
+			I_hold_cond(&md5cache_cond, md5cache_mutex);
+
+		waitedtime += I_PreciseToMicros(I_GetPreciseTime() - start) / 1000000.0;
+
+		if (entry->valid && entry->size == size && entry->mtime == mtime)
+		{
+			memcpy(md5sum, entry->md5sum, 16);
+			Unlock_state();
+			return true;
+		}
+	}
+#endif
+
+	if (entry && entry->state == MD5_DONE && entry->valid
+		&& entry->size == size && entry->mtime == mtime)
+	{
+		memcpy(md5sum, entry->md5sum, 16);
+		numcached++;
+		savedtime += entry->hashtime / 1000000.0;
+		Unlock_state();
+		return true;
+	}
+
+	// Not cached, or changed since; if it's still queued, do it here
+	if (!entry)
+		entry = AddEntry(filename);
+	entry->size = size;
+	entry->mtime = mtime;
+	entry->state = MD5_HASHING;
+	Unlock_state();
+
+	ok = HashFile(filename, newmd5sum, &hashtime);
+
+	Lock_state();
+	FinishEntry(entry, ok, newmd5sum, hashtime);
+#ifdef HAVE_THREADS
+	I_wake_all_cond(&md5cache_cond);
+#endif
+	Unlock_state();
+
+	if (ok)
+		memcpy(md5sum, newmd5sum, 16);
+	return ok;
+}
+
+void M_SaveMD5Cache(void)
+{
+	FILE *f;
+	UINT32 i;
+
+	Lock_state();
+
+	if (!md5cachedirty)
+	{
+		Unlock_state();
+		return;
+	}
+
+	f = fopen(va("%s" PATHSEP MD5CACHEFILENAME, srb2home), "w");
+	if (f)
+	{
+		fprintf(f, "%s\n", MD5CACHEHEADER);
+
+		for (i = 0; i < MD5CACHEHASHSIZE; i++)
+		{
+			md5entry_t *entry;
+
+			for (entry = md5cache[i]; entry; entry = entry->next)
+			{
+				INT32 j;
+
+				if (entry->state != MD5_DONE || !entry->valid)
+					continue;
+
+				for (j = 0; j < 16; j++)
+					fprintf(f, "%02x", entry->md5sum[j]);
+				fprintf(f, " %lu %ld %u %s\n", entry->size, entry->mtime, entry->hashtime, entry->path);
+			}
+		}
+
+		fclose(f);
+		md5cachedirty = false;
+	}
+
+	Unlock_state();
+}
+
+void M_PrintMD5CacheStats(void)
+{
+	Lock_state();
+
+	if (numhashed || numcached)
+	{
+		CONS_Printf("MD5: hashed %u file%s in %.2fs", numhashed, numhashed == 1 ? "" : "s", hashedtime);
+		if (waitedtime > 0.0)
+			CONS_Printf(" (%.2fs spent waiting for it)", waitedtime);
+		CONS_Printf(", %u cached, saving about %.2fs\n", numcached, savedtime);
+	}
+
+	Unlock_state();
+}
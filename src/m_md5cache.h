@@ -0,0 +1,32 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2022 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  m_md5cache.h
+/// \brief Persistent cache of file MD5s, keyed by path, size and time
+
+#ifndef __M_MD5CACHE__
+#define __M_MD5CACHE__
+
+#include "doomtype.h"
+
+// Fills in the MD5 of a file, only hashing it if it changed since it
+// was last hashed. Returns false if the file couldn't be read.
+boolean M_GetFileMD5(const char *filename, UINT8 *md5sum);
+
+// Starts hashing the files that aren't cached on worker threads,
+// so they're ready by the time M_GetFileMD5 asks for them.
+// Does nothing without threads.
+void M_PrefetchFileMD5s(char **files, size_t numfiles);
+
+// Writes the cache out, if anything was hashed since it was last saved
+void M_SaveMD5Cache(void);
+
+// Prints how much hashing was done and how much was skipped
+void M_PrintMD5CacheStats(void);
+
+#endif // __M_MD5CACHE__
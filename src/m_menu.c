@@ -23,6 +23,7 @@
 #include "d_netcmd.h"
 #include "console.h"
 #include "r_local.h"
+#include "r_fps.h"
 #include "hu_stuff.h"
 #include "hu_font.h"
 #include "g_game.h"
@@ -1688,6 +1689,7 @@ enum
 	op_video_fullscreen,
 #endif
 	op_video_vsync,
+	op_video_fpscap,
 	op_video_renderer,
 };
 
@@ -1698,10 +1700,11 @@ static menuitem_t OP_VideoOptionsMenu[] =
 
 	{IT_STRING | IT_CVAR, NULL, "Fullscreen",                &cv_fullscreen,      11},
 	{IT_STRING | IT_CVAR, NULL, "Vertical Sync",             &cv_vidwait,         16},
+	{IT_STRING | IT_CVAR, NULL, "FPS Cap",                   &cv_fpscap,          21},
 #ifdef HWRENDER
-	{IT_STRING | IT_CVAR, NULL, "Renderer",                  &cv_renderer,        21},
+	{IT_STRING | IT_CVAR, NULL, "Renderer",                  &cv_renderer,        26},
 #else
-	{IT_TRANSTEXT | IT_PAIR,    "Renderer", "Software",      &cv_renderer,        21},
+	{IT_TRANSTEXT | IT_PAIR,    "Renderer", "Software",      &cv_renderer,        26},
 #endif
 
 	{IT_HEADER, NULL, "Color Profile", NULL, 30},
@@ -65,6 +65,7 @@ static ps_metric_t ps_removecount = {0};
 ps_metric_t ps_checkposition_calls = {0};
 
 ps_metric_t ps_lua_thinkframe_time = {0};
+ps_metric_t ps_lua_gctime = {0};
 ps_metric_t ps_lua_mobjhooks = {0};
 
 ps_metric_t ps_otherlogictime = {0};
@@ -102,6 +103,7 @@ perfstatrow_t rendertime_rows[] = {
 	{" portals", " Portals+Skybox:", &ps_sw_portaltime, PS_TIME|PS_LEVEL|PS_SW},
 	{" planes ", " R_DrawPlanes:  ", &ps_sw_planetime, PS_TIME|PS_LEVEL|PS_SW},
 	{" masked ", " R_DrawMasked:  ", &ps_sw_maskedtime, PS_TIME|PS_LEVEL|PS_SW},
+	{" drawq  ", " Threaded draw: ", &ps_sw_drawqueuetime, PS_TIME|PS_LEVEL|PS_SW},
 	{" other  ", " Other:         ", &ps_otherrendertime, PS_TIME|PS_LEVEL|PS_SW},
 
 	{"ui     ", "UI render:     ", &ps_uitime, PS_TIME},
@@ -152,6 +154,7 @@ perfstatrow_t gamelogic_rows[] = {
 	{"  precip ", "  Precipitation:  ", &ps_thlist_times[THINK_PRECIP], PS_TIME|PS_LEVEL},
 	{" lthinkf", " LUAh_ThinkFrame:", &ps_lua_thinkframe_time, PS_TIME|PS_LEVEL},
 	{" other  ", " Other:          ", &ps_otherlogictime, PS_TIME|PS_LEVEL},
+	{"luagc  ", "Lua GC pause:   ", &ps_lua_gctime, PS_TIME},
 	{0}
 };
 
@@ -460,7 +463,8 @@ static void PS_UpdateFrameStats(void)
 				ps_sw_spritecliptime.value.p +
 				ps_sw_portaltime.value.p +
 				ps_sw_planetime.value.p +
-				ps_sw_maskedtime.value.p;
+				ps_sw_maskedtime.value.p +
+				ps_sw_drawqueuetime.value.p;
 		}
 	}
 
@@ -571,6 +575,25 @@ void PS_UpdateTickStats(void)
 			PS_UpdateMetricHistory(&thinkframe_hooks[i].time_taken, true, false, false);
 		}
 	}
+	if (cv_perfstats.value == 4)
+	{
+		int i;
+		for (i = 0; i < ps_lua_numhookstats; i++)
+		{
+			ps_hookstat_t *stat = &ps_lua_hookstats[i];
+
+			stat->calls.value.i = stat->tic_calls;
+			stat->time_taken.value.p = stat->tic_time;
+			stat->tic_calls = 0;
+			stat->tic_time = 0;
+
+			if (cv_ps_samplesize.value > 1)
+			{
+				PS_UpdateMetricHistory(&stat->calls, false, false, false);
+				PS_UpdateMetricHistory(&stat->time_taken, true, false, false);
+			}
+		}
+	}
 	if (cv_perfstats.value && cv_ps_samplesize.value > 1)
 	{
 		ps_tick_index++;
@@ -597,7 +620,7 @@ static void PS_DrawDescriptorHeader(void)
 		int samples_left = max(ps_frame_samples_left, ps_tick_samples_left);
 		int x, y;
 
-		if (cv_perfstats.value == 3)
+		if (cv_perfstats.value >= 3)
 		{
 			x = 2;
 			y = 0;
@@ -761,6 +784,42 @@ if (y > 192) \
 	}
 }
 
+static void PS_DrawLuaHookStats(void)
+{
+	char s[100];
+	int i;
+	// text writing position
+	int x = 2;
+	int y = 4;
+	INT32 calls;
+
+	PS_DrawDescriptorHeader();
+
+	y += 4;
+	V_DrawSmallString(x, y, V_MONOSPACE | V_ALLOWLOWERCASE | V_GRAYMAP, va("%16s %5s %6s", "Hook", "Calls", "Time"));
+	y += 4;
+
+	for (i = 0; i < ps_lua_numhookstats; i++)
+	{
+		calls = PS_GetMetricScreenValue(&ps_lua_hookstats[i].calls, false);
+		if (!calls)
+			continue;
+
+		snprintf(s, sizeof s - 1, "%16s:%5d %6d", ps_lua_hookstats[i].name, calls,
+				PS_GetMetricScreenValue(&ps_lua_hookstats[i].time_taken, true));
+		V_DrawSmallString(x, y, V_MONOSPACE | V_ALLOWLOWERCASE | V_YELLOWMAP, s);
+
+		y += 4;
+		if (y > 192)
+		{
+			y = 8;
+			x += 106;
+			if (x > 214)
+				break;
+		}
+	}
+}
+
 void M_DrawPerfStats(void)
 {
 	if (cv_perfstats.value == 1) // rendering
@@ -791,6 +850,16 @@ void M_DrawPerfStats(void)
 			PS_DrawThinkFrameStats();
 		}
 	}
+	else if (cv_perfstats.value == 4) // lua hooks
+	{
+		if (!PS_HighResolution())
+		{
+			V_DrawThinString(80, 92, V_MONOSPACE | V_ALLOWLOWERCASE | V_YELLOWMAP, "Perfstats 4 is not available");
+			V_DrawThinString(80, 100, V_MONOSPACE | V_ALLOWLOWERCASE | V_YELLOWMAP, "for resolutions below 640x400.");
+		}
+		else
+			PS_DrawLuaHookStats();
+	}
 }
 
 // remove and unallocate history from all metrics
@@ -804,6 +873,11 @@ static void PS_ClearHistory(void)
 	{
 		thinkframe_hooks[i].time_taken.history = NULL;
 	}
+	for (i = 0; i < ps_lua_numhookstats; i++)
+	{
+		ps_lua_hookstats[i].calls.history = NULL;
+		ps_lua_hookstats[i].time_taken.history = NULL;
+	}
 
 	ps_frame_index = ps_tick_index = 0;
 	// PS_UpdateMetricHistory will set these correctly when it runs
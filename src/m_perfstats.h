@@ -31,6 +31,15 @@ typedef struct
 	char short_src[LUA_IDSIZE];
 } ps_hookinfo_t;
 
+typedef struct
+{
+	const char *name;
+	UINT32 tic_calls; // accumulated during the current tic
+	precise_t tic_time;
+	ps_metric_t calls;
+	ps_metric_t time_taken;
+} ps_hookstat_t;
+
 #define PS_START_TIMING(metric) metric.value.p = I_GetPreciseTime()
 #define PS_STOP_TIMING(metric) metric.value.p = I_GetPreciseTime() - metric.value.p
 
@@ -44,8 +53,13 @@ extern ps_metric_t ps_thlist_times[];
 extern ps_metric_t ps_checkposition_calls;
 
 extern ps_metric_t ps_lua_thinkframe_time;
+extern ps_metric_t ps_lua_gctime;
 extern ps_metric_t ps_lua_mobjhooks;
 
+// Per kind of Lua hook, in lua_hooklib.c
+extern ps_hookstat_t ps_lua_hookstats[];
+extern const int ps_lua_numhookstats;
+
 extern ps_metric_t ps_otherlogictime;
 
 void PS_SetThinkFrameHookInfo(int index, precise_t time_taken, char* short_src);
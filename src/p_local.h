@@ -92,6 +92,10 @@ typedef struct camera_s
 	// Info for drawing: position.
 	fixed_t x, y, z;
 
+	// Position and orientation at the start of the tic, for interpolation
+	fixed_t old_x, old_y, old_z;
+	angle_t old_angle, old_aiming;
+
 	//More drawing info: to determine current sprite.
 	angle_t angle; // orientation
 
@@ -4536,6 +4536,10 @@ boolean P_CheckSector(sector_t *sector, boolean crunch)
 static msecnode_t *headsecnode = NULL;
 static mprecipsecnode_t *headprecipsecnode = NULL;
 
+// Where new nodes come from when the freelists run out
+static zpool_t secnodepool = ZPOOL_INIT("Sector nodes", sizeof (msecnode_t), PU_LEVEL, 0);
+static zpool_t precipsecnodepool = ZPOOL_INIT("Precip sector nodes", sizeof (mprecipsecnode_t), PU_LEVEL, 0);
+
 void P_Initsecnode(void)
 {
 	headsecnode = NULL;
@@ -4555,7 +4559,7 @@ static msecnode_t *P_GetSecnode(void)
 		headsecnode = headsecnode->m_thinglist_next;
 	}
 	else
-		node = Z_Calloc(sizeof (*node), PU_LEVEL, NULL);
+		node = Z_PoolAlloc(&secnodepool);
 	return node;
 }
 
@@ -4569,7 +4573,7 @@ static mprecipsecnode_t *P_GetPrecipSecnode(void)
 		headprecipsecnode = headprecipsecnode->m_thinglist_next;
 	}
 	else
-		node = Z_Calloc(sizeof (*node), PU_LEVEL, NULL);
+		node = Z_PoolAlloc(&precipsecnodepool);
 	return node;
 }
 
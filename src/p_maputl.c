@@ -23,6 +23,7 @@
 #include "p_polyobj.h"
 #include "p_slopes.h"
 #include "z_zone.h"
+#include "d_netcmd.h" // cv_thingindex
 
 //
 // P_AproxDistance
@@ -685,6 +686,114 @@ void P_LineOpening(line_t *linedef, mobj_t *mobj)
 // THING POSITION SETTING
 //
 
+//
+// THING INDEX
+//
+// A flat copy of each blockmap cell's thing chain. The chain is still
+// what P_BlockThingsIterator goes by, so the order and what happens
+// when things move during a search are the same; the copy only lets
+// it fetch the next few things into the cache while it checks one,
+// rather than waiting on each bnext in turn.
+//
+// Positions and radii aren't copied for rejecting things early: they
+// are written directly in too many places (A_ actions, P_SetScale,
+// Lua) for a copy to always match, and a check that disagreed with
+// PIT_CheckThing would desync netgames.
+//
+
+typedef struct
+{
+	mobj_t **things; // Opposite to bnext order, so linking adds to the end
+	INT32 count, capacity;
+} thingcell_t;
+
+static thingcell_t *thingcells = NULL; // Freed with the level
+
+static void P_AddToThingCell(mobj_t *thing, INT32 cellnum)
+{
+	thingcell_t *cell = &thingcells[cellnum];
+
+	if (cell->count == cell->capacity)
+	{
+		cell->capacity = cell->capacity ? cell->capacity * 2 : 4;
+		cell->things = Z_Realloc(cell->things, cell->capacity * sizeof (*cell->things), PU_LEVEL, NULL);
+	}
+
+	cell->things[cell->count++] = thing;
+	thing->blockcell = cellnum;
+}
+
+static void P_RemoveFromThingCell(mobj_t *thing)
+{
+	thingcell_t *cell = &thingcells[thing->blockcell];
+	INT32 i;
+
+	// Things that move get relinked, so they're mostly near the end
+	for (i = cell->count - 1; i >= 0; i--)
+	{
+		if (cell->things[i] != thing)
+			continue;
+
+		memmove(&cell->things[i], &cell->things[i+1], (cell->count - i - 1) * sizeof (*cell->things));
+		cell->count--;
+		return;
+	}
+}
+
+static void P_BuildThingIndex(void)
+{
+	INT32 i;
+
+	Z_Calloc(bmapwidth * bmapheight * sizeof (*thingcells), PU_LEVEL, &thingcells);
+
+	for (i = 0; i < bmapwidth * bmapheight; i++)
+	{
+		mobj_t *mobj;
+		INT32 count = 0;
+
+		for (mobj = blocklinks[i]; mobj; mobj = mobj->bnext)
+			count++;
+
+		if (!count)
+			continue;
+
+		thingcells[i].things = Z_Malloc(count * sizeof (*thingcells[i].things), PU_LEVEL, NULL);
+		thingcells[i].count = thingcells[i].capacity = count;
+
+		for (mobj = blocklinks[i]; mobj; mobj = mobj->bnext)
+		{
+			thingcells[i].things[--count] = mobj;
+			mobj->blockcell = i;
+		}
+	}
+}
+
+static void P_FreeThingIndex(void)
+{
+	INT32 i;
+
+	for (i = 0; i < bmapwidth * bmapheight; i++)
+		Z_Free(thingcells[i].things);
+
+	Z_Free(thingcells);
+}
+
+// Called when a level's blockmap is loaded, before anything is linked
+// into it. The last level's index went with the rest of its memory.
+void P_InitThingIndex(void)
+{
+	if (cv_thingindex.value)
+		P_BuildThingIndex();
+}
+
+void P_ThingIndex_OnChange(void)
+{
+	if (cv_thingindex.value && !thingcells && gamestate == GS_LEVEL)
+		P_BuildThingIndex();
+	else if (!cv_thingindex.value && thingcells)
+		P_FreeThingIndex();
+}
+
 //
 // P_UnsetThingPosition
 // Unlinks a thing from block map and sectors.
@@ -744,6 +853,9 @@ void P_UnsetThingPosition(mobj_t *thing)
 		mobj_t *bnext, **bprev = thing->bprev;
 		if (bprev && (*bprev = bnext = thing->bnext) != NULL)  // unlink from block map
 			bnext->bprev = bprev;
+
+		if (bprev && thingcells)
+			P_RemoveFromThingCell(thing);
 	}
 }
 
@@ -829,6 +941,9 @@ void P_SetThingPosition(mobj_t *thing)
 				bnext->bprev = &thing->bnext;
 			thing->bprev = link;
 			*link = thing;
+
+			if (thingcells)
+				P_AddToThingCell(thing, blocky*bmapwidth + blockx);
 		}
 		else // thing is off the map
 			thing->bnext = NULL, thing->bprev = NULL;
@@ -978,13 +1093,33 @@ boolean P_BlockLinesIterator(INT32 x, INT32 y, boolean (*func)(line_t *))
 boolean P_BlockThingsIterator(INT32 x, INT32 y, boolean (*func)(mobj_t *))
 {
 	mobj_t *mobj, *bnext = NULL;
+	thingcell_t *cell = NULL;
+	INT32 ahead = 0;
 
 	if (x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
 		return true;
 
+	if (thingcells)
+	{
+		cell = &thingcells[y*bmapwidth + x];
+		ahead = cell->count - 1;
+	}
+
 	// Check interaction with the objects in the blockmap.
 	for (mobj = blocklinks[y*bmapwidth + x]; mobj; mobj = bnext)
 	{
+		// Fetch the two after this one, in case func takes a while.
+		// If func moves things around, this just fetches the wrong ones.
+		if (cell && --ahead >= 0 && ahead < cell->count)
+		{
+			mobj_t *next = cell->things[ahead];
+			PREFETCH(&next->x);
+			PREFETCH(&next->radius);
+			PREFETCH(&next->flags);
+			if (ahead > 0)
+				PREFETCH(cell->things[ahead - 1]);
+		}
+
 		P_SetTarget(&bnext, mobj->bnext); // We want to note our reference to bnext here incase it is MF_NOTHINK and gets removed!
 		if (!func(mobj))
 		{
@@ -19,6 +19,7 @@
 #include "p_local.h"
 #include "p_setup.h"
 #include "r_main.h"
+#include "r_fps.h"
 #include "r_skins.h"
 #include "r_sky.h"
 #include "r_splats.h"
@@ -40,6 +41,10 @@ consvar_t cv_movebob = CVAR_INIT ("movebob", "1.0", CV_FLOAT|CV_SAVE, CV_BobSpee
 
 actioncache_t actioncachehead;
 
+// Mobjs start on cache lines, since P_MobjThinker goes through a lot of them
+zpool_t mobjpool = ZPOOL_INIT("Mobjs", sizeof (mobj_t), PU_LEVEL, 6);
+zpool_t precipmobjpool = ZPOOL_INIT("Precipitation", sizeof (precipmobj_t), PU_LEVEL, 0);
+
 static mobj_t *overlaycap = NULL;
 
 void P_InitCachedActions(void)
@@ -10547,7 +10552,7 @@ mobj_t *P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type)
 		return NULL;
 	}
 
-	mobj = Z_Calloc(sizeof (*mobj), PU_LEVEL, NULL);
+	mobj = Z_PoolAlloc(&mobjpool);
 
 	// this is officially a mobj, declared as soon as possible.
 	mobj->thinker.function.acp1 = (actionf_p1)P_MobjThinker;
@@ -10928,13 +10933,15 @@ mobj_t *P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type)
 	if (CheckForReverseGravity && !(mobj->flags & MF_NOBLOCKMAP))
 		P_CheckGravity(mobj, false);
 
+	R_ResetMobjInterpolationState(mobj);
+
 	return mobj;
 }
 
 static precipmobj_t *P_SpawnPrecipMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type)
 {
 	state_t *st;
-	precipmobj_t *mobj = Z_Calloc(sizeof (*mobj), PU_LEVEL, NULL);
+	precipmobj_t *mobj = Z_PoolAlloc(&precipmobjpool);
 	fixed_t starting_floorz;
 
 	mobj->x = x;
@@ -10968,6 +10975,8 @@ static precipmobj_t *P_SpawnPrecipMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype
 
 	CalculatePrecipFloor(mobj);
 
+	R_ResetPrecipitationMobjInterpolationState(mobj);
+
 	if (mobj->floorz != starting_floorz)
 		mobj->precipflags |= PCF_FOF;
 	else if (GETSECSPECIAL(mobj->subsector->sector->special, 1) == 7
@@ -11555,6 +11564,7 @@ void P_AfterPlayerSpawn(INT32 playernum)
 		p->viewz = p->mo->z + p->mo->height - p->viewheight;
 	else
 		p->viewz = p->mo->z + p->viewheight;
+	p->old_viewz = p->viewz;
 
 	if (playernum == consoleplayer)
 	{
@@ -11660,6 +11670,7 @@ void P_MovePlayerToSpawn(INT32 playernum, mapthing_t *mthing)
 		mobj->eflags |= MFE_ONGROUND;
 
 	mobj->angle = angle;
+	R_ResetMobjInterpolationState(mobj);
 
 	P_AfterPlayerSpawn(playernum);
 }
@@ -11709,6 +11720,7 @@ void P_MovePlayerToStarpost(INT32 playernum)
 	mobj->z = z;
 
 	mobj->angle = p->starpostangle;
+	R_ResetMobjInterpolationState(mobj);
 
 	P_AfterPlayerSpawn(playernum);
 
@@ -11810,10 +11822,9 @@ fixed_t P_GetMapThingSpawnHeight(const mobjtype_t mobjtype, const mapthing_t* mt
 
 static boolean P_SpawnNonMobjMapThing(mapthing_t *mthing)
 {
-#if MAXPLAYERS > 32
-	You should think about modifying the deathmatch starts to take full advantage of this!
-#endif
-	if (mthing->type <= MAXPLAYERS) // Player starts
+	// Maps only have 32 player starts, with match starts from 33, so
+	// builds with more players share them (see G_FindCoopStart)
+	if (mthing->type <= 32) // Player starts
 	{
 		// save spots for respawning in network games
 		if (!metalrecording)
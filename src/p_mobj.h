@@ -28,6 +28,9 @@
 // Needs precompiled tables/data structures.
 #include "info.h"
 
+// Mobjs come from pools.
+#include "z_zone.h"
+
 //
 // NOTES: mobj_t
 //
@@ -281,6 +284,7 @@ typedef struct mobj_s
 
 	// Info for drawing: position.
 	fixed_t x, y, z;
+	fixed_t old_x, old_y, old_z; // position at the start of the tic, for interpolation
 
 	// More list: links in sector (if needed)
 	struct mobj_s *snext;
@@ -288,6 +292,7 @@ typedef struct mobj_s
 
 	// More drawing info: to determine current sprite.
 	angle_t angle, pitch, roll; // orientation
+	angle_t old_angle; // for interpolation
 	angle_t rollangle;
 	spritenum_t sprite; // used to find patch_t and flip value
 	UINT32 frame; // frame number, plus bits see p_pspr.h
@@ -333,6 +338,7 @@ typedef struct mobj_s
 	// Links in blocks (if needed).
 	struct mobj_s *bnext;
 	struct mobj_s **bprev; // killough 8/11/98: change to ptr-to-ptr
+	INT32 blockcell; // Where it is in the thing index, if that's on
 
 	// Additional pointers for NiGHTS hoops
 	struct mobj_s *hnext;
@@ -408,6 +414,7 @@ typedef struct precipmobj_s
 
 	// Info for drawing: position.
 	fixed_t x, y, z;
+	fixed_t old_x, old_y, old_z; // position at the start of the tic, for interpolation
 
 	// More list: links in sector (if needed)
 	struct precipmobj_s *snext;
@@ -415,6 +422,7 @@ typedef struct precipmobj_s
 
 	// More drawing info: to determine current sprite.
 	angle_t angle, pitch, roll; // orientation
+	angle_t old_angle; // for interpolation
 	angle_t rollangle;
 	spritenum_t sprite; // used to find patch_t and flip value
 	UINT32 frame; // frame number, plus bits see p_pspr.h
@@ -460,6 +468,8 @@ typedef struct actioncache_s
 
 extern actioncache_t actioncachehead;
 
+extern zpool_t mobjpool, precipmobjpool;
+
 void P_InitCachedActions(void);
 void P_RunCachedActions(void);
 void P_AddCachedAction(mobj_t *mobj, INT32 statenum);
@@ -18,6 +18,7 @@
 #include "g_game.h"
 #include "m_random.h"
 #include "m_misc.h"
+#include "i_system.h"
 #include "p_local.h"
 #include "p_setup.h"
 #include "p_saveg.h"
@@ -30,6 +31,7 @@
 #include "y_inter.h"
 #include "z_zone.h"
 #include "r_main.h"
+#include "r_fps.h"
 #include "r_sky.h"
 #include "p_polyobj.h"
 #include "lua_script.h"
@@ -2615,6 +2617,58 @@ static void P_NetArchiveThinkers(void)
 	}
 }
 
+// Mobjs by the mobjnum they were saved with, while a netgame is being
+// loaded, so each pointer between them is relinked without a search
+static mobj_t **loadedmobjs = NULL;
+static UINT32 loadedmobjssize = 0;
+static UINT32 numloadedmobjs = 0;
+static boolean loadedmobjsready = false;
+
+static void ClearLoadedMobjs(void)
+{
+	if (loadedmobjs)
+		memset(loadedmobjs, 0, loadedmobjssize * sizeof (*loadedmobjs));
+	numloadedmobjs = 0;
+	loadedmobjsready = true;
+}
+
+static void FreeLoadedMobjs(void)
+{
+	free(loadedmobjs);
+	loadedmobjs = NULL;
+	loadedmobjssize = 0;
+	numloadedmobjs = 0;
+	loadedmobjsready = false;
+}
+
+static void AddLoadedMobj(mobj_t *mobj)
+{
+	const UINT32 num = mobj->mobjnum;
+
+	// Saved mobjs are numbered from 1 in the order they're saved, so
+	// a number past how many there are so far is a stale one from a
+	// mobj that isn't numbered, like a hoop
+	if (!num || num > ++numloadedmobjs)
+		return;
+
+	if (num >= loadedmobjssize)
+	{
+		UINT32 newsize = max(loadedmobjssize * 2, 1024);
+		mobj_t **newmobjs = realloc(loadedmobjs, newsize * sizeof (*loadedmobjs));
+
+		if (!newmobjs)
+			I_Error("AddLoadedMobj: No more memory\n");
+
+		memset(newmobjs + loadedmobjssize, 0, (newsize - loadedmobjssize) * sizeof (*loadedmobjs));
+		loadedmobjs = newmobjs;
+		loadedmobjssize = newsize;
+	}
+
+	// The first one wins, like when searching the list
+	if (!loadedmobjs[num])
+		loadedmobjs[num] = mobj;
+}
+
 // Now save the pointers, tracer and target, but at load time we must
 // relink to this; the savegame contains the old position in the pointer
 // field copyed in the info field temporarily, but finally we just search
@@ -2624,6 +2678,16 @@ mobj_t *P_FindNewPosition(UINT32 oldposition)
 	thinker_t *th;
 	mobj_t *mobj;
 
+	if (loadedmobjsready)
+	{
+		mobj = (oldposition < loadedmobjssize) ? loadedmobjs[oldposition] : NULL;
+		if (mobj && mobj->thinker.function.acp1 != (actionf_p1)P_RemoveThinkerDelayed)
+			return mobj;
+
+		CONS_Debug(DBG_GAMELOGIC, "mobj not found\n");
+		return NULL;
+	}
+
 	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
 	{
 		if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
@@ -2721,13 +2785,13 @@ static thinker_t* LoadMobjThinker(actionf_p1 thinker)
 			return NULL;
 		}
 
-		mobj = Z_Calloc(sizeof (*mobj), PU_LEVEL, NULL);
+		mobj = Z_PoolAlloc(&mobjpool);
 
 		mobj->spawnpoint = &mapthings[spawnpointnum];
 		mapthings[spawnpointnum].mobj = mobj;
 	}
 	else
-		mobj = Z_Calloc(sizeof (*mobj), PU_LEVEL, NULL);
+		mobj = Z_PoolAlloc(&mobjpool);
 
 	// declare this as a valid mobj as soon as possible.
 	mobj->thinker.function.acp1 = thinker;
@@ -2958,6 +3022,9 @@ static thinker_t* LoadMobjThinker(actionf_p1 thinker)
 	P_SetThingPosition(mobj);
 
 	mobj->mobjnum = READUINT32(save_p);
+	AddLoadedMobj(mobj);
+
+	R_ResetMobjInterpolationState(mobj);
 
 	if (mobj->player)
 	{
@@ -3588,6 +3655,7 @@ static void P_NetUnArchiveThinkers(void)
 	// we don't want the removed mobjs to come back
 	iquetail = iquehead = 0;
 	P_InitThinkers();
+	ClearLoadedMobjs();
 
 	// clear sector thinker pointers so they don't point to non-existant thinkers for all of eternity
 	for (i = 0; i < numsectors; i++)
@@ -4148,10 +4216,13 @@ static void P_NetArchiveMisc(boolean resending)
 	WRITEINT16(save_p, gamestate);
 	WRITEINT16(save_p, gametype);
 
+	// One word for every 32 players
+	for (i = 0; i < MAXPLAYERS; i += 32)
 	{
 		UINT32 pig = 0;
-		for (i = 0; i < MAXPLAYERS; i++)
-			pig |= (playeringame[i] != 0)<<i;
+		INT32 j;
+		for (j = 0; j < 32; j++)
+			pig |= (UINT32)(playeringame[i + j] != 0)<<j;
 		WRITEUINT32(save_p, pig);
 	}
 
@@ -4240,11 +4311,13 @@ static inline boolean P_NetUnArchiveMisc(boolean reloading)
 
 	gametype = READINT16(save_p);
 
+	for (i = 0; i < MAXPLAYERS; i += 32)
 	{
 		UINT32 pig = READUINT32(save_p);
-		for (i = 0; i < MAXPLAYERS; i++)
+		INT32 j;
+		for (j = 0; j < 32; j++)
 		{
-			playeringame[i] = (pig & (1<<i)) != 0;
+			playeringame[i + j] = (pig & (1u<<j)) != 0;
 			// playerstate is set in unarchiveplayers
 		}
 	}
@@ -4425,6 +4498,8 @@ boolean P_LoadGame(INT16 mapoverride)
 
 boolean P_LoadNetGame(boolean reloading)
 {
+	precise_t start = I_GetPreciseTime(), thinkerstart = 0, thinkerend = 0;
+
 	CV_LoadNetVars(&save_p);
 	if (!P_NetUnArchiveMisc(reloading))
 		return false;
@@ -4433,15 +4508,21 @@ boolean P_LoadNetGame(boolean reloading)
 	{
 		P_NetUnArchiveWorld();
 		P_UnArchivePolyObjects();
+		thinkerstart = I_GetPreciseTime();
 		P_NetUnArchiveThinkers();
 		P_NetUnArchiveSpecials();
 		P_NetUnArchiveColormaps();
 		P_NetUnArchiveWaypoints();
 		P_RelinkPointers();
 		P_FinishMobjs();
+		thinkerend = I_GetPreciseTime();
 	}
 	LUA_UnArchive();
 
+	CONS_Debug(DBG_NETPLAY, "Gamestate loaded in %d us, %d of it for %u mobjs\n",
+		I_PreciseToMicros(I_GetPreciseTime() - start), I_PreciseToMicros(thinkerend - thinkerstart), numloadedmobjs);
+	FreeLoadedMobjs();
+
 	// This is stupid and hacky, but maybe it'll work!
 	P_SetRandSeed(P_GetInitSeed());
 
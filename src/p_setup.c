@@ -2946,6 +2946,8 @@ static void P_LoadMapLUT(const virtres_t *virt)
 
 	if (!(virtblockmap && P_LoadBlockMap(virtblockmap->data, virtblockmap->size)))
 		P_CreateBlockMap();
+
+	P_InitThingIndex();
 }
 
 //
@@ -3699,6 +3701,7 @@ static void P_RunLevelScript(const char *scriptname)
 	{
 		lumpnum_t lumpnum;
 		char newname[9];
+		char *text;
 
 		strncpy(newname, scriptname, 8);
 
@@ -3712,7 +3715,9 @@ static void P_RunLevelScript(const char *scriptname)
 			return;
 		}
 
-		COM_BufInsertText(W_CacheLumpNum(lumpnum, PU_CACHE));
+		text = W_CacheTextLump(lumpnum, PU_STATIC);
+		COM_BufInsertText(text);
+		Z_Free(text);
 	}
 	else
 	{
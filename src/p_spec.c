@@ -2542,6 +2542,7 @@ static void P_ProcessLineSpecial(line_t *line, mobj_t *mo, sector_t *callsec)
 				INT32 scrnum;
 				lumpnum_t lumpnum;
 				char newname[9];
+				char *text;
 
 				strcpy(newname, G_BuildMapName(gamemap));
 				newname[0] = 'S';
@@ -2569,7 +2570,11 @@ static void P_ProcessLineSpecial(line_t *line, mobj_t *mo, sector_t *callsec)
 					CONS_Debug(DBG_SETUP, "SOC Error: script lump %s not found/not valid.\n", newname);
 				}
 				else
-					COM_BufInsertText(W_CacheLumpNum(lumpnum, PU_CACHE));
+				{
+					text = W_CacheTextLump(lumpnum, PU_STATIC);
+					COM_BufInsertText(text);
+					Z_Free(text);
+				}
 			}
 			break;
 
@@ -17,6 +17,7 @@
 #include "r_state.h"
 #include "s_sound.h"
 #include "r_main.h"
+#include "r_fps.h"
 
 /**	\brief	The P_MixUp function
 
@@ -176,5 +177,10 @@ boolean P_Teleport(mobj_t *thing, fixed_t x, fixed_t y, fixed_t z, angle_t angle
 
 	thing->angle = angle;
 
+	// Don't interpolate from the teleport's starting point
+	R_ResetMobjInterpolationState(thing);
+	if (thing->player)
+		thing->player->old_viewz = thing->player->viewz;
+
 	return true;
 }
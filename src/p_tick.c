@@ -22,7 +22,9 @@
 #include "lua_script.h"
 #include "lua_hook.h"
 #include "m_perfstats.h"
+#include "r_fps.h"
 #include "i_system.h" // I_GetPreciseTime
+#include "d_netcmd.h" // cv_batchthinkers
 
 // Object place
 #include "m_cheat.h"
@@ -318,18 +320,77 @@ if ((*mop = targ) != NULL) // Set new target and if non-NULL, increase its count
 // Rewritten to delete nodes implicitly, by making currentthinker
 // external and using P_RemoveThinkerDelayed() implicitly.
 //
+// With batchthinkers on, the mobj and precipitation lists are run
+// by the loops below instead. They run the same thinkers in the same
+// order, so demos and netgames stay in sync either way, but:
+// - P_MobjThinker is called directly, and not at all for MF_NOTHINK
+//   mobjs, which it would return from straight away;
+// - P_NullPrecipThinker, which is all precipitation has between
+//   renders, is done inline;
+// - the next thinker is fetched into the cache while this one runs.
+// Mobjs come from a pool, so the ones spawned together are mostly
+// together in memory as well; ps_thlist_times shows the difference.
+//
+static void P_RunMobjThinkers(void)
+{
+	thinker_t *head = &thlist[THINK_MOBJ];
+
+	for (currentthinker = head->next; currentthinker != head; currentthinker = currentthinker->next)
+	{
+		PREFETCH(currentthinker->next->next);
+#ifdef PARANOIA
+		I_Assert(currentthinker->function.acp1 != NULL);
+#endif
+
+		if (currentthinker->function.acp1 == (actionf_p1)P_MobjThinker)
+		{
+			mobj_t *mobj = (mobj_t *)currentthinker;
+
+			if (!(mobj->flags & MF_NOTHINK))
+				P_MobjThinker(mobj);
+		}
+		else
+			currentthinker->function.acp1(currentthinker);
+	}
+}
+
+static void P_RunPrecipThinkers(void)
+{
+	thinker_t *head = &thlist[THINK_PRECIP];
+
+	for (currentthinker = head->next; currentthinker != head; currentthinker = currentthinker->next)
+	{
+		PREFETCH(currentthinker->next->next);
+#ifdef PARANOIA
+		I_Assert(currentthinker->function.acp1 != NULL);
+#endif
+
+		if (currentthinker->function.acp1 == (actionf_p1)P_NullPrecipThinker)
+			((precipmobj_t *)currentthinker)->precipflags &= ~PCF_THUNK;
+		else
+			currentthinker->function.acp1(currentthinker);
+	}
+}
+
 static inline void P_RunThinkers(void)
 {
 	size_t i;
 	for (i = 0; i < NUM_THINKERLISTS; i++)
 	{
 		PS_START_TIMING(ps_thlist_times[i]);
-		for (currentthinker = thlist[i].next; currentthinker != &thlist[i]; currentthinker = currentthinker->next)
+		if (cv_batchthinkers.value && i == THINK_MOBJ)
+			P_RunMobjThinkers();
+		else if (cv_batchthinkers.value && i == THINK_PRECIP)
+			P_RunPrecipThinkers();
+		else
 		{
+			for (currentthinker = thlist[i].next; currentthinker != &thlist[i]; currentthinker = currentthinker->next)
+			{
 #ifdef PARANOIA
-			I_Assert(currentthinker->function.acp1 != NULL);
+				I_Assert(currentthinker->function.acp1 != NULL);
 #endif
-			currentthinker->function.acp1(currentthinker);
+				currentthinker->function.acp1(currentthinker);
+			}
 		}
 		PS_STOP_TIMING(ps_thlist_times[i]);
 	}
@@ -640,6 +701,9 @@ void P_Ticker(boolean run)
 
 	if (run)
 	{
+		// Remember where everything was before this tic
+		R_UpdateInterpolators();
+
 		if (demorecording)
 			G_WriteDemoTiccmd(&players[consoleplayer].cmd, 0);
 		if (demoplayback)
@@ -21,6 +21,7 @@
 #include "g_game.h"
 #include "p_local.h"
 #include "r_main.h"
+#include "r_fps.h"
 #include "s_sound.h"
 #include "r_skins.h"
 #include "d_think.h"
@@ -9738,6 +9739,8 @@ void P_ResetCamera(player_t *player, camera_t *thiscam)
 	thiscam->height = 16*FRACUNIT;
 
 	while (!P_MoveChaseCamera(player,thiscam,true) && ++tries < 2*TICRATE);
+
+	R_ResetCameraInterpolationState(thiscam);
 }
 
 boolean P_MoveChaseCamera(player_t *player, camera_t *thiscam, boolean resetcalled)
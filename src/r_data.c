@@ -23,6 +23,7 @@
 #include "r_patch.h"
 #include "r_picformats.h"
 #include "w_wad.h"
+#include "w_decompress.h"
 #include "z_zone.h"
 #include "p_setup.h" // levelflats
 #include "v_video.h" // pMasterPalette
@@ -1243,11 +1244,8 @@ void R_PrecacheLevel(void)
 	if (rendermode != render_soft)
 		return;
 
-	// Precache flats.
-	flatmemory = P_PrecacheLevelFlats();
-
 	//
-	// Precache textures.
+	// Find the textures and sprites the level uses.
 	//
 	// no need to precache all software textures in 3D mode
 	// (note they are still used with the reference software view)
@@ -1270,6 +1268,62 @@ void R_PrecacheLevel(void)
 	// while the sky texture is stored like a wall texture, with a skynum dependent name.
 	texturepresent[skytexture] = 1;
 
+	spritepresent = calloc(numsprites, sizeof (*spritepresent));
+	if (spritepresent == NULL) I_Error("%s: Out of memory looking up sprites", "R_PrecacheLevel");
+
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
+		if (th->function.acp1 != (actionf_p1)P_RemoveThinkerDelayed)
+			spritepresent[((mobj_t *)th)->sprite] = 1;
+
+	//
+	// Start decompressing all of it in the background,
+	// so it's ready by the time it gets cached below.
+	//
+	for (i = 0; i < numlevelflats; i++)
+		if (levelflats[i].type == LEVELFLAT_FLAT)
+			W_PrefetchLump(levelflats[i].u.flat.lumpnum);
+
+	for (j = 0; j < (unsigned)numtextures; j++)
+	{
+		if (!texturepresent[j] || texturecache[j])
+			continue;
+
+		for (k = 0; k < (unsigned)textures[j]->patchcount; k++)
+			W_PrefetchLumpPwad(textures[j]->patches[k].wad, textures[j]->patches[k].lump);
+	}
+
+	for (i = 0; i < numsprites; i++)
+	{
+		if (!spritepresent[i])
+			continue;
+
+		for (j = 0; j < sprites[i].numframes; j++)
+		{
+			sf = &sprites[i].spriteframes[j];
+			switch (sf->rotate)
+			{
+				case SRF_SINGLE:
+					W_PrefetchLump(sf->lumppat[0]);
+					break;
+				case SRF_2D:
+					W_PrefetchLump(sf->lumppat[2]);
+					W_PrefetchLump(sf->lumppat[6]);
+					break;
+				default:
+					k = (sf->rotate & SRF_3DGE ? 16 : 8);
+					while (k--)
+						W_PrefetchLump(sf->lumppat[k]);
+					break;
+			}
+		}
+	}
+
+	// Precache flats.
+	flatmemory = P_PrecacheLevelFlats();
+
+	//
+	// Precache textures.
+	//
 	texturememory = 0;
 	for (j = 0; j < (unsigned)numtextures; j++)
 	{
@@ -1286,13 +1340,6 @@ void R_PrecacheLevel(void)
 	//
 	// Precache sprites.
 	//
-	spritepresent = calloc(numsprites, sizeof (*spritepresent));
-	if (spritepresent == NULL) I_Error("%s: Out of memory looking up sprites", "R_PrecacheLevel");
-
-	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
-		if (th->function.acp1 != (actionf_p1)P_RemoveThinkerDelayed)
-			spritepresent[((mobj_t *)th)->sprite] = 1;
-
 	spritememory = 0;
 	for (i = 0; i < numsprites; i++)
 	{
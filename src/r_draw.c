@@ -62,13 +62,13 @@ UINT8 *topleft;
 //                      COLUMN DRAWING CODE STUFF
 // =========================================================================
 
-lighttable_t *dc_colormap;
-INT32 dc_x = 0, dc_yl = 0, dc_yh = 0;
+RENDERLOCAL lighttable_t *dc_colormap;
+RENDERLOCAL INT32 dc_x = 0, dc_yl = 0, dc_yh = 0;
 
-fixed_t dc_iscale, dc_texturemid;
-UINT8 dc_hires; // under MSVC boolean is a byte, while on other systems, it a bit,
-               // soo lets make it a byte on all system for the ASM code
-UINT8 *dc_source;
+RENDERLOCAL fixed_t dc_iscale, dc_texturemid;
+RENDERLOCAL UINT8 dc_hires; // under MSVC boolean is a byte, while on other systems, it a bit,
+                           // soo lets make it a byte on all system for the ASM code
+RENDERLOCAL UINT8 *dc_source;
 
 // -----------------------
 // translucency stuff here
@@ -80,7 +80,7 @@ UINT8 *blendtables[NUMBLENDMAPS];
 
 /**	\brief R_DrawTransColumn uses this
 */
-UINT8 *dc_transmap; // one of the translucency tables
+RENDERLOCAL UINT8 *dc_transmap; // one of the translucency tables
 
 // ----------------------
 // translation stuff here
@@ -89,37 +89,39 @@ UINT8 *dc_transmap; // one of the translucency tables
 
 /**	\brief R_DrawTranslatedColumn uses this
 */
-UINT8 *dc_translation;
+RENDERLOCAL UINT8 *dc_translation;
 
 struct r_lightlist_s *dc_lightlist = NULL;
-INT32 dc_numlights = 0, dc_maxlights, dc_texheight;
+INT32 dc_numlights = 0, dc_maxlights;
+RENDERLOCAL INT32 dc_texheight;
 
 // =========================================================================
 //                      SPAN DRAWING CODE STUFF
 // =========================================================================
 
-INT32 ds_y, ds_x1, ds_x2;
-lighttable_t *ds_colormap;
-lighttable_t *ds_translation; // Lactozilla: Sprite splat drawer
+RENDERLOCAL INT32 ds_y, ds_x1, ds_x2;
+RENDERLOCAL lighttable_t *ds_colormap;
+RENDERLOCAL lighttable_t *ds_translation; // Lactozilla: Sprite splat drawer
 
-fixed_t ds_xfrac, ds_yfrac, ds_xstep, ds_ystep;
-INT32 ds_waterofs, ds_bgofs;
+RENDERLOCAL fixed_t ds_xfrac, ds_yfrac, ds_xstep, ds_ystep;
+RENDERLOCAL INT32 ds_waterofs, ds_bgofs;
 
-UINT16 ds_flatwidth, ds_flatheight;
-boolean ds_powersoftwo;
+RENDERLOCAL UINT16 ds_flatwidth, ds_flatheight;
+RENDERLOCAL boolean ds_powersoftwo;
 
-UINT8 *ds_source; // points to the start of a flat
-UINT8 *ds_transmap; // one of the translucency tables
+RENDERLOCAL UINT8 *ds_source; // points to the start of a flat
+RENDERLOCAL UINT8 *ds_transmap; // one of the translucency tables
 
 // Vectors for Software's tilted slope drawers
 floatv3_t *ds_su, *ds_sv, *ds_sz;
-floatv3_t *ds_sup, *ds_svp, *ds_szp;
-float focallengthf, zeroheight;
+RENDERLOCAL floatv3_t *ds_sup, *ds_svp, *ds_szp;
+float focallengthf;
+RENDERLOCAL float zeroheight;
 
 /**	\brief Variable flat sizes
 */
 
-UINT32 nflatxshift, nflatyshift, nflatshiftup, nflatmask;
+RENDERLOCAL UINT32 nflatxshift, nflatyshift, nflatshiftup, nflatmask;
 
 // =========================================================================
 //                   TRANSLATION COLORMAP CODE
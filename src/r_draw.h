@@ -29,42 +29,44 @@ extern UINT8 *topleft;
 // COLUMN DRAWING CODE STUFF
 // -------------------------
 
-extern lighttable_t *dc_colormap;
-extern INT32 dc_x, dc_yl, dc_yh;
-extern fixed_t dc_iscale, dc_texturemid;
-extern UINT8 dc_hires;
+// Everything the drawers read is RENDERLOCAL, so each render thread has its own copy.
 
-extern UINT8 *dc_source; // first pixel in a column
+extern RENDERLOCAL lighttable_t *dc_colormap;
+extern RENDERLOCAL INT32 dc_x, dc_yl, dc_yh;
+extern RENDERLOCAL fixed_t dc_iscale, dc_texturemid;
+extern RENDERLOCAL UINT8 dc_hires;
+
+extern RENDERLOCAL UINT8 *dc_source; // first pixel in a column
 
 // translucency stuff here
-extern UINT8 *dc_transmap;
+extern RENDERLOCAL UINT8 *dc_transmap;
 
 // translation stuff here
 
-extern UINT8 *dc_translation;
+extern RENDERLOCAL UINT8 *dc_translation;
 
 extern struct r_lightlist_s *dc_lightlist;
 extern INT32 dc_numlights, dc_maxlights;
 
 //Fix TUTIFRUTI
-extern INT32 dc_texheight;
+extern RENDERLOCAL INT32 dc_texheight;
 
 // -----------------------
 // SPAN DRAWING CODE STUFF
 // -----------------------
 
-extern INT32 ds_y, ds_x1, ds_x2;
-extern lighttable_t *ds_colormap;
-extern lighttable_t *ds_translation;
+extern RENDERLOCAL INT32 ds_y, ds_x1, ds_x2;
+extern RENDERLOCAL lighttable_t *ds_colormap;
+extern RENDERLOCAL lighttable_t *ds_translation;
 
-extern fixed_t ds_xfrac, ds_yfrac, ds_xstep, ds_ystep;
-extern INT32 ds_waterofs, ds_bgofs;
+extern RENDERLOCAL fixed_t ds_xfrac, ds_yfrac, ds_xstep, ds_ystep;
+extern RENDERLOCAL INT32 ds_waterofs, ds_bgofs;
 
-extern UINT16 ds_flatwidth, ds_flatheight;
-extern boolean ds_powersoftwo;
+extern RENDERLOCAL UINT16 ds_flatwidth, ds_flatheight;
+extern RENDERLOCAL boolean ds_powersoftwo;
 
-extern UINT8 *ds_source;
-extern UINT8 *ds_transmap;
+extern RENDERLOCAL UINT8 *ds_source;
+extern RENDERLOCAL UINT8 *ds_transmap;
 
 typedef struct {
 	float x, y, z;
@@ -72,14 +74,15 @@ typedef struct {
 
 // Vectors for Software's tilted slope drawers
 extern floatv3_t *ds_su, *ds_sv, *ds_sz;
-extern floatv3_t *ds_sup, *ds_svp, *ds_szp;
-extern float focallengthf, zeroheight;
+extern RENDERLOCAL floatv3_t *ds_sup, *ds_svp, *ds_szp;
+extern float focallengthf;
+extern RENDERLOCAL float zeroheight;
 
 // Variable flat sizes
-extern UINT32 nflatxshift;
-extern UINT32 nflatyshift;
-extern UINT32 nflatshiftup;
-extern UINT32 nflatmask;
+extern RENDERLOCAL UINT32 nflatxshift;
+extern RENDERLOCAL UINT32 nflatyshift;
+extern RENDERLOCAL UINT32 nflatshiftup;
+extern RENDERLOCAL UINT32 nflatmask;
 
 /// \brief Top border
 #define BRDR_T 0
@@ -195,7 +198,7 @@ void R_DrawTiltedFloorSprite_8(void);
 void R_DrawTiltedTranslucentFloorSprite_8(void);
 
 void R_CalcTiltedLighting(fixed_t start, fixed_t end);
-extern INT32 tiltlighting[MAXVIDWIDTH];
+extern RENDERLOCAL INT32 tiltlighting[MAXVIDWIDTH];
 
 void R_DrawTranslucentWaterSpan_8(void);
 void R_DrawTiltedTranslucentWaterSpan_8(void);
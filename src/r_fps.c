@@ -0,0 +1,329 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2022 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  r_fps.c
+/// \brief Uncapped framerate and frame interpolation
+
+#include "r_fps.h"
+
+#include "doomstat.h"
+#include "d_main.h"
+#include "g_game.h"
+#include "i_video.h"
+#include "m_misc.h" // moviemode
+#include "p_polyobj.h"
+#include "r_main.h"
+#include "z_zone.h"
+
+static CV_PossibleValue_t fpscap_cons_t[] = {{TICRATE, "MIN"}, {300, "MAX"}, {0, "Unlimited"}, {0, NULL}};
+consvar_t cv_fpscap = CVAR_INIT ("fpscap", "35", CV_SAVE, fpscap_cons_t, NULL);
+
+fixed_t rendertimefrac = FRACUNIT;
+
+// Sector plane heights at the start of the current tic
+typedef struct
+{
+	fixed_t oldfloorheight, oldceilingheight;
+	fixed_t floorheight, ceilingheight; // real heights, while a frame is being drawn
+} sectorinterp_t;
+
+static sectorinterp_t *sectorinterps = NULL;
+static size_t numsectorinterps = 0;
+
+// Polyobject vertex positions at the start of the current tic
+typedef struct
+{
+	fixed_t oldx, oldy;
+	fixed_t x, y; // real positions, while a frame is being drawn
+} vertexinterp_t;
+
+static vertexinterp_t *polyvertexinterps = NULL;
+static size_t numpolyvertexinterps = 0;
+
+static boolean levelinterpolated = false;
+
+UINT32 R_GetFramerateCap(void)
+{
+	if (dedicated || rendermode == render_none)
+		return TICRATE;
+
+	return cv_fpscap.value;
+}
+
+boolean R_UsingFrameInterpolation(void)
+{
+	// Movies and timedemos are recorded one frame per tic
+	if (moviemode || singletics)
+		return false;
+
+	return (R_GetFramerateCap() != TICRATE);
+}
+
+static inline fixed_t R_LerpFixed(fixed_t from, fixed_t to, fixed_t frac)
+{
+	// Map coordinates can be far enough apart to overflow a 32-bit difference
+	return from + (fixed_t)((((INT64)to - (INT64)from) * frac) >> FRACBITS);
+}
+
+static inline angle_t R_LerpAngle(angle_t from, angle_t to, fixed_t frac)
+{
+	// Turn through the shortest arc
+	return from + (angle_t)FixedMul(frac, (INT32)(to - from));
+}
+
+fixed_t R_InterpolateFixed(fixed_t from, fixed_t to)
+{
+	if (rendertimefrac >= FRACUNIT)
+		return to;
+
+	return R_LerpFixed(from, to, rendertimefrac);
+}
+
+angle_t R_InterpolateAngle(angle_t from, angle_t to)
+{
+	if (rendertimefrac >= FRACUNIT)
+		return to;
+
+	return R_LerpAngle(from, to, rendertimefrac);
+}
+
+void R_InterpolateMobjState(mobj_t *mobj, fixed_t frac, interpmobjstate_t *out)
+{
+	// MF_NOTHINK objects aren't in the thinker list, so they never get snapshotted
+	if (frac >= FRACUNIT || (mobj->flags & MF_NOTHINK))
+	{
+		out->x = mobj->x;
+		out->y = mobj->y;
+		out->z = mobj->z;
+		out->angle = mobj->angle;
+		return;
+	}
+
+	out->x = R_LerpFixed(mobj->old_x, mobj->x, frac);
+	out->y = R_LerpFixed(mobj->old_y, mobj->y, frac);
+	out->z = R_LerpFixed(mobj->old_z, mobj->z, frac);
+	out->angle = R_LerpAngle(mobj->old_angle, mobj->angle, frac);
+}
+
+void R_InterpolatePrecipMobjState(precipmobj_t *mobj, fixed_t frac, interpmobjstate_t *out)
+{
+	if (frac >= FRACUNIT)
+	{
+		out->x = mobj->x;
+		out->y = mobj->y;
+		out->z = mobj->z;
+		out->angle = mobj->angle;
+		return;
+	}
+
+	out->x = R_LerpFixed(mobj->old_x, mobj->x, frac);
+	out->y = R_LerpFixed(mobj->old_y, mobj->y, frac);
+	out->z = R_LerpFixed(mobj->old_z, mobj->z, frac);
+	out->angle = R_LerpAngle(mobj->old_angle, mobj->angle, frac);
+}
+
+void R_ResetMobjInterpolationState(mobj_t *mobj)
+{
+	mobj->old_x = mobj->x;
+	mobj->old_y = mobj->y;
+	mobj->old_z = mobj->z;
+	mobj->old_angle = mobj->angle;
+}
+
+void R_ResetPrecipitationMobjInterpolationState(precipmobj_t *mobj)
+{
+	mobj->old_x = mobj->x;
+	mobj->old_y = mobj->y;
+	mobj->old_z = mobj->z;
+	mobj->old_angle = mobj->angle;
+}
+
+void R_ResetCameraInterpolationState(camera_t *cam)
+{
+	cam->old_x = cam->x;
+	cam->old_y = cam->y;
+	cam->old_z = cam->z;
+	cam->old_angle = cam->angle;
+	cam->old_aiming = cam->aiming;
+}
+
+static void R_UpdateSectorInterpolators(void)
+{
+	size_t i;
+
+	// PU_LEVEL, so this is NULL'd out between levels
+	if (sectorinterps == NULL || numsectorinterps != numsectors)
+	{
+		if (sectorinterps)
+			Z_Free(sectorinterps);
+		numsectorinterps = numsectors;
+		if (!numsectorinterps)
+			return;
+		Z_Malloc(numsectorinterps * sizeof (*sectorinterps), PU_LEVEL, &sectorinterps);
+	}
+
+	for (i = 0; i < numsectorinterps; i++)
+	{
+		sectorinterps[i].oldfloorheight = sectors[i].floorheight;
+		sectorinterps[i].oldceilingheight = sectors[i].ceilingheight;
+	}
+}
+
+static void R_UpdatePolyobjInterpolators(void)
+{
+	size_t i, j, numverts = 0;
+	vertexinterp_t *interp;
+
+	for (i = 0; i < (size_t)numPolyObjects; i++)
+		numverts += PolyObjects[i].numVertices;
+
+	if (polyvertexinterps == NULL || numpolyvertexinterps != numverts)
+	{
+		if (polyvertexinterps)
+			Z_Free(polyvertexinterps);
+		numpolyvertexinterps = numverts;
+		if (!numpolyvertexinterps)
+			return;
+		Z_Malloc(numpolyvertexinterps * sizeof (*polyvertexinterps), PU_LEVEL, &polyvertexinterps);
+	}
+
+	interp = polyvertexinterps;
+	for (i = 0; i < (size_t)numPolyObjects; i++)
+	{
+		for (j = 0; j < PolyObjects[i].numVertices; j++, interp++)
+		{
+			interp->oldx = PolyObjects[i].vertices[j]->x;
+			interp->oldy = PolyObjects[i].vertices[j]->y;
+		}
+	}
+}
+
+void R_UpdateInterpolators(void)
+{
+	thinker_t *th;
+	INT32 i;
+
+	if (dedicated)
+		return;
+
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
+	{
+		if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
+			continue;
+		R_ResetMobjInterpolationState((mobj_t *)th);
+	}
+
+	for (th = thlist[THINK_PRECIP].next; th != &thlist[THINK_PRECIP]; th = th->next)
+	{
+		if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
+			continue;
+		R_ResetPrecipitationMobjInterpolationState((precipmobj_t *)th);
+	}
+
+	R_ResetCameraInterpolationState(&camera);
+	R_ResetCameraInterpolationState(&camera2);
+
+	for (i = 0; i < MAXPLAYERS; i++)
+		if (playeringame[i])
+			players[i].old_viewz = players[i].viewz;
+
+	R_UpdateSectorInterpolators();
+	R_UpdatePolyobjInterpolators();
+}
+
+void R_ApplyLevelInterpolators(fixed_t frac)
+{
+	size_t i, j;
+
+	if (frac >= FRACUNIT || levelinterpolated)
+		return;
+
+	if (sectorinterps && numsectorinterps == numsectors)
+	{
+		for (i = 0; i < numsectorinterps; i++)
+		{
+			sectorinterp_t *interp = &sectorinterps[i];
+			sector_t *sec = &sectors[i];
+
+			interp->floorheight = sec->floorheight;
+			interp->ceilingheight = sec->ceilingheight;
+
+			if (interp->oldfloorheight != interp->floorheight)
+				sec->floorheight = R_LerpFixed(interp->oldfloorheight, interp->floorheight, frac);
+			if (interp->oldceilingheight != interp->ceilingheight)
+				sec->ceilingheight = R_LerpFixed(interp->oldceilingheight, interp->ceilingheight, frac);
+		}
+	}
+
+	if (polyvertexinterps)
+	{
+		vertexinterp_t *interp = polyvertexinterps;
+		size_t numverts = 0;
+
+		for (i = 0; i < (size_t)numPolyObjects; i++)
+			numverts += PolyObjects[i].numVertices;
+
+		if (numverts == numpolyvertexinterps)
+		{
+			for (i = 0; i < (size_t)numPolyObjects; i++)
+			{
+				for (j = 0; j < PolyObjects[i].numVertices; j++, interp++)
+				{
+					vertex_t *v = PolyObjects[i].vertices[j];
+
+					interp->x = v->x;
+					interp->y = v->y;
+					v->x = R_LerpFixed(interp->oldx, interp->x, frac);
+					v->y = R_LerpFixed(interp->oldy, interp->y, frac);
+				}
+			}
+		}
+	}
+
+	levelinterpolated = true;
+}
+
+void R_RestoreLevelInterpolators(void)
+{
+	size_t i, j;
+
+	if (!levelinterpolated)
+		return;
+
+	levelinterpolated = false;
+
+	if (sectorinterps && numsectorinterps == numsectors)
+	{
+		for (i = 0; i < numsectorinterps; i++)
+		{
+			sectors[i].floorheight = sectorinterps[i].floorheight;
+			sectors[i].ceilingheight = sectorinterps[i].ceilingheight;
+		}
+	}
+
+	if (polyvertexinterps)
+	{
+		vertexinterp_t *interp = polyvertexinterps;
+		size_t numverts = 0;
+
+		for (i = 0; i < (size_t)numPolyObjects; i++)
+			numverts += PolyObjects[i].numVertices;
+
+		if (numverts == numpolyvertexinterps)
+		{
+			for (i = 0; i < (size_t)numPolyObjects; i++)
+			{
+				for (j = 0; j < PolyObjects[i].numVertices; j++, interp++)
+				{
+					PolyObjects[i].vertices[j]->x = interp->x;
+					PolyObjects[i].vertices[j]->y = interp->y;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,58 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2022 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  r_fps.h
+/// \brief Uncapped framerate and frame interpolation
+
+#ifndef __R_FPS_H__
+#define __R_FPS_H__
+
+#include "m_fixed.h"
+#include "p_local.h"
+
+extern consvar_t cv_fpscap;
+
+// Fraction of a tic elapsed since the last game tic, used to blend
+// between the previous and the current tic when drawing a frame.
+// Always FRACUNIT when frame interpolation is not in use.
+extern fixed_t rendertimefrac;
+
+UINT32 R_GetFramerateCap(void);
+boolean R_UsingFrameInterpolation(void);
+
+// Blend between the previous tic's value and the current one
+fixed_t R_InterpolateFixed(fixed_t from, fixed_t to);
+angle_t R_InterpolateAngle(angle_t from, angle_t to);
+
+typedef struct {
+	fixed_t x;
+	fixed_t y;
+	fixed_t z;
+	angle_t angle;
+} interpmobjstate_t;
+
+// Get the interpolated position and angle of an object for this frame
+void R_InterpolateMobjState(mobj_t *mobj, fixed_t frac, interpmobjstate_t *out);
+void R_InterpolatePrecipMobjState(precipmobj_t *mobj, fixed_t frac, interpmobjstate_t *out);
+
+// Snap an object to its current position, so that it doesn't
+// visibly slide from its old position (spawning, teleporting...)
+void R_ResetMobjInterpolationState(mobj_t *mobj);
+void R_ResetPrecipitationMobjInterpolationState(precipmobj_t *mobj);
+void R_ResetCameraInterpolationState(camera_t *cam);
+
+// Called by P_Ticker before any thinkers run,
+// snapshots everything that is interpolated
+void R_UpdateInterpolators(void);
+
+// Blend sector planes and polyobjects for the frame about to be drawn,
+// and put the real values back once the view has been rendered
+void R_ApplyLevelInterpolators(fixed_t frac);
+void R_RestoreLevelInterpolators(void);
+
+#endif
@@ -34,6 +34,7 @@
 #include "r_textures.h"
 #include "r_things.h"
 #include "r_draw.h"
+#include "r_threads.h"
 
 extern drawseg_t *firstseg;
 
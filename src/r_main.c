@@ -34,6 +34,7 @@
 #include "m_random.h" // quake camera shake
 #include "r_portal.h"
 #include "r_main.h"
+#include "r_fps.h"
 #include "i_system.h" // I_GetPreciseTime
 
 #ifdef HWRENDER
@@ -102,6 +103,7 @@ ps_metric_t ps_sw_spritecliptime = {0};
 ps_metric_t ps_sw_portaltime = {0};
 ps_metric_t ps_sw_planetime = {0};
 ps_metric_t ps_sw_maskedtime = {0};
+ps_metric_t ps_sw_drawqueuetime = {0};
 
 ps_metric_t ps_numbspcalls = {0};
 ps_metric_t ps_numsprites = {0};
@@ -1137,6 +1139,7 @@ void R_SetupFrame(player_t *player)
 {
 	camera_t *thiscam;
 	boolean chasecam = false;
+	interpmobjstate_t interp = {0};
 
 	if (splitscreen && player == &players[secondarydisplayplayer]
 		&& player != &players[consoleplayer])
@@ -1168,28 +1171,30 @@ void R_SetupFrame(player_t *player)
 		// cut-away view stuff
 		r_viewmobj = player->awayviewmobj; // should be a MT_ALTVIEWMAN
 		I_Assert(r_viewmobj != NULL);
-		viewz = r_viewmobj->z + 20*FRACUNIT;
+		R_InterpolateMobjState(r_viewmobj, rendertimefrac, &interp);
+		viewz = interp.z + 20*FRACUNIT;
 		aimingangle = player->awayviewaiming;
-		viewangle = r_viewmobj->angle;
+		viewangle = interp.angle;
 	}
 	else if (!player->spectator && chasecam)
 	// use outside cam view
 	{
 		r_viewmobj = NULL;
-		viewz = thiscam->z + (thiscam->height>>1);
-		aimingangle = thiscam->aiming;
-		viewangle = thiscam->angle;
+		viewz = R_InterpolateFixed(thiscam->old_z, thiscam->z) + (thiscam->height>>1);
+		aimingangle = R_InterpolateAngle(thiscam->old_aiming, thiscam->aiming);
+		viewangle = R_InterpolateAngle(thiscam->old_angle, thiscam->angle);
 	}
 	else
 	// use the player's eyes view
 	{
-		viewz = player->viewz;
+		viewz = R_InterpolateFixed(player->old_viewz, player->viewz);
 
 		r_viewmobj = player->mo;
 		I_Assert(r_viewmobj != NULL);
+		R_InterpolateMobjState(r_viewmobj, rendertimefrac, &interp);
 
 		aimingangle = player->aiming;
-		viewangle = r_viewmobj->angle;
+		viewangle = interp.angle;
 
 		if (!demoplayback && player->playerstate != PST_DEAD)
 		{
@@ -1211,8 +1216,8 @@ void R_SetupFrame(player_t *player)
 
 	if (chasecam && !player->awayviewtics && !player->spectator)
 	{
-		viewx = thiscam->x;
-		viewy = thiscam->y;
+		viewx = R_InterpolateFixed(thiscam->old_x, thiscam->x);
+		viewy = R_InterpolateFixed(thiscam->old_y, thiscam->y);
 		viewx += quake.x;
 		viewy += quake.y;
 
@@ -1223,8 +1228,8 @@ void R_SetupFrame(player_t *player)
 	}
 	else
 	{
-		viewx = r_viewmobj->x;
-		viewy = r_viewmobj->y;
+		viewx = interp.x;
+		viewy = interp.y;
 		viewx += quake.x;
 		viewy += quake.y;
 
@@ -1262,17 +1267,17 @@ void R_SkyboxFrame(player_t *player)
 	if (player->awayviewtics)
 	{
 		aimingangle = player->awayviewaiming;
-		viewangle = player->awayviewmobj->angle;
+		viewangle = R_InterpolateAngle(player->awayviewmobj->old_angle, player->awayviewmobj->angle);
 	}
 	else if (thiscam->chase)
 	{
-		aimingangle = thiscam->aiming;
-		viewangle = thiscam->angle;
+		aimingangle = R_InterpolateAngle(thiscam->old_aiming, thiscam->aiming);
+		viewangle = R_InterpolateAngle(thiscam->old_angle, thiscam->angle);
 	}
 	else
 	{
 		aimingangle = player->aiming;
-		viewangle = player->mo->angle;
+		viewangle = R_InterpolateAngle(player->mo->old_angle, player->mo->angle);
 		if (!demoplayback && player->playerstate != PST_DEAD)
 		{
 			if (player == &players[consoleplayer])
@@ -1301,17 +1306,19 @@ void R_SkyboxFrame(player_t *player)
 		vector3_t campos = {0,0,0}; // Position of player's actual view point
 
 		if (player->awayviewtics) {
-			campos.x = player->awayviewmobj->x;
-			campos.y = player->awayviewmobj->y;
-			campos.z = player->awayviewmobj->z + 20*FRACUNIT;
+			interpmobjstate_t interp = {0};
+			R_InterpolateMobjState(player->awayviewmobj, rendertimefrac, &interp);
+			campos.x = interp.x;
+			campos.y = interp.y;
+			campos.z = interp.z + 20*FRACUNIT;
 		} else if (thiscam->chase) {
-			campos.x = thiscam->x;
-			campos.y = thiscam->y;
-			campos.z = thiscam->z + (thiscam->height>>1);
+			campos.x = R_InterpolateFixed(thiscam->old_x, thiscam->x);
+			campos.y = R_InterpolateFixed(thiscam->old_y, thiscam->y);
+			campos.z = R_InterpolateFixed(thiscam->old_z, thiscam->z) + (thiscam->height>>1);
 		} else {
-			campos.x = player->mo->x;
-			campos.y = player->mo->y;
-			campos.z = player->viewz;
+			campos.x = R_InterpolateFixed(player->mo->old_x, player->mo->x);
+			campos.y = R_InterpolateFixed(player->mo->old_y, player->mo->y);
+			campos.z = R_InterpolateFixed(player->old_viewz, player->viewz);
 		}
 
 		// Earthquake effects should be scaled in the skybox
@@ -1505,6 +1512,8 @@ void R_RenderPlayerView(player_t *player)
 	if (I_AppOnBackground())
 		return;
 
+	R_StartDrawQueue();
+
 	// The head node is the last node output.
 	Mask_Pre(&masks[nummasks - 1]);
 	curdrawsegs = ds_p;
@@ -1577,6 +1586,10 @@ void R_RenderPlayerView(player_t *player)
 	R_DrawMasked(masks, nummasks);
 	PS_STOP_TIMING(ps_sw_maskedtime);
 
+	PS_START_TIMING(ps_sw_drawqueuetime);
+	R_FinishDrawQueue();
+	PS_STOP_TIMING(ps_sw_drawqueuetime);
+
 	free(masks);
 }
 
@@ -1615,6 +1628,8 @@ void R_RegisterEngineStuff(void)
 	CV_RegisterVar(&cv_shadow);
 	CV_RegisterVar(&cv_skybox);
 	CV_RegisterVar(&cv_ffloorclip);
+	CV_RegisterVar(&cv_fpscap);
+	CV_RegisterVar(&cv_renderthreads);
 
 	CV_RegisterVar(&cv_cam_dist);
 	CV_RegisterVar(&cv_cam_still);
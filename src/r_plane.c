@@ -76,7 +76,7 @@ static INT32 spanstart[MAXVIDHEIGHT];
 //
 // texture mapping
 //
-lighttable_t **planezlight;
+RENDERLOCAL lighttable_t **planezlight;
 static fixed_t planeheight;
 
 //added : 10-02-98: yslopetab is what yslope used to be,
@@ -220,7 +220,7 @@ static void R_MapPlane(INT32 y, INT32 x1, INT32 x2)
 	ds_x1 = x1;
 	ds_x2 = x2;
 
-	spanfunc();
+	R_QueueSpan(spanfunc);
 }
 
 static void R_MapTiltedPlane(INT32 y, INT32 x1, INT32 x2)
@@ -259,7 +259,7 @@ static void R_MapTiltedPlane(INT32 y, INT32 x1, INT32 x2)
 	ds_x1 = x1;
 	ds_x2 = x2;
 
-	spanfunc();
+	R_QueueSpan(spanfunc);
 }
 
 void R_ClearFFloorClips (void)
@@ -613,7 +613,7 @@ static void R_DrawSkyPlane(visplane_t *pl)
 			dc_source =
 				R_GetColumn(texturetranslation[skytexture],
 					-angle); // get negative of angle for each column to display sky correct way round! --Monster Iestyn 27/01/18
-			colfunc();
+			R_QueueColumn(colfunc);
 		}
 	}
 }
@@ -898,9 +898,8 @@ void R_DrawSinglePlane(visplane_t *pl)
 						bottom = vid.height;
 
 					// Only copy the part of the screen we need
-					VID_BlitLinearScreen((splitscreen && viewplayer == &players[secondarydisplayplayer]) ? screens[0] + (top+(vid.height>>1))*vid.width : screens[0]+((top)*vid.width), screens[1]+((top)*vid.width),
-										 vid.width, bottom-top,
-										 vid.width, vid.width);
+					R_QueueScreenCopy((splitscreen && viewplayer == &players[secondarydisplayplayer]) ? screens[0] + (top+(vid.height>>1))*vid.width : screens[0]+((top)*vid.width), screens[1]+((top)*vid.width),
+										 top, bottom);
 				}
 			}
 		}
@@ -71,7 +71,7 @@ extern fixed_t cachedxstep[MAXVIDHEIGHT];
 extern fixed_t cachedystep[MAXVIDHEIGHT];
 
 extern fixed_t *yslope;
-extern lighttable_t **planezlight;
+extern RENDERLOCAL lighttable_t **planezlight;
 
 void R_InitPlanes(void);
 void R_ClearPlanes(void);
@@ -12,8 +12,10 @@
 
 #include "r_draw.h"
 #include "r_main.h"
+#include "r_fps.h"
 #include "r_splats.h"
 #include "r_bsp.h"
+#include "r_threads.h"
 #include "p_local.h"
 #include "p_slopes.h"
 #include "w_wad.h"
@@ -185,7 +187,7 @@ void R_DrawFloorSplat(vissprite_t *spr)
 		splat.scale = FixedMul(splat.scale, ((skin_t *)mobj->skin)->highresscale);
 
 	if (spr->rotateflags & SRF_3D || renderflags & RF_NOSPLATBILLBOARD)
-		splatangle = mobj->angle;
+		splatangle = R_InterpolateAngle(mobj->old_angle, mobj->angle);
 	else
 		splatangle = spr->viewpoint.angle;
 
@@ -209,14 +211,14 @@ void R_DrawFloorSplat(vissprite_t *spr)
 	xoffset = FixedMul(leftoffset, splat.xscale);
 	yoffset = FixedMul(topoffset, splat.yscale);
 
-	x = mobj->x;
-	y = mobj->y;
+	x = spr->gx;
+	y = spr->gy;
 	w = (splat.width * splat.xscale);
 	h = (splat.height * splat.yscale);
 
 	splat.x = x;
 	splat.y = y;
-	splat.z = mobj->z;
+	splat.z = spr->pz;
 	splat.slope = NULL;
 
 	// Set positions
@@ -550,7 +552,7 @@ static void R_RasterizeFloorSplat(floorsplat_t *pSplat, vector2_t *verts, visspr
 		ds_y = y;
 		ds_x1 = x1;
 		ds_x2 = x2;
-		spanfunc();
+		R_QueueSpan(spanfunc);
 
 		rastertab[y].minx = INT32_MAX;
 		rastertab[y].maxx = INT32_MIN;
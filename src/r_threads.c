@@ -0,0 +1,548 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2022 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  r_threads.c
+/// \brief Multithreaded drawing for the software renderer
+///
+///        The view is still set up and clipped on the main thread: BSP
+///        traversal, portals, visplanes and vissprites are all built
+///        exactly like before. What changes is that the column and span
+///        drawers aren't called right away. Instead, each call is queued
+///        along with a copy of the drawer state (dc_* and ds_*), and once
+///        the view is done, the queue is replayed by every render thread,
+///        each one only drawing the rows in its own band of the screen.
+///
+///        Spans are never split, and columns are only cut at band edges,
+///        where the drawers work out their texture position from dc_yl.
+///        Every pixel still gets its draws in the same order, so the
+///        output is the same as drawing with a single thread.
+
+#include "doomdef.h"
+#include "i_system.h"
+#include "i_threads.h"
+#include "i_video.h"
+#include "r_local.h"
+#include "r_threads.h"
+#include "v_video.h"
+
+static CV_PossibleValue_t renderthreads_cons_t[] = {{1, "MIN"}, {MAXRENDERTHREADS, "MAX"}, {0, NULL}};
+consvar_t cv_renderthreads = CVAR_INIT ("renderthreads", "1", CV_SAVE, renderthreads_cons_t, NULL);
+
+#ifdef RENDERTHREADS
+
+typedef enum
+{
+	DRAWCMD_COLUMN,
+	DRAWCMD_SPAN,
+	DRAWCMD_SCREENCOPY
+} drawcmdtype_t;
+
+typedef struct
+{
+	drawcmdtype_t type;
+	void (*drawer)(void);
+
+	INT32 x, yl, yh;
+	fixed_t iscale, texturemid;
+	INT32 texheight;
+	UINT8 hires;
+
+	UINT8 *source;
+	lighttable_t *colormap;
+	UINT8 *transmap;
+	UINT8 *translation;
+
+	// Bytes of source copied in right after the command, for
+	// sources that don't last until the queue is drawn
+	size_t sourcelen;
+} columncmd_t;
+
+// Copied sources are padded so the next command stays aligned
+#define DRAWCMDALIGN 8
+
+typedef struct
+{
+	drawcmdtype_t type;
+	void (*drawer)(void);
+
+	INT32 y, x1, x2;
+	fixed_t xfrac, yfrac, xstep, ystep;
+	INT32 waterofs, bgofs;
+
+	UINT16 flatwidth, flatheight;
+	boolean powersoftwo;
+	UINT32 flatxshift, flatyshift, flatshiftup, flatmask;
+
+	UINT8 *source;
+	lighttable_t *colormap;
+	lighttable_t *translation;
+	UINT8 *transmap;
+	lighttable_t **zlight;
+
+	// Tilted spans
+	floatv3_t su, sv, sz;
+	float zeroheight;
+} spancmd_t;
+
+typedef struct
+{
+	drawcmdtype_t type;
+
+	UINT8 *src, *dest;
+	INT32 top, bottom;
+} screencopycmd_t;
+
+static boolean queuedraws = false;
+
+static UINT8 *drawqueue = NULL;
+static size_t drawqueuesize = 0;
+static size_t drawqueuelen = 0;
+
+// The rows each band draws, top inclusive and bottom exclusive
+static INT32 bandtop[MAXRENDERTHREADS];
+static INT32 bandbottom[MAXRENDERTHREADS];
+static INT32 numbands;
+
+// Worker threads; the main thread always draws the first band
+static I_mutex renderthread_mutex;
+static I_cond renderthread_cond;
+static I_cond renderthread_done_cond;
+static I_cond renderthread_barrier_cond;
+
+static INT32 numrenderthreads = 0;
+static UINT32 drawjob = 0;
+static INT32 bandsleft = 0;
+static INT32 barriercount = 0;
+static UINT32 barriergeneration = 0;
+static boolean stoprenderthreads = false;
+
+static void *R_AllocDrawCommand(size_t size)
+{
+	void *cmd;
+
+	if (drawqueuelen + size > drawqueuesize)
+	{
+		if (!drawqueuesize)
+			drawqueuesize = 1<<20;
+		while (drawqueuelen + size > drawqueuesize)
+			drawqueuesize <<= 1;
+
+		drawqueue = realloc(drawqueue, drawqueuesize);
+		if (drawqueue == NULL)
+			I_Error("R_AllocDrawCommand: Out of memory");
+	}
+
+	cmd = drawqueue + drawqueuelen;
+	drawqueuelen += size;
+	return cmd;
+}
+
+static void R_SaveColumnState(columncmd_t *cmd)
+{
+	cmd->x = dc_x;
+	cmd->yl = dc_yl;
+	cmd->yh = dc_yh;
+	cmd->iscale = dc_iscale;
+	cmd->texturemid = dc_texturemid;
+	cmd->texheight = dc_texheight;
+	cmd->hires = dc_hires;
+	cmd->source = dc_source;
+	cmd->colormap = dc_colormap;
+	cmd->transmap = dc_transmap;
+	cmd->translation = dc_translation;
+}
+
+static void R_LoadColumnState(const columncmd_t *cmd)
+{
+	dc_x = cmd->x;
+	dc_yl = cmd->yl;
+	dc_yh = cmd->yh;
+	dc_iscale = cmd->iscale;
+	dc_texturemid = cmd->texturemid;
+	dc_texheight = cmd->texheight;
+	dc_hires = cmd->hires;
+	dc_source = cmd->source;
+	dc_colormap = cmd->colormap;
+	dc_transmap = cmd->transmap;
+	dc_translation = cmd->translation;
+}
+
+static void R_SaveSpanState(spancmd_t *cmd)
+{
+	cmd->y = ds_y;
+	cmd->x1 = ds_x1;
+	cmd->x2 = ds_x2;
+	cmd->xfrac = ds_xfrac;
+	cmd->yfrac = ds_yfrac;
+	cmd->xstep = ds_xstep;
+	cmd->ystep = ds_ystep;
+	cmd->waterofs = ds_waterofs;
+	cmd->bgofs = ds_bgofs;
+	cmd->flatwidth = ds_flatwidth;
+	cmd->flatheight = ds_flatheight;
+	cmd->powersoftwo = ds_powersoftwo;
+	cmd->flatxshift = nflatxshift;
+	cmd->flatyshift = nflatyshift;
+	cmd->flatshiftup = nflatshiftup;
+	cmd->flatmask = nflatmask;
+	cmd->source = ds_source;
+	cmd->colormap = ds_colormap;
+	cmd->translation = ds_translation;
+	cmd->transmap = ds_transmap;
+	cmd->zlight = planezlight;
+	cmd->zeroheight = zeroheight;
+
+	// The vectors live in arrays that the next plane will overwrite
+	if (ds_sup)
+		cmd->su = *ds_sup;
+	if (ds_svp)
+		cmd->sv = *ds_svp;
+	if (ds_szp)
+		cmd->sz = *ds_szp;
+}
+
+static void R_LoadSpanState(spancmd_t *cmd)
+{
+	ds_y = cmd->y;
+	ds_x1 = cmd->x1;
+	ds_x2 = cmd->x2;
+	ds_xfrac = cmd->xfrac;
+	ds_yfrac = cmd->yfrac;
+	ds_xstep = cmd->xstep;
+	ds_ystep = cmd->ystep;
+	ds_waterofs = cmd->waterofs;
+	ds_bgofs = cmd->bgofs;
+	ds_flatwidth = cmd->flatwidth;
+	ds_flatheight = cmd->flatheight;
+	ds_powersoftwo = cmd->powersoftwo;
+	nflatxshift = cmd->flatxshift;
+	nflatyshift = cmd->flatyshift;
+	nflatshiftup = cmd->flatshiftup;
+	nflatmask = cmd->flatmask;
+	ds_source = cmd->source;
+	ds_colormap = cmd->colormap;
+	ds_translation = cmd->translation;
+	ds_transmap = cmd->transmap;
+	planezlight = cmd->zlight;
+	zeroheight = cmd->zeroheight;
+	ds_sup = &cmd->su;
+	ds_svp = &cmd->sv;
+	ds_szp = &cmd->sz;
+}
+
+// Wait until every band has caught up to this point in the queue.
+static void R_DrawQueueBarrier(void)
+{
+	UINT32 generation;
+
+	I_lock_mutex(&renderthread_mutex);
+	{
+		generation = barriergeneration;
+
+		if (++barriercount == numbands)
+		{
+			barriercount = 0;
+			barriergeneration++;
+			I_wake_all_cond(&renderthread_barrier_cond);
+		}
+		else
+		{
+			while (generation == barriergeneration)
+				I_hold_cond(&renderthread_barrier_cond, renderthread_mutex);
+		}
+	}
+	I_unlock_mutex(renderthread_mutex);
+}
+
+static void R_RunDrawQueue(INT32 band)
+{
+	const INT32 top = bandtop[band];
+	const INT32 bottom = bandbottom[band];
+	UINT8 *pos = drawqueue;
+	UINT8 *end = drawqueue + drawqueuelen;
+
+	while (pos < end)
+	{
+		switch (*(drawcmdtype_t *)pos)
+		{
+			case DRAWCMD_COLUMN:
+			{
+				columncmd_t *cmd = (columncmd_t *)pos;
+				UINT8 *source = pos + sizeof (*cmd);
+				pos = source + ((cmd->sourcelen + DRAWCMDALIGN-1) & ~(size_t)(DRAWCMDALIGN-1));
+
+				if (cmd->yh < top || cmd->yl >= bottom || cmd->yl > cmd->yh)
+					break;
+
+				R_LoadColumnState(cmd);
+
+				// The queue may have moved since, so find the copy now
+				if (cmd->sourcelen)
+					dc_source = source;
+				if (dc_yl < top)
+					dc_yl = top;
+				if (dc_yh >= bottom)
+					dc_yh = bottom - 1;
+
+				cmd->drawer();
+				break;
+			}
+			case DRAWCMD_SPAN:
+			{
+				spancmd_t *cmd = (spancmd_t *)pos;
+				pos += sizeof (*cmd);
+
+				if (cmd->y < top || cmd->y >= bottom)
+					break;
+
+				R_LoadSpanState(cmd);
+				cmd->drawer();
+				break;
+			}
+			case DRAWCMD_SCREENCOPY:
+			{
+				screencopycmd_t *cmd = (screencopycmd_t *)pos;
+				INT32 y1 = max(cmd->top, top);
+				INT32 y2 = min(cmd->bottom, bottom);
+				pos += sizeof (*cmd);
+
+				// Other bands may still be reading the last copy,
+				// and will read rows of this one that aren't ours
+				R_DrawQueueBarrier();
+				if (y1 < y2)
+					VID_BlitLinearScreen(cmd->src + (y1 - cmd->top)*vid.width, cmd->dest + (y1 - cmd->top)*vid.width,
+						vid.width, y2 - y1, vid.width, vid.width);
+				R_DrawQueueBarrier();
+				break;
+			}
+			default:
+				I_Error("R_RunDrawQueue: Bad draw command");
+		}
+	}
+}
+
+static void R_RenderThread(void *userdata)
+{
+	const INT32 band = (INT32)(size_t)userdata;
+	UINT32 lastjob = 0;
+	boolean draw;
+
+	for (;;)
+	{
+		I_lock_mutex(&renderthread_mutex);
+		{
+			while (drawjob == lastjob && !stoprenderthreads)
+				I_hold_cond(&renderthread_cond, renderthread_mutex);
+
+			lastjob = drawjob;
+			draw = (band < numbands);
+		}
+		I_unlock_mutex(renderthread_mutex);
+
+		if (stoprenderthreads || I_thread_is_stopped())
+			return;
+
+		if (!draw)
+			continue;
+
+		R_RunDrawQueue(band);
+
+		I_lock_mutex(&renderthread_mutex);
+		{
+			if (--bandsleft == 0)
+				I_wake_all_cond(&renderthread_done_cond);
+		}
+		I_unlock_mutex(renderthread_mutex);
+	}
+}
+
+static void R_StopRenderThreads(void)
+{
+	if (!numrenderthreads)
+		return;
+
+	I_lock_mutex(&renderthread_mutex);
+	{
+		stoprenderthreads = true;
+		I_wake_all_cond(&renderthread_cond);
+	}
+	I_unlock_mutex(renderthread_mutex);
+}
+
+static void R_SpawnRenderThreads(INT32 count)
+{
+	if (numrenderthreads == 0)
+		I_AddExitFunc(R_StopRenderThreads);
+
+	// Threads are never stopped once running, they just sit idle
+	while (numrenderthreads < count)
+	{
+		numrenderthreads++;
+		I_spawn_thread("render", R_RenderThread, (void *)(size_t)numrenderthreads);
+	}
+}
+
+void R_StartDrawQueue(void)
+{
+	queuedraws = (rendermode == render_soft && cv_renderthreads.value > 1 && viewheight > 1);
+	drawqueuelen = 0;
+}
+
+void R_FinishDrawQueue(void)
+{
+	columncmd_t columnstate;
+	spancmd_t spanstate;
+	INT32 i;
+
+	if (!queuedraws)
+		return;
+
+	queuedraws = false;
+
+	numbands = min(cv_renderthreads.value, viewheight);
+	for (i = 0; i < numbands; i++)
+	{
+		bandtop[i] = (i == 0) ? INT32_MIN : viewheight*i/numbands;
+		bandbottom[i] = (i == numbands-1) ? INT32_MAX : viewheight*(i+1)/numbands;
+	}
+
+	R_SpawnRenderThreads(numbands - 1);
+
+	// The main thread draws too, so keep its own drawer state intact
+	R_SaveColumnState(&columnstate);
+	R_SaveSpanState(&spanstate);
+
+	I_lock_mutex(&renderthread_mutex);
+	{
+		bandsleft = numbands - 1;
+		barriercount = 0;
+		drawjob++;
+		I_wake_all_cond(&renderthread_cond);
+	}
+	I_unlock_mutex(renderthread_mutex);
+
+	R_RunDrawQueue(0);
+
+	I_lock_mutex(&renderthread_mutex);
+	{
+		while (bandsleft > 0)
+			I_hold_cond(&renderthread_done_cond, renderthread_mutex);
+	}
+	I_unlock_mutex(renderthread_mutex);
+
+	R_LoadColumnState(&columnstate);
+	R_LoadSpanState(&spanstate);
+	ds_sup = ds_svp = ds_szp = NULL;
+
+	drawqueuelen = 0;
+}
+
+void R_QueueColumn(void (*drawer)(void))
+{
+	columncmd_t *cmd;
+
+	// This one only splits the column up by light levels,
+	// and queues the pieces itself
+	if (!queuedraws || drawer == colfuncs[COLDRAWFUNC_SHADOWED])
+	{
+		drawer();
+		return;
+	}
+
+	cmd = R_AllocDrawCommand(sizeof (*cmd));
+	cmd->type = DRAWCMD_COLUMN;
+	cmd->drawer = drawer;
+	R_SaveColumnState(cmd);
+	cmd->sourcelen = 0;
+}
+
+void R_QueueColumnSource(void (*drawer)(void), size_t sourcelen)
+{
+	const size_t copylen = (sourcelen + DRAWCMDALIGN-1) & ~(size_t)(DRAWCMDALIGN-1);
+	columncmd_t *cmd;
+
+	if (!queuedraws || !sourcelen)
+	{
+		R_QueueColumn(drawer);
+		return;
+	}
+
+	cmd = R_AllocDrawCommand(sizeof (*cmd) + copylen);
+	cmd->type = DRAWCMD_COLUMN;
+	cmd->drawer = drawer;
+	R_SaveColumnState(cmd);
+	cmd->sourcelen = sourcelen;
+	M_Memcpy(cmd + 1, dc_source, sourcelen);
+}
+
+void R_QueueSpan(void (*drawer)(void))
+{
+	spancmd_t *cmd;
+
+	if (!queuedraws)
+	{
+		drawer();
+		return;
+	}
+
+	cmd = R_AllocDrawCommand(sizeof (*cmd));
+	cmd->type = DRAWCMD_SPAN;
+	cmd->drawer = drawer;
+	R_SaveSpanState(cmd);
+}
+
+void R_QueueScreenCopy(UINT8 *src, UINT8 *dest, INT32 top, INT32 bottom)
+{
+	screencopycmd_t *cmd;
+
+	if (!queuedraws)
+	{
+		VID_BlitLinearScreen(src, dest, vid.width, bottom-top, vid.width, vid.width);
+		return;
+	}
+
+	cmd = R_AllocDrawCommand(sizeof (*cmd));
+	cmd->type = DRAWCMD_SCREENCOPY;
+	cmd->src = src;
+	cmd->dest = dest;
+	cmd->top = top;
+	cmd->bottom = bottom;
+}
+
+#else/*RENDERTHREADS*/
+
+void R_StartDrawQueue(void)
+{
+}
+
+void R_FinishDrawQueue(void)
+{
+}
+
+void R_QueueColumn(void (*drawer)(void))
+{
+	drawer();
+}
+
+void R_QueueColumnSource(void (*drawer)(void), size_t sourcelen)
+{
+	(void)sourcelen;
+	drawer();
+}
+
+void R_QueueSpan(void (*drawer)(void))
+{
+	drawer();
+}
+
+void R_QueueScreenCopy(UINT8 *src, UINT8 *dest, INT32 top, INT32 bottom)
+{
+	VID_BlitLinearScreen(src, dest, vid.width, bottom-top, vid.width, vid.width);
+}
+
+#endif/*RENDERTHREADS*/
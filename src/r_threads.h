@@ -0,0 +1,42 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2022 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  r_threads.h
+/// \brief Multithreaded drawing for the software renderer
+
+#ifndef __R_THREADS__
+#define __R_THREADS__
+
+#include "doomdef.h"
+#include "command.h"
+
+#define MAXRENDERTHREADS 16
+
+extern consvar_t cv_renderthreads;
+
+// Start queueing draws for the view about to be rendered.
+// Does nothing unless more than one render thread is in use.
+void R_StartDrawQueue(void);
+
+// Draw everything that was queued, with the view split into
+// horizontal bands, one per render thread.
+void R_FinishDrawQueue(void);
+
+// The refresh code calls the drawers through these, so that
+// the draws can be queued with a copy of the drawer state.
+void R_QueueColumn(void (*drawer)(void));
+void R_QueueSpan(void (*drawer)(void));
+
+// Same as R_QueueColumn, but for a dc_source that gets freed before
+// the queue is drawn: its first sourcelen bytes are queued with it.
+void R_QueueColumnSource(void (*drawer)(void), size_t sourcelen);
+
+// Copy rows of the screen, for drawers that read back from it.
+void R_QueueScreenCopy(UINT8 *src, UINT8 *dest, INT32 top, INT32 bottom);
+
+#endif // __R_THREADS__
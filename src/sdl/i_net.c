@@ -235,7 +235,7 @@ static void NET_CloseSocket(void)
 	mysocket = NULL;
 }
 
-static SINT8 NET_NetMakeNodewPort(const char *hostname, const char *port)
+static INT16 NET_NetMakeNodewPort(const char *hostname, const char *port)
 {
 	INT32 newnode;
 	UINT16 portnum = sock_port;
@@ -258,7 +258,7 @@ static SINT8 NET_NetMakeNodewPort(const char *hostname, const char *port)
 	}
 	newnode++;
 	M_Memcpy(&clientaddress[newnode],&hostnameIP,sizeof (IPaddress));
-	return (SINT8)newnode;
+	return (INT16)newnode;
 }
 
 
@@ -2002,11 +2002,10 @@ static Uint64 timer_frequency;
 
 static double tic_frequency;
 static Uint64 tic_epoch;
+static double elapsed;
 
 tic_t I_GetTime(void)
 {
-	static double elapsed;
-
 	const Uint64 now = SDL_GetPerformanceCounter();
 
 	elapsed += (now - tic_epoch) / tic_frequency;
@@ -2015,6 +2014,14 @@ tic_t I_GetTime(void)
 	return (tic_t)elapsed;
 }
 
+fixed_t I_GetTimeFrac(void)
+{
+	const Uint64 now = SDL_GetPerformanceCounter();
+	const double tics = elapsed + (now - tic_epoch) / tic_frequency;
+
+	return (fixed_t)((tics - (tic_t)tics) * FRACUNIT);
+}
+
 precise_t I_GetPreciseTime(void)
 {
 	return SDL_GetPerformanceCounter();
@@ -0,0 +1,485 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2022 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  w_decompress.c
+/// \brief Decompressed lump cache and background decompression
+///
+///        Compressed lumps used to be decompressed again every time they
+///        were read, which happens a lot once PU_CACHE gets purged. The
+///        decompressed data is now kept in a cache of limited size, and
+///        the least recently used lumps are thrown out first.
+///
+///        While a level loads, the lumps it's about to use can be handed
+///        to worker threads, so they're decompressed by the time they
+///        get read. Only the main thread ever touches the files, the
+///        workers just get the raw data.
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <errno.h>
+#include "lzf.h"
+
+#include "doomdef.h"
+#include "console.h"
+#include "i_system.h"
+#include "i_threads.h"
+#include "w_decompress.h"
+#include "w_wad.h"
+
+static void LumpCacheSize_OnChange(void);
+
+static CV_PossibleValue_t lumpcachesize_cons_t[] = {{0, "MIN"}, {1024, "MAX"}, {0, NULL}};
+consvar_t cv_lumpcachesize = CVAR_INIT ("lumpcachesize", "64", CV_SAVE|CV_CALL, lumpcachesize_cons_t, LumpCacheSize_OnChange);
+
+#define NUMDECOMPRESSTHREADS 3
+
+#define LUMPCACHEHASHSIZE 4096 // Must be a power of two
+#define LUMPCACHEHASH(wad, lump) ((((UINT32)(wad) * 2654435761u) ^ (lump)) & (LUMPCACHEHASHSIZE - 1))
+
+typedef struct decodedlump_s
+{
+	UINT16 wad, lump;
+	UINT8 *data; // NULL while it's being decompressed
+	size_t size;
+
+	struct decodedlump_s *hashnext;
+	struct decodedlump_s *prev, *next; // most recently used first
+} decodedlump_t;
+
+static decodedlump_t *lumphash[LUMPCACHEHASHSIZE];
+static decodedlump_t lumplru = {0, 0, NULL, 0, NULL, &lumplru, &lumplru};
+
+static size_t cachedbytes = 0;
+static size_t cachebudget = 64<<20;
+static size_t numcachedlumps = 0;
+
+static struct
+{
+	UINT32 hits, waits, misses;
+	UINT32 prefetched, evicted;
+	UINT64 inflated, inflatedbackground;
+} lumpcachestats;
+
+#ifdef HAVE_THREADS
+typedef struct decompressjob_s
+{
+	UINT16 wad, lump;
+	compmethod method;
+	UINT8 *raw;
+	size_t rawsize, size;
+	boolean ownsraw; // false if it points into a mapped file
+
+	struct decompressjob_s *next;
+} decompressjob_t;
+
+static decompressjob_t *jobhead = NULL, *jobtail = NULL;
+
+static I_mutex lumpcache_mutex;
+static I_cond lumpcache_ready_cond; // a lump finished decompressing
+static I_cond lumpcache_job_cond; // a job was queued
+
+static INT32 numdecompressthreads = 0;
+static boolean stopdecompressthreads = false;
+
+#define LockLumpCache() I_lock_mutex(&lumpcache_mutex)
+#define UnlockLumpCache() I_unlock_mutex(lumpcache_mutex)
+#else
+#define LockLumpCache()
+#define UnlockLumpCache()
+#endif
+
+INT32 W_DecompressData(compmethod method, const UINT8 *raw, size_t rawsize, UINT8 *out, size_t outsize)
+{
+	switch (method)
+	{
+		case CM_LZF:
+		{
+			size_t retval;
+
+#ifndef AVOID_ERRNO
+			errno = 0;
+#endif
+			retval = lzf_decompress(raw, rawsize, out, outsize);
+
+			if (retval == outsize)
+				return 0;
+#ifndef AVOID_ERRNO
+			if (retval == 0 && errno)
+				return errno;
+#endif
+			return -1;
+		}
+#ifdef HAVE_ZLIB
+		case CM_DEFLATE:
+		{
+			z_stream strm;
+			int zErr;
+
+			strm.zalloc = Z_NULL;
+			strm.zfree = Z_NULL;
+			strm.opaque = Z_NULL;
+
+			strm.total_in = strm.avail_in = rawsize;
+			strm.total_out = strm.avail_out = outsize;
+
+			strm.next_in = (Bytef *)(size_t)raw; // zlib doesn't write to it
+			strm.next_out = out;
+
+			zErr = inflateInit2(&strm, -15);
+			if (zErr != Z_OK)
+				return zErr;
+
+			zErr = inflate(&strm, Z_FINISH);
+			(void)inflateEnd(&strm);
+
+			return (zErr == Z_STREAM_END) ? Z_OK : zErr;
+		}
+#endif
+		default:
+			return -1;
+	}
+}
+
+static decodedlump_t **FindLumpLink(UINT16 wad, UINT16 lump)
+{
+	decodedlump_t **link = &lumphash[LUMPCACHEHASH(wad, lump)];
+
+	while (*link && ((*link)->wad != wad || (*link)->lump != lump))
+		link = &(*link)->hashnext;
+
+	return link;
+}
+
+static void UnlinkLRU(decodedlump_t *entry)
+{
+	entry->prev->next = entry->next;
+	entry->next->prev = entry->prev;
+}
+
+static void LinkLRU(decodedlump_t *entry)
+{
+	entry->next = lumplru.next;
+	entry->prev = &lumplru;
+	lumplru.next->prev = entry;
+	lumplru.next = entry;
+}
+
+static void RemoveLump(decodedlump_t *entry)
+{
+	decodedlump_t **link = FindLumpLink(entry->wad, entry->lump);
+	*link = entry->hashnext;
+
+	if (entry->data)
+	{
+		UnlinkLRU(entry);
+		cachedbytes -= entry->size;
+		numcachedlumps--;
+		free(entry->data);
+	}
+
+	free(entry);
+}
+
+// Throw out the least recently used lumps until everything fits.
+static void TrimLumpCache(void)
+{
+	while (cachedbytes > cachebudget && lumplru.prev != &lumplru)
+	{
+		RemoveLump(lumplru.prev);
+		lumpcachestats.evicted++;
+	}
+}
+
+// A lump is ready, so put it in the cache for real.
+static void FinishLump(decodedlump_t *entry, UINT8 *data, size_t size)
+{
+	entry->data = data;
+	entry->size = size;
+	LinkLRU(entry);
+	cachedbytes += size;
+	numcachedlumps++;
+	TrimLumpCache();
+}
+
+static void LumpCacheSize_OnChange(void)
+{
+	LockLumpCache();
+	{
+		cachebudget = (size_t)cv_lumpcachesize.value << 20;
+		TrimLumpCache();
+	}
+	UnlockLumpCache();
+}
+
+boolean W_ReadDecompressedLump(UINT16 wad, UINT16 lump, void *dest, size_t size, size_t offset)
+{
+	decodedlump_t *entry;
+	boolean waited = false;
+
+	LockLumpCache();
+	{
+		entry = *FindLumpLink(wad, lump);
+
+#ifdef HAVE_THREADS
+		// It's still in a worker's hands, so wait for it.
+		// It's gone from the cache if that failed.
+		while (entry && !entry->data)
+		{
+			waited = true;
+			I_hold_cond(&lumpcache_ready_cond, lumpcache_mutex);
+			entry = *FindLumpLink(wad, lump);
+		}
+#endif
+
+		if (entry)
+		{
+			UnlinkLRU(entry);
+			LinkLRU(entry);
+			M_Memcpy(dest, entry->data + offset, size);
+
+			lumpcachestats.hits++;
+			if (waited)
+				lumpcachestats.waits++;
+		}
+		else
+			lumpcachestats.misses++;
+	}
+	UnlockLumpCache();
+
+	return (entry != NULL);
+}
+
+boolean W_CacheDecompressedLump(UINT16 wad, UINT16 lump, UINT8 *data, size_t size)
+{
+	decodedlump_t **link, *entry;
+	boolean cached = false;
+
+	LockLumpCache();
+	{
+		lumpcachestats.inflated += size;
+
+		link = FindLumpLink(wad, lump);
+		if (size <= cachebudget && *link == NULL)
+		{
+			entry = calloc(1, sizeof (*entry));
+			if (entry)
+			{
+				entry->wad = wad;
+				entry->lump = lump;
+				*link = entry;
+				FinishLump(entry, data, size);
+				cached = true;
+			}
+		}
+	}
+	UnlockLumpCache();
+
+	return cached;
+}
+
+#ifdef HAVE_THREADS
+static void DecompressThread(void *userdata)
+{
+	decompressjob_t *job;
+	decodedlump_t *entry;
+	UINT8 *data;
+
+	(void)userdata;
+
+	for (;;)
+	{
+		LockLumpCache();
+		{
+			while (!jobhead && !stopdecompressthreads)
+				I_hold_cond(&lumpcache_job_cond, lumpcache_mutex);
+
+			job = jobhead;
+			if (job)
+			{
+				jobhead = job->next;
+				if (!jobhead)
+					jobtail = NULL;
+			}
+		}
+		UnlockLumpCache();
+
+		if (stopdecompressthreads || I_thread_is_stopped() || !job)
+			return;
+
+		data = malloc(job->size);
+		if (data && W_DecompressData(job->method, job->raw, job->rawsize, data, job->size) != 0)
+		{
+			// Leave it to the main thread, which reports the error properly
+			free(data);
+			data = NULL;
+		}
+
+		LockLumpCache();
+		{
+			entry = *FindLumpLink(job->wad, job->lump);
+
+			if (data)
+			{
+				lumpcachestats.inflated += job->size;
+				lumpcachestats.inflatedbackground += job->size;
+				FinishLump(entry, data, job->size);
+			}
+			else
+				RemoveLump(entry);
+
+			I_wake_all_cond(&lumpcache_ready_cond);
+		}
+		UnlockLumpCache();
+
+		if (job->ownsraw)
+			free(job->raw);
+		free(job);
+	}
+}
+
+static void StopDecompressThreads(void)
+{
+	LockLumpCache();
+	{
+		stopdecompressthreads = true;
+		I_wake_all_cond(&lumpcache_job_cond);
+	}
+	UnlockLumpCache();
+}
+
+static void SpawnDecompressThreads(void)
+{
+	if (numdecompressthreads)
+		return;
+
+	I_AddExitFunc(StopDecompressThreads);
+
+	for (; numdecompressthreads < NUMDECOMPRESSTHREADS; numdecompressthreads++)
+		I_spawn_thread("lump-decompress", DecompressThread, NULL);
+}
+#endif
+
+void W_PrefetchLumpPwad(UINT16 wad, UINT16 lump)
+{
+#ifdef HAVE_THREADS
+	decodedlump_t **link;
+	decompressjob_t *job;
+	lumpinfo_t *l;
+	size_t mapsize;
+	UINT8 *map;
+
+	if (wad >= numwadfiles || lump >= wadfiles[wad]->numlumps)
+		return;
+
+	l = &wadfiles[wad]->lumpinfo[lump];
+	if (!l->size || (l->compression != CM_LZF
+#ifdef HAVE_ZLIB
+		&& l->compression != CM_DEFLATE
+#endif
+		))
+		return;
+
+	LockLumpCache();
+	{
+		link = FindLumpLink(wad, lump);
+
+		// Not worth it if it would just push itself back out
+		if (*link || l->size > cachebudget / 2)
+			link = NULL;
+		else
+		{
+			// Reserve its place, so it only gets queued once
+			*link = calloc(1, sizeof (**link));
+			if (*link)
+			{
+				(*link)->wad = wad;
+				(*link)->lump = lump;
+			}
+			else
+				link = NULL;
+		}
+	}
+	UnlockLumpCache();
+
+	if (!link)
+		return;
+
+	job = calloc(1, sizeof (*job));
+	if (!job)
+		I_Error("W_PrefetchLumpPwad: Out of memory");
+
+	job->wad = wad;
+	job->lump = lump;
+	job->method = l->compression;
+	job->rawsize = l->disksize;
+	job->size = l->size;
+
+	map = File_GetMapping(wadfiles[wad]->handle, &mapsize);
+	if (map && l->position <= mapsize && l->disksize <= mapsize - l->position)
+		job->raw = map + l->position;
+	else
+	{
+		job->raw = malloc(l->disksize);
+		job->ownsraw = true;
+
+		if (!job->raw || File_Seek(wadfiles[wad]->handle, (long)l->position, SEEK_SET) != 0
+			|| File_Read(job->raw, 1, l->disksize, wadfiles[wad]->handle) < l->disksize)
+		{
+			// Let the normal read deal with it
+			LockLumpCache();
+			RemoveLump(*FindLumpLink(wad, lump));
+			UnlockLumpCache();
+
+			free(job->raw);
+			free(job);
+			return;
+		}
+	}
+
+	SpawnDecompressThreads();
+
+	LockLumpCache();
+	{
+		if (jobtail)
+			jobtail->next = job;
+		else
+			jobhead = job;
+		jobtail = job;
+
+		lumpcachestats.prefetched++;
+		I_wake_one_cond(&lumpcache_job_cond);
+	}
+	UnlockLumpCache();
+#else
+	(void)wad;
+	(void)lump;
+#endif
+}
+
+void W_PrefetchLump(lumpnum_t lumpnum)
+{
+	W_PrefetchLumpPwad(WADFILENUM(lumpnum), LUMPNUM(lumpnum));
+}
+
+void Command_LumpCacheStats_f(void)
+{
+	LockLumpCache();
+	{
+		CONS_Printf(M_GetText("Decompressed lumps: %s (%s KB of %s KB)\n"),
+			sizeu1(numcachedlumps), sizeu2(cachedbytes>>10), sizeu3(cachebudget>>10));
+		CONS_Printf(M_GetText("Hits: %u (%u waited for), misses: %u\n"),
+			lumpcachestats.hits, lumpcachestats.waits, lumpcachestats.misses);
+		CONS_Printf(M_GetText("Prefetched: %u, evicted: %u\n"),
+			lumpcachestats.prefetched, lumpcachestats.evicted);
+		CONS_Printf(M_GetText("Decompressed: %s KB (%s KB in the background)\n"),
+			sizeu1((size_t)(lumpcachestats.inflated>>10)), sizeu2((size_t)(lumpcachestats.inflatedbackground>>10)));
+	}
+	UnlockLumpCache();
+}
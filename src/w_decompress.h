@@ -0,0 +1,42 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2022 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  w_decompress.h
+/// \brief Decompressed lump cache and background decompression
+
+#ifndef __W_DECOMPRESS__
+#define __W_DECOMPRESS__
+
+#include "doomtype.h"
+#include "command.h"
+#include "w_wad.h"
+
+extern consvar_t cv_lumpcachesize;
+
+// Decompresses a lump's raw data, safe to call from any thread.
+// Returns 0 on success, or an error code: zlib's for CM_DEFLATE,
+// and errno's for CM_LZF (-1 if it decompressed to the wrong size).
+INT32 W_DecompressData(compmethod method, const UINT8 *raw, size_t rawsize, UINT8 *out, size_t outsize);
+
+// Copies from a decompressed lump, if it's cached.
+// Waits for it if it's being decompressed in the background.
+boolean W_ReadDecompressedLump(UINT16 wad, UINT16 lump, void *dest, size_t size, size_t offset);
+
+// Adds a lump that was just decompressed to the cache, which takes
+// ownership of the data (allocated with malloc). Returns false if it
+// didn't fit, in which case the data is still the caller's to free.
+boolean W_CacheDecompressedLump(UINT16 wad, UINT16 lump, UINT8 *data, size_t size);
+
+// Starts decompressing a lump in the background, if it's compressed
+// and not cached yet, so it's ready by the time it gets read.
+void W_PrefetchLumpPwad(UINT16 wad, UINT16 lump);
+void W_PrefetchLump(lumpnum_t lumpnum);
+
+void Command_LumpCacheStats_f(void);
+
+#endif // __W_DECOMPRESS__
@@ -16,6 +16,14 @@
 
 #include "i_system.h"
 #include "console.h"
+#include "z_zone.h"
+
+#ifdef HAVE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 #ifdef HAVE_WHANDLE
 
@@ -53,10 +61,67 @@ const char *File_SDLError     (void *f);
 int         File_SDLEOF       (void *f);
 #endif
 
+//
+// Memory-mapped file operations
+//
+
+#ifdef HAVE_MMAP
+typedef struct
+{
+	UINT8 *data;
+	size_t size;
+	size_t pos;
+	boolean eof;
+} mappedfile_t;
+
+static mappedfile_t *File_Map(const char *filename);
+
+// File read / seek / tell
+size_t      File_MapRead      (void *f, void *ptr, size_t size, size_t count);
+int         File_MapSeek      (void *stream, long int offset, int origin);
+long int    File_MapTell      (void *stream);
+int         File_MapGetChar   (void *f);
+char       *File_MapGetString (void *f, char *str, int num);
+
+// File close / error
+int         File_MapClose     (void *f);
+const char *File_MapError     (void *f);
+int         File_MapEOF       (void *f);
+#endif
+
 // Open a file handle.
 void *File_Open(const char *filename, const char *filemode, fhandletype_t type)
 {
-	filehandle_t *handle = calloc(sizeof(filehandle_t), 1);
+	filehandle_t *handle;
+
+	if (type == FILEHANDLE_MMAP)
+	{
+#ifdef HAVE_MMAP
+		mappedfile_t *map = strchr(filemode, 'w') || strchr(filemode, 'a') || strchr(filemode, '+')
+			? NULL : File_Map(filename);
+
+		if (map)
+		{
+			handle = calloc(sizeof(filehandle_t), 1);
+			handle->type = type;
+			handle->read = &File_MapRead;
+			handle->seek = &File_MapSeek;
+			handle->tell = &File_MapTell;
+			handle->getchar = &File_MapGetChar;
+			handle->getstring = &File_MapGetString;
+			handle->close = &File_MapClose;
+			handle->error = &File_MapError;
+			handle->eof = &File_MapEOF;
+			handle->file = map;
+			return handle;
+		}
+#endif
+
+		// Can't be mapped (empty, not a regular file...), so read it normally
+		type = FILEHANDLE_STANDARD;
+	}
+
+	handle = calloc(sizeof(filehandle_t), 1);
 
 	handle->type = type;
 
@@ -130,6 +195,28 @@ int File_CheckError(void *f)
 	return 0;
 }
 
+// Get the start and size of a mapped file.
+void *File_GetMapping(void *f, size_t *size)
+{
+#ifdef HAVE_MMAP
+	filehandle_t *handle = (filehandle_t *)f;
+
+	if (handle->type == FILEHANDLE_MMAP)
+	{
+		mappedfile_t *map = (mappedfile_t *)handle->file;
+		if (size)
+			*size = map->size;
+		return map->data;
+	}
+#else
+	(void)f;
+#endif
+
+	if (size)
+		*size = 0;
+	return NULL;
+}
+
 //
 // Standard library file operations
 //
@@ -297,4 +384,162 @@ int File_SDLEOF(void *f)
 
 #endif // HAVE_SDL
 
+//
+// Memory-mapped file operations
+//
+
+#ifdef HAVE_MMAP
+// Map a whole file.
+// The mapping is read-only, and is only handed out for lumps cached with
+// tags whose users don't write to them. Everything else gets a copy.
+static mappedfile_t *File_Map(const char *filename)
+{
+	mappedfile_t *map;
+	struct stat st;
+	void *data;
+	int fd = open(filename, O_RDONLY);
+
+	if (fd == -1)
+		return NULL;
+
+	if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // The mapping stays valid without it
+
+	if (data == MAP_FAILED)
+		return NULL;
+
+	map = calloc(sizeof(mappedfile_t), 1);
+	map->data = data;
+	map->size = (size_t)st.st_size;
+
+	// Lumps handed out from the mapping can be passed to Z_Free
+	Z_AddExternalMemory(map->data, map->size);
+
+	return map;
+}
+
+// Read bytes from the mapping into a buffer.
+size_t File_MapRead(void *f, void *ptr, size_t size, size_t count)
+{
+	mappedfile_t *map = (mappedfile_t *)((filehandle_t *)f)->file;
+	size_t left = map->size - map->pos;
+
+	if (!size)
+		return 0;
+
+	if (count > left / size)
+	{
+		count = left / size;
+		map->eof = true;
+	}
+
+	M_Memcpy(ptr, map->data + map->pos, size * count);
+	map->pos += size * count;
+	return count;
+}
+
+// Seek to the specified position in the mapping.
+int File_MapSeek(void *f, long int offset, int origin)
+{
+	mappedfile_t *map = (mappedfile_t *)((filehandle_t *)f)->file;
+	long int position = offset;
+
+	if (origin == SEEK_CUR)
+		position += (long int)map->pos;
+	else if (origin == SEEK_END)
+		position += (long int)map->size;
+
+	if (position < 0)
+		return -1;
+
+	// Anything past the end just reads nothing
+	map->pos = min((size_t)position, map->size);
+	map->eof = false;
+	return 0;
+}
+
+// Get the current position in the mapping.
+long int File_MapTell(void *f)
+{
+	mappedfile_t *map = (mappedfile_t *)((filehandle_t *)f)->file;
+	return (long int)map->pos;
+}
+
+// Read a single character from the mapping.
+int File_MapGetChar(void *f)
+{
+	mappedfile_t *map = (mappedfile_t *)((filehandle_t *)f)->file;
+
+	if (map->pos >= map->size)
+	{
+		map->eof = true;
+		return EOF;
+	}
+
+	return map->data[map->pos++];
+}
+
+// Same as fgets.
+char *File_MapGetString(void *f, char *str, int num)
+{
+	mappedfile_t *map = (mappedfile_t *)((filehandle_t *)f)->file;
+	int i = 0;
+
+	if (num <= 0)
+		return NULL;
+
+	while (i < num - 1)
+	{
+		if (map->pos >= map->size)
+		{
+			map->eof = true;
+			break;
+		}
+
+		str[i] = (char)map->data[map->pos++];
+		if (str[i++] == '\n')
+			break;
+	}
+
+	if (!i)
+		return NULL;
+
+	str[i] = '\0';
+	return str;
+}
+
+// Unmap the file.
+int File_MapClose(void *f)
+{
+	mappedfile_t *map = (mappedfile_t *)f;
+	int ok;
+
+	Z_RemoveExternalMemory(map->data);
+	ok = munmap(map->data, map->size);
+	free(map);
+
+	return ok;
+}
+
+// Get latest file error.
+const char *File_MapError(void *f)
+{
+	(void)f;
+	return "end-of-file"; // Reading from memory can't fail otherwise
+}
+
+// Check for end-of-file.
+int File_MapEOF(void *f)
+{
+	mappedfile_t *map = (mappedfile_t *)((filehandle_t *)f)->file;
+	return map->eof;
+}
+#endif // HAVE_MMAP
+
 #endif
@@ -25,8 +25,14 @@ typedef enum
 {
 	FILEHANDLE_STANDARD, // stdlib handle
 	FILEHANDLE_SDL,      // sdl rwops
+	FILEHANDLE_MMAP,     // whole file mapped into memory, falls back to FILEHANDLE_STANDARD
 } fhandletype_t;
 
+// Memory-mapped files, so lumps can be read in place
+#if defined (HAVE_WHANDLE) && defined (UNIXCOMMON) && !defined (NOMMAP)
+#define HAVE_MMAP
+#endif
+
 #ifdef HAVE_WHANDLE
 // WAD file handle
 // This is read-only - WADs are not writable.
@@ -54,6 +60,9 @@ void       *File_Open(const char *filename, const char *filemode, fhandletype_t
 int         File_Close(void *stream);
 int         File_CheckError(void *stream);
 
+// Where a mapped file's contents start in memory, or NULL if it isn't mapped
+void       *File_GetMapping(void *stream, size_t *size);
+
 // Macros for file operations
 #define File_Read(ptr, size, count, fhandle) ((filehandle_t *)fhandle)->read(((filehandle_t *)fhandle), ptr, size, count)
 #define File_Seek(fhandle, offset, origin)   ((filehandle_t *)fhandle)->seek(((filehandle_t *)fhandle), offset, origin)
@@ -76,6 +85,7 @@ int         File_CheckError(void *stream);
 #define File_Close fclose
 #define File_Error M_FileError
 #define File_EOF feof
+#define File_GetMapping(fhandle, size) NULL
 
 #endif // HAVE_WHANDLE
 
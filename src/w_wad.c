@@ -49,6 +49,7 @@
 #include "doomtype.h"
 
 #include "w_wad.h"
+#include "w_decompress.h"
 #include "z_zone.h"
 #include "fastcmp.h"
 
@@ -66,10 +67,12 @@
 #include "i_system.h"
 #include "i_video.h" // rendermode
 #include "md5.h"
+#include "m_md5cache.h"
 #include "lua_script.h"
 #ifdef SCANTHINGS
 #include "p_setup.h" // P_ScanThings
 #endif
+#include "m_argv.h"
 #include "m_misc.h" // M_MapNumber
 #include "g_game.h" // G_SetGameModified
 
@@ -106,17 +109,18 @@ typedef struct
 	size_t len;
 } lumpchecklist_t;
 
-// Lumpnum cache
-#define LUMPNUMCACHESIZE 64 // Must be a power of two
-
-typedef struct lumpnum_cache_s
+// Lump name index over every loaded file, with later files overriding
+// earlier ones. Open addressing, LUMPERROR marks an empty slot.
+typedef struct
 {
-	char lumpname[32];
-	lumpnum_t lumpnum;
-} lumpnum_cache_t;
+	lumpnum_t *slots;
+	UINT32 mask;
+	UINT32 count;
+	boolean longnames;
+} lumpindex_t;
 
-static lumpnum_cache_t lumpnumcache[LUMPNUMCACHESIZE];
-static UINT16 lumpnumcacheindex = 0;
+static lumpindex_t lumpnameindex = {NULL, 0, 0, false};
+static lumpindex_t longnameindex = {NULL, 0, 0, true};
 
 //===========================================================================
 //                                                                    GLOBALS
@@ -156,10 +160,17 @@ void W_Shutdown(void)
 		}
 
 		Z_Free(wad->lumpinfo);
+		Z_Free(wad->namehash.buckets);
+		Z_Free(wad->longnamehash.buckets);
+		Z_Free(wad->fullnameorder);
 		Z_Free(wad);
 	}
 
 	Z_Free(wadfiles);
+
+	Z_Free(lumpnameindex.slots);
+	Z_Free(longnameindex.slots);
+	lumpnameindex.slots = longnameindex.slots = NULL;
 }
 
 //===========================================================================
@@ -812,7 +823,14 @@ static inline INT32 W_MakeFileMD5(const char *filename, fhandletype_t handletype
 
 #ifndef HAVE_WHANDLE
 	(void)handletype;
+#else
+	if (handletype != FILEHANDLE_SDL)
 #endif
+	{
+		// Skips hashing it if it hasn't changed since the last time
+		if (M_GetFileMD5(filename, resblock))
+			return 0;
+	}
 
 	if ((fhandle = File_Open(filename, "rb", handletype)) != NULL)
 	{
@@ -832,10 +850,199 @@ static inline INT32 W_MakeFileMD5(const char *filename, fhandletype_t handletype
 	return 1;
 }
 
-// Invalidates the cache of lump numbers. Call this whenever a wad is added.
-static void W_InvalidateLumpnumCache(void)
+// Files that are kept open get mapped if possible, so that
+// uncompressed lumps can be used right where they are.
+static fhandletype_t W_WadHandleType(fhandletype_t type)
+{
+#ifdef HAVE_MMAP
+	if (type == FILEHANDLE_STANDARD && !M_CheckParm("-nommap"))
+		return FILEHANDLE_MMAP;
+#endif
+	return type;
+}
+
+//
+// Lump name indexes
+//
+
+static UINT32 W_HashLumpName(const char *name)
+{
+	UINT32 hash = 2166136261u;
+	while (*name)
+		hash = (hash ^ (UINT8)*name++) * 16777619u;
+	return hash;
+}
+
+static inline const char *W_IndexedName(const lumpinfo_t *lump, boolean longnames)
+{
+	return longnames ? lump->longname : lump->name;
+}
+
+static void W_BuildLumpHash(wadfile_t *wad, lumphash_t *hash, boolean longnames)
+{
+	UINT32 size = 1;
+	UINT16 i;
+
+	while (size < wad->numlumps)
+		size <<= 1;
+
+	hash->buckets = Z_Malloc((size + wad->numlumps) * sizeof (*hash->buckets), PU_STATIC, NULL);
+	hash->next = hash->buckets + size;
+	hash->mask = size - 1;
+	memset(hash->buckets, 0xFF, size * sizeof (*hash->buckets));
+
+	// Add them backwards, so that each chain ends up in lump order
+	for (i = wad->numlumps; i-- > 0;)
+	{
+		UINT32 bucket = W_HashLumpName(W_IndexedName(&wad->lumpinfo[i], longnames)) & hash->mask;
+		hash->next[i] = hash->buckets[bucket];
+		hash->buckets[bucket] = i;
+	}
+}
+
+// First lump from startlump on named exactly name, or INT16_MAX.
+static UINT16 W_FindHashedLump(wadfile_t *wad, const lumphash_t *hash, boolean longnames, const char *name, UINT16 startlump)
+{
+	UINT16 i;
+
+	for (i = hash->buckets[W_HashLumpName(name) & hash->mask]; i != UINT16_MAX; i = hash->next[i])
+		if (i >= startlump && !strcmp(W_IndexedName(&wad->lumpinfo[i], longnames), name))
+			return i;
+
+	return INT16_MAX;
+}
+
+static lumpinfo_t *sortlumpinfo;
+
+static int W_CompareFullNames(const void *a, const void *b)
+{
+	return stricmp(sortlumpinfo[*(const UINT16 *)a].fullname, sortlumpinfo[*(const UINT16 *)b].fullname);
+}
+
+static void W_SortFullNames(wadfile_t *wad)
+{
+	UINT16 i;
+
+	wad->fullnameorder = Z_Malloc(max(wad->numlumps, 1) * sizeof (*wad->fullnameorder), PU_STATIC, NULL);
+	for (i = 0; i < wad->numlumps; i++)
+		wad->fullnameorder[i] = i;
+
+	sortlumpinfo = wad->lumpinfo;
+	qsort(wad->fullnameorder, wad->numlumps, sizeof (*wad->fullnameorder), W_CompareFullNames);
+}
+
+// First lump from startlump on whose full name starts with name,
+// ignoring case, or the file's lump count if there's none.
+// All of those sort next to each other, so only they are looked at.
+static UINT16 W_FindFullNamePrefix(wadfile_t *wad, const char *name, UINT16 startlump)
+{
+	const size_t len = strlen(name);
+	const UINT16 *order = wad->fullnameorder;
+	size_t lo = 0, hi = wad->numlumps;
+	UINT16 found = wad->numlumps;
+
+	while (lo < hi)
+	{
+		size_t mid = (lo + hi) / 2;
+		if (strnicmp(wad->lumpinfo[order[mid]].fullname, name, len) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (; lo < wad->numlumps && !strnicmp(wad->lumpinfo[order[lo]].fullname, name, len); lo++)
+		if (order[lo] >= startlump && order[lo] < found)
+			found = order[lo];
+
+	return found;
+}
+
+static inline const char *W_IndexedLumpName(lumpnum_t lumpnum, boolean longnames)
+{
+	return W_IndexedName(&wadfiles[WADFILENUM(lumpnum)]->lumpinfo[LUMPNUM(lumpnum)], longnames);
+}
+
+static void W_GrowLumpIndex(lumpindex_t *index)
+{
+	lumpnum_t *oldslots = index->slots;
+	UINT32 oldsize = oldslots ? index->mask + 1 : 0;
+	UINT32 size = oldsize ? oldsize * 2 : 4096;
+	UINT32 i, slot;
+
+	index->slots = Z_Malloc(size * sizeof (*index->slots), PU_STATIC, NULL);
+	index->mask = size - 1;
+	memset(index->slots, 0xFF, size * sizeof (*index->slots));
+
+	for (i = 0; i < oldsize; i++)
+	{
+		if (oldslots[i] == LUMPERROR)
+			continue;
+
+		slot = W_HashLumpName(W_IndexedLumpName(oldslots[i], index->longnames)) & index->mask;
+		while (index->slots[slot] != LUMPERROR)
+			slot = (slot + 1) & index->mask;
+		index->slots[slot] = oldslots[i];
+	}
+
+	if (oldslots)
+		Z_Free(oldslots);
+}
+
+static void W_AddToLumpIndex(lumpindex_t *index, lumpnum_t lumpnum)
+{
+	const char *name = W_IndexedLumpName(lumpnum, index->longnames);
+	UINT32 slot;
+
+	// Keep it at most half full
+	if (!index->slots || (index->count + 1) * 2 > index->mask + 1)
+		W_GrowLumpIndex(index);
+
+	for (slot = W_HashLumpName(name) & index->mask; index->slots[slot] != LUMPERROR; slot = (slot + 1) & index->mask)
+	{
+		lumpnum_t other = index->slots[slot];
+
+		if (strcmp(W_IndexedLumpName(other, index->longnames), name))
+			continue;
+
+		// Later files take precedence, but inside a file the first lump does
+		if (WADFILENUM(other) != WADFILENUM(lumpnum))
+			index->slots[slot] = lumpnum;
+		return;
+	}
+
+	index->slots[slot] = lumpnum;
+	index->count++;
+}
+
+static lumpnum_t W_FindIndexedLump(const lumpindex_t *index, const char *name)
+{
+	UINT32 slot;
+
+	if (!index->slots)
+		return LUMPERROR;
+
+	for (slot = W_HashLumpName(name) & index->mask; index->slots[slot] != LUMPERROR; slot = (slot + 1) & index->mask)
+		if (!strcmp(W_IndexedLumpName(index->slots[slot], index->longnames), name))
+			return index->slots[slot];
+
+	return LUMPERROR;
+}
+
+// Builds the name lookups for a file that was just added.
+static void W_IndexLumps(UINT16 wadnum)
 {
-	memset(lumpnumcache, 0, sizeof (lumpnumcache));
+	wadfile_t *wad = wadfiles[wadnum];
+	UINT16 i;
+
+	W_BuildLumpHash(wad, &wad->namehash, false);
+	W_BuildLumpHash(wad, &wad->longnamehash, true);
+	W_SortFullNames(wad);
+
+	for (i = 0; i < wad->numlumps; i++)
+	{
+		W_AddToLumpIndex(&lumpnameindex, ((lumpnum_t)wadnum << 16) + i);
+		W_AddToLumpIndex(&longnameindex, ((lumpnum_t)wadnum << 16) + i);
+	}
 }
 
 /** Detect a file type.
@@ -1392,7 +1599,7 @@ UINT16 W_InitFile(const char *filename, fhandletype_t handletype, boolean mainfi
 		handletype = wadhandle->type;
 		filename = wadhandle->filename;
 	}
-	else if ((handle = W_OpenWadFile(&filename, handletype, true)) == NULL)
+	else if ((handle = W_OpenWadFile(&filename, W_WadHandleType(handletype), true)) == NULL)
 		return W_InitFileError(filename, startup);
 
 	important = W_VerifyNMUSlumps(filename, handletype, startup);
@@ -1412,6 +1619,8 @@ UINT16 W_InitFile(const char *filename, fhandletype_t handletype, boolean mainfi
 	// an MD5 of an already added WAD file!
 	//
 	W_MakeFileMD5(filename, handletype, md5sum);
+	if (!startup)
+		M_SaveMD5Cache();
 
 	for (i = 0; i < numwadfiles; i++)
 	{
@@ -1490,6 +1699,8 @@ UINT16 W_InitFile(const char *filename, fhandletype_t handletype, boolean mainfi
 	wadfiles[numwadfiles] = wadfile;
 	numwadfiles++; // must come BEFORE W_LoadDehackedLumps, so any addfile called by COM_BufInsertText called by Lua doesn't overwrite what we just loaded
 
+	W_IndexLumps(numwadfiles - 1);
+
 	// Read shaders from file
 	W_ReadFileShaders(wadfile);
 
@@ -1513,7 +1724,6 @@ UINT16 W_InitFile(const char *filename, fhandletype_t handletype, boolean mainfi
 		break;
 	}
 
-	W_InvalidateLumpnumCache();
 	return wadfile->numlumps;
 }
 
@@ -1667,9 +1877,10 @@ UINT16 W_InitFolder(const char *path, boolean mainfile, boolean startup)
 	wadfiles[numwadfiles] = wadfile;
 	numwadfiles++;
 
+	W_IndexLumps(numwadfiles - 1);
+
 	W_ReadFileShaders(wadfile);
 	W_LoadDehackedLumpsPK3(numwadfiles - 1, mainfile);
-	W_InvalidateLumpnumCache();
 
 	return wadfile->numlumps;
 }
@@ -1749,7 +1960,6 @@ const char *W_CheckNameForNum(lumpnum_t lumpnum)
 //
 UINT16 W_CheckNumForNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 {
-	UINT16 i;
 	static char uname[8 + 1];
 
 	if (!TestValidLump(wad,0))
@@ -1759,17 +1969,11 @@ UINT16 W_CheckNumForNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 	strupr(uname);
 
 	//
-	// scan forward
 	// start at 'startlump', useful parameter when there are multiple
 	//                       resources with the same name
 	//
 	if (startlump < wadfiles[wad]->numlumps)
-	{
-		lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
-		for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
-			if (!strncmp(lump_p->name, uname, sizeof(uname) - 1))
-				return i;
-	}
+		return W_FindHashedLump(wadfiles[wad], &wadfiles[wad]->namehash, false, uname, startlump);
 
 	// not found.
 	return INT16_MAX;
@@ -1783,7 +1987,6 @@ UINT16 W_CheckNumForNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 //
 UINT16 W_CheckNumForLongNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 {
-	UINT16 i;
 	static char uname[256 + 1];
 
 	if (!TestValidLump(wad,0))
@@ -1793,17 +1996,11 @@ UINT16 W_CheckNumForLongNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 	strupr(uname);
 
 	//
-	// scan forward
 	// start at 'startlump', useful parameter when there are multiple
 	//                       resources with the same name
 	//
 	if (startlump < wadfiles[wad]->numlumps)
-	{
-		lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
-		for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
-			if (!strcmp(lump_p->longname, uname))
-				return i;
-	}
+		return W_FindHashedLump(wadfiles[wad], &wadfiles[wad]->longnamehash, true, uname, startlump);
 
 	// not found.
 	return INT16_MAX;
@@ -1822,26 +2019,19 @@ W_CheckNumForMarkerStartPwad (const char *name, UINT16 wad, UINT16 startlump)
 // Look for the first lump from a folder.
 UINT16 W_CheckNumForFolderStartPK3(const char *name, UINT16 wad, UINT16 startlump)
 {
-	size_t name_length;
-	INT32 i;
-	lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
-	name_length = strlen(name);
-	for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
-	{
-		if (strnicmp(name, lump_p->fullname, name_length) == 0)
-		{
-			/* SLADE is special and puts a single directory entry. Skip that. */
-			if (strlen(lump_p->fullname) == name_length)
-				i++;
-			break;
-		}
-	}
+	UINT16 i = W_FindFullNamePrefix(wadfiles[wad], name, startlump);
+
+	/* SLADE is special and puts a single directory entry. Skip that. */
+	if (i < wadfiles[wad]->numlumps && strlen(wadfiles[wad]->lumpinfo[i].fullname) == strlen(name))
+		i++;
+
 	return i;
 }
 
 // In a PK3 type of resource file, it looks for the next lumpinfo entry that doesn't share the specified pathfile.
 // Useful for finding folder ends.
 // Returns the position of the lumpinfo entry.
+// This only walks the folder itself, which the caller is about to do anyway.
 UINT16 W_CheckNumForFolderEndPK3(const char *name, UINT16 wad, UINT16 startlump)
 {
 	INT32 i;
@@ -1858,17 +2048,13 @@ UINT16 W_CheckNumForFolderEndPK3(const char *name, UINT16 wad, UINT16 startlump)
 // Returns lump position in PK3's lumpinfo, or INT16_MAX if not found.
 UINT16 W_CheckNumForFullNamePK3(const char *name, UINT16 wad, UINT16 startlump)
 {
-	INT32 i;
-	lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
-	for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
-	{
-		if (!strnicmp(name, lump_p->fullname, strlen(name)))
-		{
-			return i;
-		}
-	}
+	UINT16 i = W_FindFullNamePrefix(wadfiles[wad], name, startlump);
+
 	// Not found at all?
-	return INT16_MAX;
+	if (i >= wadfiles[wad]->numlumps)
+		return INT16_MAX;
+
+	return i;
 }
 
 //
@@ -1877,43 +2063,15 @@ UINT16 W_CheckNumForFullNamePK3(const char *name, UINT16 wad, UINT16 startlump)
 //
 lumpnum_t W_CheckNumForName(const char *name)
 {
-	INT32 i;
-	lumpnum_t check = INT16_MAX;
+	char uname[8 + 1];
 
 	if (!*name) // some doofus gave us an empty string?
 		return LUMPERROR;
 
-	// Check the lumpnumcache first. Loop backwards so that we check
-	// most recent entries first
-	for (i = lumpnumcacheindex + LUMPNUMCACHESIZE; i > lumpnumcacheindex; i--)
-	{
-		if (!lumpnumcache[i & (LUMPNUMCACHESIZE - 1)].lumpname[8]
-			&& strncmp(lumpnumcache[i & (LUMPNUMCACHESIZE - 1)].lumpname, name, 8) == 0)
-		{
-			lumpnumcacheindex = i & (LUMPNUMCACHESIZE - 1);
-			return lumpnumcache[lumpnumcacheindex].lumpnum;
-		}
-	}
-
-	// scan wad files backwards so patch lump files take precedence
-	for (i = numwadfiles - 1; i >= 0; i--)
-	{
-		check = W_CheckNumForNamePwad(name,(UINT16)i,0);
-		if (check != INT16_MAX)
-			break; //found it
-	}
-
-	if (check == INT16_MAX) return LUMPERROR;
-	else
-	{
-		// Update the cache.
-		lumpnumcacheindex = (lumpnumcacheindex + 1) & (LUMPNUMCACHESIZE - 1);
-		memset(lumpnumcache[lumpnumcacheindex].lumpname, '\0', 32);
-		strncpy(lumpnumcache[lumpnumcacheindex].lumpname, name, 8);
-		lumpnumcache[lumpnumcacheindex].lumpnum = (i<<16)+check;
+	strlcpy(uname, name, sizeof uname);
+	strupr(uname);
 
-		return lumpnumcache[lumpnumcacheindex].lumpnum;
-	}
+	return W_FindIndexedLump(&lumpnameindex, uname);
 }
 
 //
@@ -1924,45 +2082,15 @@ lumpnum_t W_CheckNumForName(const char *name)
 //
 lumpnum_t W_CheckNumForLongName(const char *name)
 {
-	INT32 i;
-	lumpnum_t check = INT16_MAX;
+	char uname[256 + 1];
 
 	if (!*name) // some doofus gave us an empty string?
 		return LUMPERROR;
 
-	// Check the lumpnumcache first. Loop backwards so that we check
-	// most recent entries first
-	for (i = lumpnumcacheindex + LUMPNUMCACHESIZE; i > lumpnumcacheindex; i--)
-	{
-		if (strcmp(lumpnumcache[i & (LUMPNUMCACHESIZE - 1)].lumpname, name) == 0)
-		{
-			lumpnumcacheindex = i & (LUMPNUMCACHESIZE - 1);
-			return lumpnumcache[lumpnumcacheindex].lumpnum;
-		}
-	}
-
-	// scan wad files backwards so patch lump files take precedence
-	for (i = numwadfiles - 1; i >= 0; i--)
-	{
-		check = W_CheckNumForLongNamePwad(name,(UINT16)i,0);
-		if (check != INT16_MAX)
-			break; //found it
-	}
-
-	if (check == INT16_MAX) return LUMPERROR;
-	else
-	{
-		if (strlen(name) < 32)
-		{
-			// Update the cache.
-			lumpnumcacheindex = (lumpnumcacheindex + 1) & (LUMPNUMCACHESIZE - 1);
-			memset(lumpnumcache[lumpnumcacheindex].lumpname, '\0', 32);
-			strlcpy(lumpnumcache[lumpnumcacheindex].lumpname, name, 32);
-			lumpnumcache[lumpnumcacheindex].lumpnum = (i << 16) + check;
-		}
+	strlcpy(uname, name, sizeof uname);
+	strupr(uname);
 
-		return (i << 16) + check;
-	}
+	return W_FindIndexedLump(&longnameindex, uname);
 }
 
 // Look for valid map data through all added files in descendant order.
@@ -1976,9 +2104,11 @@ lumpnum_t W_CheckNumForMap(const char *name)
 	{
 		if (wadfiles[i]->type == RET_WAD)
 		{
-			for (lumpNum = 0; lumpNum < wadfiles[i]->numlumps; lumpNum++)
-				if (!strncmp(name, (wadfiles[i]->lumpinfo + lumpNum)->name, 8))
-					return (i<<16) + lumpNum;
+			char mapname[8 + 1];
+			strlcpy(mapname, name, sizeof mapname);
+			lumpNum = W_FindHashedLump(wadfiles[i], &wadfiles[i]->namehash, false, mapname, 0);
+			if (lumpNum != INT16_MAX)
+				return (i<<16) + lumpNum;
 		}
 		else if (W_FileHasFolders(wadfiles[i]))
 		{
@@ -2068,18 +2198,85 @@ lumpnum_t W_CheckNumForNameInBlock(const char *name, const char *blockstart, con
 }
 
 // Used by Lua. Case sensitive lump checking, quickly...
-#include "fastcmp.h"
 UINT8 W_LumpExists(const char *name)
 {
-	INT32 i,j;
+	return (W_FindIndexedLump(&longnameindex, name) != LUMPERROR);
+}
+
+// The plain scans the name indexes replaced, kept to compare against.
+static lumpnum_t W_ScanNumForName(const char *name, boolean longnames)
+{
+	char uname[256 + 1];
+	INT32 i, j;
+
+	strlcpy(uname, name, longnames ? sizeof uname : 8 + 1);
+	strupr(uname);
+
 	for (i = numwadfiles - 1; i >= 0; i--)
 	{
 		lumpinfo_t *lump_p = wadfiles[i]->lumpinfo;
 		for (j = 0; j < wadfiles[i]->numlumps; ++j, ++lump_p)
-			if (fastcmp(lump_p->longname, name))
-				return true;
+			if (!strcmp(W_IndexedName(lump_p, longnames), uname))
+				return (i<<16) + j;
 	}
-	return false;
+	return LUMPERROR;
+}
+
+static void W_BenchLumpLookups(boolean longnames, INT32 passes)
+{
+	lumpnum_t (*lookup)(const char *) = longnames ? W_CheckNumForLongName : W_CheckNumForName;
+	precise_t t;
+	INT64 scantime = 0, indextime = 0;
+	UINT32 lookups = 0, mismatches = 0;
+	INT32 pass, i, j;
+
+	for (pass = 0; pass < passes; pass++)
+	{
+		for (i = 0; i < numwadfiles; i++)
+		{
+			for (j = 0; j < wadfiles[i]->numlumps; j++)
+			{
+				const char *name = W_IndexedName(&wadfiles[i]->lumpinfo[j], longnames);
+				lumpnum_t scanned, indexed;
+
+				if (!*name)
+					continue;
+
+				t = I_GetPreciseTime();
+				scanned = W_ScanNumForName(name, longnames);
+				scantime += I_GetPreciseTime() - t;
+
+				t = I_GetPreciseTime();
+				indexed = lookup(name);
+				indextime += I_GetPreciseTime() - t;
+
+				if (scanned != indexed)
+					mismatches++;
+				lookups++;
+			}
+		}
+	}
+
+	scantime = max(I_PreciseToMicros(scantime), 1);
+	indextime = max(I_PreciseToMicros(indextime), 1);
+
+	CONS_Printf("%s: %u lookups\n", longnames ? "Long names" : "Short names", lookups);
+	CONS_Printf("  scan:  %s lookups/sec\n", sizeu1((size_t)(lookups * INT64_C(1000000) / scantime)));
+	CONS_Printf("  index: %s lookups/sec\n", sizeu1((size_t)(lookups * INT64_C(1000000) / indextime)));
+	if (mismatches)
+		CONS_Alert(CONS_WARNING, "%u lookups gave a different lump!\n", mismatches);
+}
+
+// lumpbench [passes]: times looking up every lump name in every loaded file
+void Command_Lumpbench_f(void)
+{
+	INT32 passes = 1;
+
+	if (COM_Argc() > 1)
+		passes = max(atoi(COM_Argv(1)), 1);
+
+	W_BenchLumpLookups(false, passes);
+	W_BenchLumpLookups(true, passes);
 }
 
 size_t W_LumpLengthPwad(UINT16 wad, UINT16 lump)
@@ -2197,6 +2394,91 @@ void zerr(int ret)
 }
 #endif
 
+// Decompresses a whole lump into a malloc'd buffer. The raw data is
+// read straight out of the mapping if the file is mapped.
+static UINT8 *W_DecompressLump(UINT16 wad, UINT16 lump)
+{
+	lumpinfo_t *l = wadfiles[wad]->lumpinfo + lump;
+	void *handle = wadfiles[wad]->handle;
+	UINT8 *rawData; // The lump's raw data.
+	UINT8 *decData; // Lump's decompressed real data.
+	UINT8 *map;
+	size_t mapsize;
+	INT32 err;
+
+	decData = malloc(l->size);
+	if (!decData)
+		I_Error("wad %d, lump %d: out of memory decompressing %s bytes", wad, lump, sizeu1(l->size));
+
+	map = File_GetMapping(handle, &mapsize);
+	if (map && l->position <= mapsize && l->disksize <= mapsize - l->position)
+	{
+		err = W_DecompressData(l->compression, map + l->position, l->disksize, decData, l->size);
+	}
+	else
+	{
+		rawData = malloc(l->disksize);
+		if (!rawData)
+			I_Error("wad %d, lump %d: out of memory reading %s bytes", wad, lump, sizeu1(l->disksize));
+
+		File_Seek(handle, (long)l->position, SEEK_SET);
+		if (File_Read(rawData, 1, l->disksize, handle) < l->disksize)
+			I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
+
+		err = W_DecompressData(l->compression, rawData, l->disksize, decData, l->size);
+		free(rawData);
+	}
+
+	if (err != 0)
+	{
+		free(decData);
+
+#ifdef HAVE_ZLIB
+		if (l->compression == CM_DEFLATE)
+		{
+			zerr(err);
+			return NULL;
+		}
+#endif
+
+#ifndef AVOID_ERRNO
+		// errno is a global var set by the lzf functions when something goes wrong.
+		if (err == E2BIG)
+			I_Error("wad %d, lump %d: compressed data too big (bigger than %s)", wad, lump, sizeu1(l->size));
+		else if (err == EINVAL)
+			I_Error("wad %d, lump %d: invalid compressed data", wad, lump);
+#endif
+		I_Error("wad %d, lump %d: decompressed to wrong number of bytes (expected %s)", wad, lump, sizeu1(l->size));
+	}
+
+	return decData;
+}
+
+// Reads part of a compressed lump, through the decompressed lump cache.
+static size_t W_ReadCompressedLump(UINT16 wad, UINT16 lump, void *dest, size_t size, size_t offset)
+{
+	lumpinfo_t *l = wadfiles[wad]->lumpinfo + lump;
+	UINT8 *decData;
+
+	if (!W_ReadDecompressedLump(wad, lump, dest, size, offset))
+	{
+		decData = W_DecompressLump(wad, lump);
+		if (!decData)
+			return 0;
+
+		M_Memcpy(dest, decData + offset, size);
+
+		if (!W_CacheDecompressedLump(wad, lump, decData, l->size))
+			free(decData);
+	}
+
+#ifdef NO_PNG_LUMPS
+	if (Picture_IsLumpPNG((UINT8 *)dest, size))
+		Picture_ThrowPNGError(l->fullname, wadfiles[wad]->filename);
+#endif
+	return size;
+}
+
 /** Reads bytes from the head of a lump.
   * Note: If the lump is compressed, the whole thing has to be read anyway.
   *
@@ -2283,108 +2565,15 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 #endif
 		return bytesread;
 	case CM_LZF:		// Is it LZF compressed? Used by ZWADs.
-		{
 #ifdef ZWAD
-			char *rawData; // The lump's raw data.
-			char *decData; // Lump's decompressed real data.
-			size_t retval; // Helper var, lzf_decompress returns 0 when an error occurs.
-
-			rawData = Z_Malloc(l->disksize, PU_STATIC, NULL);
-			decData = Z_Malloc(l->size, PU_STATIC, NULL);
-
-			if (File_Read(rawData, 1, l->disksize, handle) < l->disksize)
-				I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
-			retval = lzf_decompress(rawData, l->disksize, decData, l->size);
-#ifndef AVOID_ERRNO
-			if (retval == 0) // If this was returned, check if errno was set
-			{
-				// errno is a global var set by the lzf functions when something goes wrong.
-				if (errno == E2BIG)
-					I_Error("wad %d, lump %d: compressed data too big (bigger than %s)", wad, lump, sizeu1(l->size));
-				else if (errno == EINVAL)
-					I_Error("wad %d, lump %d: invalid compressed data", wad, lump);
-			}
-			// Otherwise, fall back on below error (if zero was actually the correct size then ???)
-#endif
-			if (retval != l->size)
-			{
-				I_Error("wad %d, lump %d: decompressed to wrong number of bytes (expected %s, got %s)", wad, lump, sizeu1(l->size), sizeu2(retval));
-			}
-
-			if (!decData) // Did we get no data at all?
-				return 0;
-			M_Memcpy(dest, decData + offset, size);
-			Z_Free(rawData);
-			Z_Free(decData);
-#ifdef NO_PNG_LUMPS
-			if (Picture_IsLumpPNG((UINT8 *)dest, size))
-				Picture_ThrowPNGError(l->fullname, wadfiles[wad]->filename);
-#endif
-			return size;
+		return W_ReadCompressedLump(wad, lump, dest, size, offset);
 #else
-			//I_Error("ZWAD files not supported on this platform.");
-			return 0;
+		//I_Error("ZWAD files not supported on this platform.");
+		return 0;
 #endif
-
-		}
 #ifdef HAVE_ZLIB
 	case CM_DEFLATE: // Is it compressed via DEFLATE? Very common in ZIPs/PK3s, also what most doom-related editors support.
-		{
-			UINT8 *rawData; // The lump's raw data.
-			UINT8 *decData; // Lump's decompressed real data.
-
-			int zErr; // Helper var.
-			z_stream strm;
-			unsigned long rawSize = l->disksize;
-			unsigned long decSize = l->size;
-
-			rawData = Z_Malloc(rawSize, PU_STATIC, NULL);
-			decData = Z_Malloc(decSize, PU_STATIC, NULL);
-
-			if (File_Read(rawData, 1, rawSize, handle) < rawSize)
-				I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
-
-			strm.zalloc = Z_NULL;
-			strm.zfree = Z_NULL;
-			strm.opaque = Z_NULL;
-
-			strm.total_in = strm.avail_in = rawSize;
-			strm.total_out = strm.avail_out = decSize;
-
-			strm.next_in = rawData;
-			strm.next_out = decData;
-
-			zErr = inflateInit2(&strm, -15);
-			if (zErr == Z_OK)
-			{
-				zErr = inflate(&strm, Z_FINISH);
-				if (zErr == Z_STREAM_END)
-				{
-					M_Memcpy(dest, decData, size);
-				}
-				else
-				{
-					size = 0;
-					zerr(zErr);
-				}
-
-				(void)inflateEnd(&strm);
-			}
-			else
-			{
-				size = 0;
-				zerr(zErr);
-			}
-
-			Z_Free(rawData);
-			Z_Free(decData);
-
-#ifdef NO_PNG_LUMPS
-			if (Picture_IsLumpPNG((UINT8 *)dest, size))
-				Picture_ThrowPNGError(l->fullname, wadfiles[wad]->filename);
-#endif
-			return size;
-		}
+		return W_ReadCompressedLump(wad, lump, dest, size, offset);
 #endif
 	default:
 		I_Error("wad %d, lump %d: unsupported compression type!", wad, lump);
@@ -2414,6 +2603,44 @@ void W_ReadLumpPwad(UINT16 wad, UINT16 lump, void *dest)
 	W_ReadLumpHeaderPwad(wad, lump, dest, 0, 0);
 }
 
+//
+// W_GetMappedLump
+//
+// Returns where an uncompressed lump is in its mapped file, or NULL if it
+// has to be read. This memory is never freed, and Z_Free ignores it.
+// The mapping is read-only, so only use this for lumps nobody writes to.
+//
+static void *W_GetMappedLump(UINT16 wad, UINT16 lump)
+{
+	lumpinfo_t *l = &wadfiles[wad]->lumpinfo[lump];
+	UINT8 *data;
+	size_t mapsize;
+
+	if (wadfiles[wad]->type == RET_FOLDER || l->compression != CM_NOCOMPRESSION || !l->size)
+		return NULL;
+
+	data = File_GetMapping(wadfiles[wad]->handle, &mapsize);
+	if (data == NULL || l->position > mapsize || l->size > mapsize - l->position)
+		return NULL;
+
+	data += l->position;
+
+	// Lump data gets read as INT16s and INT32s, which isn't safe
+	// everywhere unless it's aligned like the zone would do it.
+	if ((size_t)data & 3)
+		return NULL;
+
+#ifdef NO_PNG_LUMPS
+	if (Picture_IsLumpPNG(data, l->size))
+		Picture_ThrowPNGError(l->fullname, wadfiles[wad]->filename);
+#endif
+
+	return data;
+}
+
+// Tags whose users only read the lump, and can have it from the mapping
+#define MAPPEDLUMPTAG(tag) ((tag) == PU_CACHE || (tag) >= PU_PURGELEVEL)
+
 // ==========================================================================
 // W_CacheLumpNum
 // ==========================================================================
@@ -2425,10 +2652,20 @@ void *W_CacheLumpNumPwad(UINT16 wad, UINT16 lump, INT32 tag)
 		return NULL;
 
 	lumpcache = wadfiles[wad]->lumpcache;
-	if (!lumpcache[lump])
+
+	// Static and level lumps may get written to, and Z_Free has to
+	// really free them, so those get a copy of a lump in the mapping
+	if (!lumpcache[lump] || (!MAPPEDLUMPTAG(tag) && Z_IsExternalMemory(lumpcache[lump])))
 	{
-		void *ptr = Z_Malloc(W_LumpLengthPwad(wad, lump), tag, &lumpcache[lump]);
-		W_ReadLumpHeaderPwad(wad, lump, ptr, 0, 0);  // read the lump in full
+		void *ptr = MAPPEDLUMPTAG(tag) ? W_GetMappedLump(wad, lump) : NULL;
+
+		if (ptr)
+			lumpcache[lump] = ptr;
+		else
+		{
+			ptr = Z_Malloc(W_LumpLengthPwad(wad, lump), tag, &lumpcache[lump]);
+			W_ReadLumpHeaderPwad(wad, lump, ptr, 0, 0);  // read the lump in full
+		}
 	}
 	else
 		Z_ChangeTag(lumpcache[lump], tag);
@@ -2463,6 +2700,34 @@ void *W_CacheLumpNumForce(lumpnum_t lumpnum, INT32 tag)
 	return ptr;
 }
 
+//
+// W_CacheTextLump
+//
+// Reads a lump into a new NUL-terminated buffer, for callers that treat
+// the lump as a C string. Cached lumps may point into a read-only
+// mapping of the file with no terminator after them, so text must
+// never be taken from W_CacheLumpNum directly. Free it with Z_Free.
+//
+char *W_CacheTextLump(lumpnum_t lumpnum, INT32 tag)
+{
+	UINT16 wad, lump;
+	size_t len;
+	char *text;
+
+	wad = WADFILENUM(lumpnum);
+	lump = LUMPNUM(lumpnum);
+
+	if (!TestValidLump(wad,lump))
+		return NULL;
+
+	len = W_LumpLengthPwad(wad, lump);
+	text = Z_Malloc(len + 1, tag, NULL);
+	W_ReadLumpHeaderPwad(wad, lump, text, 0, 0);
+	text[len] = '\0';
+
+	return text;
+}
+
 //
 // W_IsLumpCached
 //
@@ -2562,10 +2827,14 @@ void *W_CacheSoftwarePatchNumPwad(UINT16 wad, UINT16 lump, INT32 tag)
 	if (!lumpcache[lump])
 	{
 		size_t len = W_LumpLengthPwad(wad, lump);
-		void *ptr, *dest, *lumpdata = Z_Malloc(len, PU_STATIC, NULL);
+		void *ptr, *dest, *lumpdata = W_GetMappedLump(wad, lump);
 
 		// read the lump in full
-		W_ReadLumpHeaderPwad(wad, lump, lumpdata, 0, 0);
+		if (lumpdata == NULL)
+		{
+			lumpdata = Z_Malloc(len, PU_STATIC, NULL);
+			W_ReadLumpHeaderPwad(wad, lump, lumpdata, 0, 0);
+		}
 		ptr = lumpdata;
 
 #ifndef NO_PNG_LUMPS
@@ -122,6 +122,14 @@ typedef enum restype
 	RET_UNKNOWN,
 } restype_t;
 
+// Hash chains over the lump names of one file
+typedef struct
+{
+	UINT16 *buckets; // first lump in each bucket, UINT16_MAX if none
+	UINT16 *next; // next lump in the same bucket, in lump order
+	UINT32 mask;
+} lumphash_t;
+
 typedef struct wadfile_s
 {
 	char *filename, *path;
@@ -129,6 +137,9 @@ typedef struct wadfile_s
 	lumpinfo_t *lumpinfo;
 	lumpcache_t *lumpcache;
 	lumpcache_t *patchcache;
+	lumphash_t namehash; // for W_CheckNumForNamePwad
+	lumphash_t longnamehash; // for W_CheckNumForLongNamePwad
+	UINT16 *fullnameorder; // lumps sorted by full name, for the PK3 lookups
 	UINT16 numlumps; // this wad's number of resources
 	UINT16 foldercount; // folder count
 	void *handle;
@@ -232,6 +243,8 @@ lumpnum_t W_GetNumForLongName(const char *name);
 lumpnum_t W_CheckNumForNameInBlock(const char *name, const char *blockstart, const char *blockend);
 UINT8 W_LumpExists(const char *name); // Lua uses this.
 
+void Command_Lumpbench_f(void);
+
 size_t W_LumpLengthPwad(UINT16 wad, UINT16 lump);
 size_t W_LumpLength(lumpnum_t lumpnum);
 
@@ -250,6 +263,7 @@ void W_ReadLump(lumpnum_t lump, void *dest);
 void *W_CacheLumpNumPwad(UINT16 wad, UINT16 lump, INT32 tag);
 void *W_CacheLumpNum(lumpnum_t lump, INT32 tag);
 void *W_CacheLumpNumForce(lumpnum_t lumpnum, INT32 tag);
+char *W_CacheTextLump(lumpnum_t lumpnum, INT32 tag); // NUL-terminated copy, Z_Free when done
 
 boolean W_IsLumpCached(lumpnum_t lump, void *ptr);
 boolean W_IsPatchCached(lumpnum_t lump, void *ptr);
@@ -24,6 +24,15 @@
 ///        caught with this direct-malloc version. We also suspected that SRB2's
 ///        allocator was fragmenting badly. Finally, this version is a bit
 ///        simpler (about half the lines of code).
+///
+///        Each tag has its own list of blocks, so freeing or counting a tag
+///        doesn't go through the others, and the purgable tags are kept in
+///        order of last use so the oldest cache gets dropped first.
+///
+///        Small level blocks (PU_LEVEL and PU_LEVSPEC) don't get a malloc
+///        each; they're bumped out of larger regions owned by an arena for
+///        the tag, reused by size when freed, and freed a region at a time
+///        when the level ends.
 
 #include "doomdef.h"
 #include "doomstat.h"
@@ -34,6 +43,7 @@
 #include "z_zone.h"
 #include "m_misc.h" // M_Memcpy
 #include "lua_script.h"
+#include "lua_libs.h" // gL
 
 #ifdef HWRENDER
 #include "hardware/hw_main.h" // For hardware memory info
@@ -46,6 +56,9 @@ static boolean Z_calloc = false;
 #endif
 
 #define ZONEID 0xa441d13d
+#define POOLID 0xb17e5ed0 // in front of objects from a zpool_t
+#define POOLFREEID 0xf4ee5ed0 // in front of the free ones
+#define REGIONFREEID 0xf4eeb10c // in front of freed blocks in a region
 
 #ifdef ZDEBUG
 //#define ZDEBUG2
@@ -67,7 +80,7 @@ typedef struct
 // For non-aligned allocations they will be the same.
 typedef struct memblock_s
 {
-	void *real;
+	void *real; // NULL if it's in a region
 	memhdr_t *hdr;
 
 	void **user;
@@ -76,16 +89,106 @@ typedef struct memblock_s
 	size_t size; // including the header and blocks
 	size_t realsize; // size of real data only
 
+	struct zregion_s *region; // the region it was bumped out of, if any
+	UINT32 lastuse; // for dropping the least recently used cache first
+
 #ifdef ZDEBUG
 	const char *ownerfile;
 	INT32 ownerline;
 #endif
 
+	// In the list for its tag; NULL for blocks in a region
+	// that still have the tag of the region's arena
 	struct memblock_s *next, *prev;
 } ATTRPACK memblock_t;
 
-// both the head and tail of the zone memory block list
-static memblock_t head;
+// Tags from NUMTAGLISTS up all share the last list
+#define NUMTAGLISTS 128
+
+// both the head and tail of each tag's block list,
+// oldest first, so purgable ones are in LRU order
+static memblock_t taglists[NUMTAGLISTS];
+static size_t tagusage[NUMTAGLISTS]; // in bytes, like Z_TagsUsage
+static UINT32 zoneclock = 0; // bumped every time a block is used
+
+static inline INT32 TagListNum(INT32 tag)
+{
+	return tag < 0 ? 0 : min(tag, NUMTAGLISTS - 1);
+}
+
+// Blocks up to REGIONMAXBLOCK bytes in a tag that has an arena come from
+// REGIONSIZE byte regions, each block right after the last, and freed
+// ones are handed out again to blocks of the same size class
+#define REGIONSIZE (256*1024)
+#define REGIONMAXBLOCK 2048
+#define REGIONALIGN 16
+#define NUMSIZECLASSES (REGIONMAXBLOCK / REGIONALIGN)
+
+#define RoundToRegion(x) (((x) + REGIONALIGN - 1) & ~(size_t)(REGIONALIGN - 1))
+#define REGIONHEADSIZE RoundToRegion(sizeof (zregion_t))
+#define BLOCKHEADSIZE RoundToRegion(sizeof (memblock_t) + sizeof (memhdr_t))
+
+typedef struct zregion_s
+{
+	struct zregion_s *next;
+	struct zarena_s *arena; // NULL once the arena was freed
+	UINT8 *end; // of the blocks bumped out of it so far
+	size_t pinned; // blocks in it that were changed to another tag
+} zregion_t;
+
+typedef struct zarena_s
+{
+	INT32 tag;
+	const char *name;
+	zregion_t *regions; // the newest first, which blocks are bumped out of
+	memblock_t *freeblocks[NUMSIZECLASSES]; // linked through next
+	size_t numregions;
+	boolean hasusers; // if any block was given a user
+} zarena_t;
+
+static zarena_t arenas[] =
+{
+	{PU_LEVEL,   "Level regions",           NULL, {NULL}, 0, false},
+	{PU_LEVSPEC, "Special thinker regions", NULL, {NULL}, 0, false},
+};
+
+// Regions of freed arenas kept for the blocks changed to other tags
+static zregion_t *orphanregions = NULL;
+
+// Memory the zone doesn't own, but that may still be passed to it,
+// such as lumps read straight from a mapped file. Sorted by address.
+typedef struct
+{
+	UINT8 *start, *end;
+} memrange_t;
+
+static memrange_t *externalmem = NULL;
+static size_t numexternalmem = 0;
+
+// In front of each object in a pool, laid out like memhdr_t
+// so Z_Free can tell them apart by the id
+typedef struct
+{
+	zpool_t *pool;
+	UINT32 id; // POOLID or POOLFREEID
+} ATTRPACK poolhdr_t;
+
+// At the start of each slab, followed by the objects
+typedef struct poolslab_s
+{
+	struct poolslab_s *next;
+} poolslab_t;
+
+// Every pool that has been allocated from, for Z_FreeTags and memfree
+static zpool_t *pools = NULL;
+
+static void Z_PoolFree(void *ptr, poolhdr_t *hdr);
+static void Z_FreePoolTags(INT32 lowtag, INT32 hightag);
+
+static void LinkBlock(memblock_t *block);
+static void UnlinkBlock(memblock_t *block);
+static void Z_RegionFree(memblock_t *block);
+static size_t Z_PurgeCache(size_t wanted);
 
 //
 // Function prototypes
@@ -107,10 +210,12 @@ static void Command_Memdump_f(void);
 void Z_Init(void)
 {
 	UINT32 total, memfree;
+	INT32 i;
 
-	memset(&head, 0x00, sizeof(head));
+	memset(taglists, 0x00, sizeof(taglists));
 
-	head.next = head.prev = &head;
+	for (i = 0; i < NUMTAGLISTS; i++)
+		taglists[i].next = taglists[i].prev = &taglists[i];
 
 	memfree = I_GetFreeMem(&total)>>20;
 	CONS_Printf("System memory: %uMB - Free: %uMB\n", total>>20, memfree);
@@ -124,6 +229,76 @@ void Z_Init(void)
 }
 
 
+// ---------------
+// External memory
+// ---------------
+
+/** Registers memory that isn't allocated by the zone.
+  * Z_Free, Z_ChangeTag and Z_SetUser don't do anything to it.
+  *
+  * \param ptr The start of the memory.
+  * \param size Its size, in bytes.
+  * \sa Z_RemoveExternalMemory
+  */
+void Z_AddExternalMemory(void *ptr, size_t size)
+{
+	size_t i;
+
+	externalmem = realloc(externalmem, (numexternalmem + 1) * sizeof (*externalmem));
+	if (externalmem == NULL)
+		I_Error("Z_AddExternalMemory: Out of memory");
+
+	for (i = numexternalmem; i > 0 && externalmem[i-1].start > (UINT8 *)ptr; i--)
+		externalmem[i] = externalmem[i-1];
+
+	externalmem[i].start = ptr;
+	externalmem[i].end = (UINT8 *)ptr + size;
+	numexternalmem++;
+}
+
+/** Forgets about memory registered with Z_AddExternalMemory.
+  *
+  * \param ptr The start of the memory.
+  */
+void Z_RemoveExternalMemory(void *ptr)
+{
+	size_t i;
+
+	for (i = 0; i < numexternalmem; i++)
+	{
+		if (externalmem[i].start == ptr)
+		{
+			memmove(&externalmem[i], &externalmem[i+1], (numexternalmem - i - 1) * sizeof (*externalmem));
+			numexternalmem--;
+			return;
+		}
+	}
+}
+
+/** Checks if a pointer is inside external memory.
+  *
+  * \param ptr The pointer to check.
+  * \return True if it was never allocated by the zone.
+  */
+boolean Z_IsExternalMemory(const void *ptr)
+{
+	size_t lo = 0, hi = numexternalmem;
+
+	while (lo < hi)
+	{
+		size_t mid = (lo + hi) / 2;
+
+		if ((const UINT8 *)ptr < externalmem[mid].start)
+			hi = mid;
+		else if ((const UINT8 *)ptr >= externalmem[mid].end)
+			lo = mid + 1;
+		else
+			return true;
+	}
+
+	return false;
+}
+
 // ----------------------
 // Zone memory allocation
 // ----------------------
@@ -154,6 +329,9 @@ static memblock_t *Ptr2Memblock(void *ptr, const char* func)
 	CONS_Printf("%s %s:%d\n", func, file, line);
 #endif
 
+	if (Z_IsExternalMemory(ptr))
+		I_Error("%s: memory is not from the zone", func);
+
 	hdr = (memhdr_t *)((UINT8 *)ptr - sizeof *hdr);
 
 #ifdef VALGRIND_MAKE_MEM_DEFINED
@@ -200,13 +378,24 @@ void Z_Free(void *ptr)
 {
 	memblock_t *block;
 
-	if (ptr == NULL)
+	if (ptr == NULL || Z_IsExternalMemory(ptr))
 		return;
 
 #ifdef ZDEBUG2
 	CONS_Debug(DBG_MEMORY, "Z_Free %s:%d\n", file, line);
 #endif
 
+	// Objects from a pool go back to it
+	{
+		poolhdr_t *poolhdr = (poolhdr_t *)((UINT8 *)ptr - sizeof *poolhdr);
+
+		if (poolhdr->id == POOLID || poolhdr->id == POOLFREEID)
+		{
+			Z_PoolFree(ptr, poolhdr);
+			return;
+		}
+	}
+
 #ifdef ZDEBUG
 	block = Ptr2Memblock2(ptr, "Z_Free", file, line);
 #else
@@ -229,13 +418,22 @@ void Z_Free(void *ptr)
 	if (block->user != NULL)
 		*block->user = NULL;
 
-	// Free the memory and get rid of the block.
-	free(block->real);
+	tagusage[TagListNum(block->tag)] -= block->size + sizeof *block;
+
 #ifdef VALGRIND_DESTROY_MEMPOOL
 	VALGRIND_DESTROY_MEMPOOL(block);
 #endif
-	block->prev->next = block->next;
-	block->next->prev = block->prev;
+
+	// Blocks in a region go back to it
+	if (block->region)
+	{
+		Z_RegionFree(block);
+		return;
+	}
+
+	// Free the memory and get rid of the block.
+	free(block->real);
+	UnlinkBlock(block);
 	free(block);
 }
 
@@ -253,19 +451,224 @@ static void *xm(size_t size)
 		I_Error("You are allocating memory too large!");
 	p = malloc(padedsize);
 
-	if (p == NULL)
+	while (p == NULL)
 	{
-		// Oh crumbs: we're out of heap. Try purging the cache and reallocating.
-		Z_FreeTags(PU_PURGELEVEL, INT32_MAX);
+		// Oh crumbs: we're out of heap. Try purging the oldest
+		// quarter of the cache and reallocating, until it's all gone.
+		size_t purgable = Z_TagsUsage(PU_PURGELEVEL, INT32_MAX);
+
+		if (!purgable || !Z_PurgeCache(max(size, purgable/4)))
+			I_Error("Out of memory allocating %s bytes", sizeu1(size));
+
 		p = malloc(padedsize);
+	}
+
+	return p;
+}
 
-		if (p == NULL)
+// -------------------
+// Tag lists & regions
+// -------------------
+
+// Adds a block to the end of its tag's list, as the most recently used
+static void LinkBlock(memblock_t *block)
+{
+	memblock_t *head = &taglists[TagListNum(block->tag)];
+
+	block->next = head;
+	block->prev = head->prev;
+	head->prev->next = block;
+	head->prev = block;
+	block->lastuse = ++zoneclock;
+}
+
+static void UnlinkBlock(memblock_t *block)
+{
+	block->prev->next = block->next;
+	block->next->prev = block->prev;
+	block->next = block->prev = NULL;
+}
+
+static zarena_t *ArenaForTag(INT32 tag)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof arenas / sizeof *arenas; i++)
+		if (arenas[i].tag == tag)
+			return &arenas[i];
+
+	return NULL;
+}
+
+#define FirstInRegion(region) ((memblock_t *)((UINT8 *)(region) + REGIONHEADSIZE))
+#define NextInRegion(block) ((memblock_t *)((UINT8 *)(block) + sizeof (memblock_t) + (block)->size))
+
+/** Gets a block for the arena, either one freed before or a new one
+  * bumped out of its newest region. The block isn't filled in past its
+  * header and size.
+  *
+  * \param arena The arena for the block's tag.
+  * \param size Size of the data, at most REGIONMAXBLOCK.
+  * \return The block.
+  */
+static memblock_t *Z_RegionAlloc(zarena_t *arena, size_t size)
+{
+	const size_t sizeclass = (size ? RoundToRegion(size) : REGIONALIGN) / REGIONALIGN - 1;
+	const size_t stride = BLOCKHEADSIZE + (sizeclass + 1) * REGIONALIGN;
+	zregion_t *region = arena->regions;
+	memblock_t *block = arena->freeblocks[sizeclass];
+
+	if (block)
+	{
+		arena->freeblocks[sizeclass] = block->next;
+		block->next = NULL;
+		return block;
+	}
+
+	if (!region || region->end + stride > (UINT8 *)region + REGIONSIZE)
+	{
+		region = xm(REGIONSIZE);
+		region->next = arena->regions;
+		region->arena = arena;
+		region->end = (UINT8 *)FirstInRegion(region);
+		region->pinned = 0;
+		arena->regions = region;
+		arena->numregions++;
+	}
+
+	block = (memblock_t *)region->end;
+	region->end += stride;
+
+	block->real = NULL;
+	block->hdr = (memhdr_t *)((UINT8 *)block + BLOCKHEADSIZE - sizeof (memhdr_t));
+	block->size = stride - sizeof (memblock_t);
+	block->region = region;
+	block->next = block->prev = NULL;
+	return block;
+}
+
+// Called by Z_Free for blocks in a region, after the user is cleared
+static void Z_RegionFree(memblock_t *block)
+{
+	zregion_t *region = block->region;
+
+	block->hdr->id = REGIONFREEID;
+
+	if (block->next)
+	{
+		UnlinkBlock(block);
+		region->pinned--;
+	}
+
+	if (region->arena)
+	{
+		const size_t sizeclass = (block->size + sizeof (memblock_t) - BLOCKHEADSIZE) / REGIONALIGN - 1;
+
+		block->next = region->arena->freeblocks[sizeclass];
+		region->arena->freeblocks[sizeclass] = block;
+	}
+	else if (!region->pinned)
+	{
+		// Its arena is gone, and this was the last block keeping it
+		zregion_t **rover;
+
+		for (rover = &orphanregions; *rover != region; rover = &(*rover)->next)
+			;
+		*rover = region->next;
+		free(region);
+	}
+}
+
+/** Frees every block left in an arena's own tag, and all its regions
+  * except those with blocks that were changed to other tags.
+  * Blocks only need visiting if Lua or a user may point to them.
+  *
+  * \param arena The arena to free.
+  */
+static void Z_FreeArena(zarena_t *arena)
+{
+	zregion_t *region, *next;
+	boolean visit = (gL != NULL || arena->hasusers);
+
+#ifdef HAVE_VALGRIND
+	visit = true;
+#endif
+
+	for (region = arena->regions; region; region = next)
+	{
+		next = region->next;
+
+		if (visit)
 		{
-			I_Error("Out of memory allocating %s bytes", sizeu1(size));
+			memblock_t *block;
+
+			for (block = FirstInRegion(region); (UINT8 *)block < region->end; block = NextInRegion(block))
+			{
+				void *given = (UINT8 *)block->hdr + sizeof *block->hdr;
+
+				if (block->hdr->id != ZONEID || block->next)
+					continue; // Freed, or changed to another tag
+
+				LUA_InvalidateUserdata(given);
+				if (block->user != NULL)
+					*block->user = NULL;
+#ifdef VALGRIND_DESTROY_MEMPOOL
+				VALGRIND_DESTROY_MEMPOOL(block);
+#endif
+				block->hdr->id = REGIONFREEID;
+			}
 		}
+
+		if (region->pinned)
+		{
+			region->arena = NULL;
+			region->next = orphanregions;
+			orphanregions = region;
+		}
+		else
+			free(region);
 	}
 
-	return p;
+	arena->regions = NULL;
+	arena->numregions = 0;
+	arena->hasusers = false;
+	memset(arena->freeblocks, 0, sizeof arena->freeblocks);
+
+	// Anything else with its tag was in the list, and was freed first
+	tagusage[TagListNum(arena->tag)] = 0;
+}
+
+/** Frees the least recently used purgable blocks.
+  *
+  * \param wanted How many bytes to try to free.
+  * \return How many bytes were freed.
+  */
+static size_t Z_PurgeCache(size_t wanted)
+{
+	size_t freed = 0;
+
+	while (freed < wanted)
+	{
+		memblock_t *oldest = NULL;
+		INT32 i;
+
+		for (i = TagListNum(PU_PURGELEVEL); i < NUMTAGLISTS; i++)
+		{
+			memblock_t *block = taglists[i].next;
+
+			if (block != &taglists[i] && block->tag >= PU_PURGELEVEL
+				&& (!oldest || (INT32)(block->lastuse - oldest->lastuse) < 0))
+				oldest = block;
+		}
+
+		if (!oldest)
+			break;
+
+		freed += oldest->size + sizeof *oldest;
+		Z_Free((UINT8 *)oldest->hdr + sizeof *oldest->hdr);
+	}
+
+	return freed;
 }
 
 /** The Z_MallocAlign function.
@@ -294,6 +697,7 @@ void *Z_MallocAlign(size_t size, INT32 tag, void *user, INT32 alignbits)
 	memhdr_t *hdr;
 	void *given;
 	size_t blocksize = extrabytes + sizeof *hdr + size;
+	zarena_t *arena = ArenaForTag(tag);
 
 #ifdef ZDEBUG2
 	CONS_Debug(DBG_MEMORY, "Z_Malloc %s:%d\n", file, line);
@@ -302,40 +706,55 @@ void *Z_MallocAlign(size_t size, INT32 tag, void *user, INT32 alignbits)
 	if (blocksize < size)/* overflow check */
 		I_Error("You are allocating memory too large!");
 
-	block = xm(sizeof *block);
+	if (arena && size <= REGIONMAXBLOCK && (1<<alignbits) <= REGIONALIGN)
+	{
+		// Small level blocks come out of the arena's regions
+		block = Z_RegionAlloc(arena, size);
+		hdr = block->hdr;
+		given = (UINT8 *)hdr + sizeof *hdr;
+		if (user != NULL)
+			arena->hasusers = true;
+	}
+	else
+	{
+		block = xm(sizeof *block);
 #ifdef HAVE_VALGRIND
-	padsize += (1<<sizeof(size_t))*2;
+		padsize += (1<<sizeof(size_t))*2;
 #endif
-	ptr = xm(blocksize + padsize*2);
+		ptr = xm(blocksize + padsize*2);
+
+		// This horrible calculation makes sure that "given" is aligned
+		// properly.
+		given = (void *)((size_t)((UINT8 *)ptr + extrabytes + sizeof *hdr + padsize/2)
+			& ~extrabytes);
 
-	// This horrible calculation makes sure that "given" is aligned
-	// properly.
-	given = (void *)((size_t)((UINT8 *)ptr + extrabytes + sizeof *hdr + padsize/2)
-		& ~extrabytes);
+		// The mem header lives 'sizeof (memhdr_t)' bytes before given.
+		hdr = (memhdr_t *)((UINT8 *)given - sizeof *hdr);
 
-	// The mem header lives 'sizeof (memhdr_t)' bytes before given.
-	hdr = (memhdr_t *)((UINT8 *)given - sizeof *hdr);
+		block->real = ptr;
+		block->hdr = hdr;
+		block->size = blocksize;
+		block->region = NULL;
+	}
 
 #ifdef HAVE_VALGRIND
 	Z_calloc = false;
 #endif
 
-	block->next = head.next;
-	block->prev = &head;
-	head.next = block;
-	block->next->prev = block;
-
-	block->real = ptr;
-	block->hdr = hdr;
 	block->tag = tag;
 	block->user = NULL;
 #ifdef ZDEBUG
 	block->ownerline = line;
 	block->ownerfile = file;
 #endif
-	block->size = blocksize;
 	block->realsize = size;
 
+	if (block->region)
+		block->lastuse = ++zoneclock;
+	else
+		LinkBlock(block);
+	tagusage[TagListNum(tag)] += block->size + sizeof *block;
+
 #ifdef VALGRIND_CREATE_MEMPOOL
 	VALGRIND_CREATE_MEMPOOL(block, padsize, Z_calloc);
 #endif
@@ -485,15 +904,34 @@ void *Z_ReallocAlign(void *ptr, size_t size, INT32 tag, void *user, INT32 alignb
 void Z_FreeTags(INT32 lowtag, INT32 hightag)
 {
 	memblock_t *block, *next;
+	INT32 i;
+	size_t j;
+
+	if (lowtag > hightag)
+		return;
 
+#if defined (ZDEBUG) || defined (PARANOIA)
+	// Not always, since it goes through every block
 	Z_CheckHeap(420);
-	for (block = head.next; block != &head; block = next)
+#endif
+	Z_FreePoolTags(lowtag, hightag);
+	for (i = TagListNum(lowtag); i <= TagListNum(hightag); i++)
 	{
-		next = block->next; // get link before freeing
+		memblock_t *head = &taglists[i];
 
-		if (block->tag >= lowtag && block->tag <= hightag)
-			Z_Free((UINT8 *)block->hdr + sizeof *block->hdr);
+		for (block = head->next; block != head; block = next)
+		{
+			next = block->next; // get link before freeing
+
+			if (block->tag >= lowtag && block->tag <= hightag)
+				Z_Free((UINT8 *)block->hdr + sizeof *block->hdr);
+		}
 	}
+
+	// What's left in the regions goes all at once
+	for (j = 0; j < sizeof arenas / sizeof *arenas; j++)
+		if (arenas[j].tag >= lowtag && arenas[j].tag <= hightag)
+			Z_FreeArena(&arenas[j]);
 }
 
 /** Iterates through all memory for a given set of tags.
@@ -505,21 +943,187 @@ void Z_FreeTags(INT32 lowtag, INT32 hightag)
 void Z_IterateTags(INT32 lowtag, INT32 hightag, boolean (*iterfunc)(void *))
 {
 	memblock_t *block, *next;
+	INT32 i;
+	size_t j;
 
 	if (!iterfunc)
 		I_Error("Z_IterateTags: no iterator function was given");
 
-	for (block = head.next; block != &head; block = next)
+	if (lowtag > hightag)
+		return;
+
+	for (i = TagListNum(lowtag); i <= TagListNum(hightag); i++)
+	{
+		memblock_t *head = &taglists[i];
+
+		for (block = head->next; block != head; block = next)
+		{
+			next = block->next; // get link before possibly freeing
+
+			if (block->tag >= lowtag && block->tag <= hightag)
+			{
+				void *mem = (UINT8 *)block->hdr + sizeof *block->hdr;
+				boolean free = iterfunc(mem);
+				if (free)
+					Z_Free(mem);
+			}
+		}
+	}
+
+	for (j = 0; j < sizeof arenas / sizeof *arenas; j++)
+	{
+		zregion_t *region;
+
+		if (arenas[j].tag < lowtag || arenas[j].tag > hightag)
+			continue;
+
+		for (region = arenas[j].regions; region; region = region->next)
+			for (block = FirstInRegion(region); (UINT8 *)block < region->end; block = NextInRegion(block))
+			{
+				void *mem = (UINT8 *)block->hdr + sizeof *block->hdr;
+
+				if (block->hdr->id != ZONEID || block->next)
+					continue; // Freed, or in a list already gone through
+
+				if (iterfunc(mem))
+					Z_Free(mem);
+			}
+	}
+}
+
+// ------------
+// Object pools
+// ------------
+
+#define POOLSLABBYTES (64*1024)
+#define POOLMINSLOTS 16
+
+static inline poolhdr_t *PoolHeader(void *ptr)
+{
+	return (poolhdr_t *)((UINT8 *)ptr - sizeof (poolhdr_t));
+}
+
+// The first object in a slab, after the slab header and the first
+// object's header, lined up to the pool's alignment
+static inline UINT8 *FirstInSlab(zpool_t *pool, poolslab_t *slab)
+{
+	const size_t align = (size_t)1 << pool->alignbits;
+	const size_t start = (size_t)slab + sizeof (poolslab_t) + sizeof (poolhdr_t);
+
+	return (UINT8 *)((start + align - 1) & ~(align - 1));
+}
+
+static void Z_AddPoolSlab(zpool_t *pool)
+{
+	const size_t slotsperslab = pool->slabslots;
+	poolslab_t *slab = Z_MallocAlign(sizeof (poolslab_t) + sizeof (poolhdr_t) + ((size_t)1 << pool->alignbits)
+		+ slotsperslab * pool->stride, pool->tag, NULL, pool->alignbits);
+	UINT8 *obj = FirstInSlab(pool, slab);
+	size_t i;
+
+	slab->next = pool->slabs;
+	pool->slabs = slab;
+
+	// Free in address order, so the first ones given out are together
+	obj += (slotsperslab - 1) * pool->stride;
+	for (i = 0; i < slotsperslab; i++, obj -= pool->stride)
+	{
+		poolhdr_t *hdr = PoolHeader(obj);
+		hdr->pool = pool;
+		hdr->id = POOLFREEID;
+		*(void **)obj = pool->freelist;
+		pool->freelist = obj;
+	}
+
+	pool->numslots += slotsperslab;
+}
+
+/** Allocates an object from a pool, zeroed.
+  * Allocates another slab for the pool when it's out of objects.
+  *
+  * \param pool The pool, set up with ZPOOL_INIT.
+  * \return A pointer to the object, to be freed with Z_Free.
+  * \sa Z_Free, Z_FreeTags
+  */
+void *Z_PoolAlloc(zpool_t *pool)
+{
+	void *obj;
+
+	if (!pool->ready)
+	{
+		const size_t align = (size_t)1 << max(pool->alignbits, 3);
+
+		// Each object has its header right in front of it
+		pool->alignbits = max(pool->alignbits, 3);
+		pool->stride = (pool->size + sizeof (poolhdr_t) + align - 1) & ~(align - 1);
+		pool->slabslots = max(POOLSLABBYTES / pool->stride, POOLMINSLOTS);
+
+		pool->next = pools;
+		pools = pool;
+		pool->ready = true;
+	}
+
+	if (!pool->freelist)
+		Z_AddPoolSlab(pool);
+
+	obj = pool->freelist;
+	pool->freelist = *(void **)obj;
+	PoolHeader(obj)->id = POOLID;
+	pool->numused++;
+
+	return memset(obj, 0, pool->size);
+}
+
+// Called by Z_Free for objects that came from a pool
+static void Z_PoolFree(void *ptr, poolhdr_t *hdr)
+{
+	zpool_t *pool = hdr->pool;
+
+	if (hdr->id == POOLFREEID)
+		I_Error("Z_Free: %s object freed twice", pool->name);
+
+	if (pool->tag != PU_LUA)
+		LUA_InvalidateUserdata(ptr);
+
+	hdr->id = POOLFREEID;
+	*(void **)ptr = pool->freelist;
+	pool->freelist = ptr;
+	pool->numused--;
+}
+
+// Frees the slabs of every pool with a tag in the range, all at once
+static void Z_FreePoolTags(INT32 lowtag, INT32 hightag)
+{
+	zpool_t *pool;
+
+	for (pool = pools; pool; pool = pool->next)
 	{
-		next = block->next; // get link before possibly freeing
+		poolslab_t *slab, *next;
 
-		if (block->tag >= lowtag && block->tag <= hightag)
+		if (pool->tag < lowtag || pool->tag > hightag || !pool->slabs)
+			continue;
+
+		for (slab = pool->slabs; slab; slab = next)
 		{
-			void *mem = (UINT8 *)block->hdr + sizeof *block->hdr;
-			boolean free = iterfunc(mem);
-			if (free)
-				Z_Free(mem);
+			next = slab->next;
+
+			// Lua may still have a hold of some of them
+			if (gL && pool->tag != PU_LUA && pool->numused)
+			{
+				UINT8 *obj = FirstInSlab(pool, slab);
+				size_t i;
+
+				for (i = 0; i < pool->slabslots; i++, obj += pool->stride)
+					if (PoolHeader(obj)->id == POOLID)
+						LUA_InvalidateUserdata(obj);
+			}
+
+			Z_Free(slab);
 		}
+
+		pool->slabs = NULL;
+		pool->freelist = NULL;
+		pool->numslots = pool->numused = 0;
 	}
 }
 
@@ -552,108 +1156,128 @@ void Z_CheckMemCleanup(void)
 }
 
 
-/** Checks the heap, as well as the memhdr_ts, for any corruption or
-  * other problems.
-  * \param i Identifies from where in the code Z_CheckHeap was called.
-  * \author Graue <graue@oceanbase.org>
-  */
-void Z_CheckHeap(INT32 i)
+// Checks one block for Z_CheckHeap
+static void Z_CheckBlock(memblock_t *block, INT32 i, UINT32 blocknumon)
 {
-	memblock_t *block;
-	memhdr_t *hdr;
-	UINT32 blocknumon = 0;
-	void *given;
+	memhdr_t *hdr = block->hdr;
+	void *given = (UINT8 *)hdr + sizeof *hdr;
 
-	for (block = head.next; block != &head; block = block->next)
-	{
-		blocknumon++;
-		hdr = block->hdr;
-		given = (UINT8 *)hdr + sizeof *hdr;
 #ifdef ZDEBUG2
-		CONS_Debug(DBG_MEMORY, "block %u owned by %s:%d\n",
-			blocknumon, block->ownerfile, block->ownerline);
+	CONS_Debug(DBG_MEMORY, "block %u owned by %s:%d\n",
+		blocknumon, block->ownerfile, block->ownerline);
 #endif
 #ifdef VALGRIND_MEMPOOL_EXISTS
-		if (!VALGRIND_MEMPOOL_EXISTS(block))
-		{
-			I_Error("Z_CheckHeap %d: block %u"
+	if (!VALGRIND_MEMPOOL_EXISTS(block))
+	{
+		I_Error("Z_CheckHeap %d: block %u"
 #ifdef ZDEBUG
-				"(owned by %s:%d)"
+			"(owned by %s:%d)"
 #endif
-				" should not exist", i, blocknumon
+			" should not exist", i, blocknumon
 #ifdef ZDEBUG
-				, block->ownerfile, block->ownerline
+			, block->ownerfile, block->ownerline
 #endif
-			        );
-		}
+		        );
+	}
 #endif
-		if (block->user != NULL && *(block->user) != given)
-		{
-			I_Error("Z_CheckHeap %d: block %u"
+	if (block->user != NULL && *(block->user) != given)
+	{
+		I_Error("Z_CheckHeap %d: block %u"
 #ifdef ZDEBUG
-				"(owned by %s:%d)"
+			"(owned by %s:%d)"
 #endif
-				" doesn't have a proper user", i, blocknumon
+			" doesn't have a proper user", i, blocknumon
 #ifdef ZDEBUG
-				, block->ownerfile, block->ownerline
+			, block->ownerfile, block->ownerline
 #endif
-			       );
-		}
-		if (block->next->prev != block)
-		{
-			I_Error("Z_CheckHeap %d: block %u"
+		       );
+	}
+	if (block->next && block->next->prev != block)
+	{
+		I_Error("Z_CheckHeap %d: block %u"
 #ifdef ZDEBUG
-				"(owned by %s:%d)"
+			"(owned by %s:%d)"
 #endif
-				" lacks proper backlink", i, blocknumon
+			" lacks proper backlink", i, blocknumon
 #ifdef ZDEBUG
-				, block->ownerfile, block->ownerline
+			, block->ownerfile, block->ownerline
 #endif
-			       );
-		}
-		if (block->prev->next != block)
-		{
-			I_Error("Z_CheckHeap %d: block %u"
+		       );
+	}
+	if (block->prev && block->prev->next != block)
+	{
+		I_Error("Z_CheckHeap %d: block %u"
 #ifdef ZDEBUG
-				"(owned by %s:%d)"
+			"(owned by %s:%d)"
 #endif
-				" lacks proper forward link", i, blocknumon
+			" lacks proper forward link", i, blocknumon
 #ifdef ZDEBUG
-				, block->ownerfile, block->ownerline
+			, block->ownerfile, block->ownerline
 #endif
-			       );
-		}
+		       );
+	}
 #ifdef VALGRIND_MAKE_MEM_DEFINED
-		VALGRIND_MAKE_MEM_DEFINED(hdr, sizeof *hdr);
+	VALGRIND_MAKE_MEM_DEFINED(hdr, sizeof *hdr);
 #endif
-		if (hdr->block != block)
-		{
-			I_Error("Z_CheckHeap %d: block %u"
+	if (hdr->block != block)
+	{
+		I_Error("Z_CheckHeap %d: block %u"
 #ifdef ZDEBUG
-				"(owned by %s:%d)"
+			"(owned by %s:%d)"
 #endif
-				" doesn't have linkback from allocated memory",
-				i, blocknumon
+			" doesn't have linkback from allocated memory",
+			i, blocknumon
 #ifdef ZDEBUG
-				, block->ownerfile, block->ownerline
+			, block->ownerfile, block->ownerline
 #endif
-					);
-		}
-		if (hdr->id != ZONEID)
-		{
-			I_Error("Z_CheckHeap %d: block %u"
+				);
+	}
+	if (hdr->id != ZONEID)
+	{
+		I_Error("Z_CheckHeap %d: block %u"
 #ifdef ZDEBUG
-				"(owned by %s:%d)"
+			"(owned by %s:%d)"
 #endif
-				" have the wrong ID", i, blocknumon
+			" have the wrong ID", i, blocknumon
 #ifdef ZDEBUG
-				, block->ownerfile, block->ownerline
+			, block->ownerfile, block->ownerline
 #endif
-					);
-		}
+				);
+	}
 #ifdef VALGRIND_MAKE_MEM_NOACCESS
 	VALGRIND_MAKE_MEM_NOACCESS(hdr, sizeof *hdr);
 #endif
+}
+
+/** Checks the heap, as well as the memhdr_ts, for any corruption or
+  * other problems.
+  * \param i Identifies from where in the code Z_CheckHeap was called.
+  * \author Graue <graue@oceanbase.org>
+  */
+void Z_CheckHeap(INT32 i)
+{
+	memblock_t *block;
+	UINT32 blocknumon = 0;
+	INT32 j;
+	size_t k;
+
+	for (j = 0; j < NUMTAGLISTS; j++)
+		for (block = taglists[j].next; block != &taglists[j]; block = block->next)
+			Z_CheckBlock(block, i, ++blocknumon);
+
+	for (k = 0; k < sizeof arenas / sizeof *arenas; k++)
+	{
+		zregion_t *region;
+
+		for (region = arenas[k].regions; region; region = region->next)
+			for (block = FirstInRegion(region); (UINT8 *)block < region->end; block = NextInRegion(block))
+			{
+#ifdef VALGRIND_MAKE_MEM_DEFINED
+				VALGRIND_MAKE_MEM_DEFINED(block->hdr, sizeof *block->hdr);
+#endif
+				if (block->hdr->id != REGIONFREEID && !block->next)
+					Z_CheckBlock(block, i, ++blocknumon);
+			}
 	}
 }
 
@@ -677,7 +1301,7 @@ void Z_ChangeTag(void *ptr, INT32 tag)
 	memblock_t *block;
 	memhdr_t *hdr;
 
-	if (ptr == NULL)
+	if (ptr == NULL || Z_IsExternalMemory(ptr))
 		return;
 
 	hdr = (memhdr_t *)((UINT8 *)ptr - sizeof *hdr);
@@ -710,7 +1334,27 @@ void Z_ChangeTag(void *ptr, INT32 tag)
 		I_Error("Internal memory management error: "
 			"tried to make block purgable but it has no owner");
 
+	tagusage[TagListNum(block->tag)] -= block->size + sizeof *block;
+	tagusage[TagListNum(tag)] += block->size + sizeof *block;
+
+	// Move it to the end of its new tag's list, as the most recently
+	// used. Blocks in a region only need a list while their tag isn't
+	// the arena's, and keep the region from being freed until then.
+	if (block->next)
+		UnlinkBlock(block);
+	else if (block->region)
+		block->region->pinned++;
+
 	block->tag = tag;
+
+	if (block->region && block->region->arena && block->region->arena->tag == tag)
+	{
+		block->region->pinned--;
+		if (block->user != NULL)
+			block->region->arena->hasusers = true;
+	}
+	else
+		LinkBlock(block);
 }
 
 /** Changes a memory block's user.
@@ -732,6 +1376,12 @@ void Z_SetUser(void *ptr, void **newuser)
 	if (ptr == NULL)
 		return;
 
+	if (Z_IsExternalMemory(ptr))
+	{
+		*newuser = ptr;
+		return;
+	}
+
 	hdr = (memhdr_t *)((UINT8 *)ptr - sizeof *hdr);
 
 #ifdef VALGRIND_MAKE_MEM_DEFINED
@@ -752,6 +1402,9 @@ void Z_SetUser(void *ptr, void **newuser)
 		I_Error("Internal memory management error: "
 			"tried to make block purgable but it has no owner");
 
+	if (block->region && block->region->arena)
+		block->region->arena->hasusers = true;
+
 	block->user = (void*)newuser;
 	*newuser = ptr;
 }
@@ -771,13 +1424,22 @@ size_t Z_TagsUsage(INT32 lowtag, INT32 hightag)
 {
 	size_t cnt = 0;
 	memblock_t *rover;
+	INT32 i;
 
-	for (rover = head.next; rover != &head; rover = rover->next)
-	{
-		if (rover->tag < lowtag || rover->tag > hightag)
-			continue;
-		cnt += rover->size + sizeof *rover;
-	}
+	if (lowtag > hightag)
+		return 0;
+
+	for (i = TagListNum(lowtag); i <= TagListNum(hightag) && i < NUMTAGLISTS - 1; i++)
+		cnt += tagusage[i];
+
+	// The last list has more than one tag, so it needs looking through
+	if (hightag >= NUMTAGLISTS - 1)
+		for (rover = taglists[NUMTAGLISTS - 1].next; rover != &taglists[NUMTAGLISTS - 1]; rover = rover->next)
+		{
+			if (rover->tag < lowtag || rover->tag > hightag)
+				continue;
+			cnt += rover->size + sizeof *rover;
+		}
 
 	return cnt;
 }
@@ -810,6 +1472,19 @@ static void Command_Memfree_f(void)
 	CONS_Printf(M_GetText("All purgable           : %7s KB\n"),
 		sizeu1(Z_TagsUsage(PU_PURGELEVEL, INT32_MAX)>>10));
 
+	{
+		zpool_t *pool;
+		size_t i;
+
+		for (pool = pools; pool; pool = pool->next)
+			CONS_Printf(M_GetText("%-23s: %7s KB, %s of %s in use\n"), pool->name,
+				sizeu1((pool->numslots * pool->stride)>>10), sizeu2(pool->numused), sizeu3(pool->numslots));
+
+		for (i = 0; i < sizeof arenas / sizeof *arenas; i++)
+			CONS_Printf(M_GetText("%-23s: %7s KB in %s regions\n"), arenas[i].name,
+				sizeu1((arenas[i].numregions * REGIONSIZE)>>10), sizeu2(arenas[i].numregions));
+	}
+
 #ifdef HWRENDER
 	if (rendermode == render_opengl)
 	{
@@ -829,6 +1504,12 @@ static void Command_Memfree_f(void)
 }
 
 #ifdef ZDEBUG
+static void MemdumpBlock(memblock_t *block)
+{
+	char *filename = strrchr(block->ownerfile, PATHSEP[0]);
+	CONS_Printf("[%3d] %s (%s) bytes @ %s:%d\n", block->tag, sizeu1(block->size), sizeu2(block->realsize), filename ? filename + 1 : block->ownerfile, block->ownerline);
+}
+
 /** The function called by the "memdump" console command.
   * Prints zone memory debugging information (i.e. tag, size, location in code allocated).
   * Can be all memory allocated in game, or between a set of tags (if -min/-max args used).
@@ -839,6 +1520,7 @@ static void Command_Memdump_f(void)
 	memblock_t *block;
 	INT32 mintag = 0, maxtag = INT32_MAX;
 	INT32 i;
+	size_t j;
 
 	if ((i = COM_CheckParm("-min")))
 		mintag = atoi(COM_Argv(i + 1));
@@ -846,12 +1528,23 @@ static void Command_Memdump_f(void)
 	if ((i = COM_CheckParm("-max")))
 		maxtag = atoi(COM_Argv(i + 1));
 
-	for (block = head.next; block != &head; block = block->next)
-		if (block->tag >= mintag && block->tag <= maxtag)
-		{
-			char *filename = strrchr(block->ownerfile, PATHSEP[0]);
-			CONS_Printf("[%3d] %s (%s) bytes @ %s:%d\n", block->tag, sizeu1(block->size), sizeu2(block->realsize), filename ? filename + 1 : block->ownerfile, block->ownerline);
-		}
+	for (i = 0; i < NUMTAGLISTS; i++)
+		for (block = taglists[i].next; block != &taglists[i]; block = block->next)
+			if (block->tag >= mintag && block->tag <= maxtag)
+				MemdumpBlock(block);
+
+	for (j = 0; j < sizeof arenas / sizeof *arenas; j++)
+	{
+		zregion_t *region;
+
+		if (arenas[j].tag < mintag || arenas[j].tag > maxtag)
+			continue;
+
+		for (region = arenas[j].regions; region; region = region->next)
+			for (block = FirstInRegion(region); (UINT8 *)block < region->end; block = NextInRegion(block))
+				if (block->hdr->id == ZONEID && !block->next)
+					MemdumpBlock(block);
+	}
 }
 #endif
 
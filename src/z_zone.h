@@ -106,6 +106,35 @@ void *Z_ReallocAlign(void *ptr, size_t size, INT32 tag, void *user, INT32 alignb
 #define Z_Calloc(s,t,u)    Z_CallocAlign(s, t, u, 0)
 #define Z_Realloc(p,s,t,u) Z_ReallocAlign(p, s, t, u, 0)
 
+// Pools of fixed-size objects, carved out of slabs allocated with the
+// pool's tag rather than one block each. Objects come zeroed, are freed
+// with Z_Free, and Z_FreeTags on the tag frees all of them at once.
+typedef struct zpool_s
+{
+	const char *name;
+	size_t size; // of each object
+	INT32 tag;
+	INT32 alignbits; // 6 to start objects on cache lines
+
+	// Filled in by the first Z_PoolAlloc
+	size_t stride; // from one object to the next
+	size_t slabslots; // objects in each slab
+	void *slabs;
+	void *freelist;
+	size_t numslots, numused;
+	struct zpool_s *next;
+	boolean ready;
+} zpool_t;
+
+#define ZPOOL_INIT(name, size, tag, alignbits) {name, size, tag, alignbits, 0, 0, NULL, NULL, 0, 0, NULL, false}
+
+void *Z_PoolAlloc(zpool_t *pool);
+
+// Memory from elsewhere that the zone functions should leave alone
+void Z_AddExternalMemory(void *ptr, size_t size);
+void Z_RemoveExternalMemory(void *ptr);
+boolean Z_IsExternalMemory(const void *ptr);
+
 // Free all memory by tag
 // these don't give line numbers for ZDEBUG currently though
 // (perhaps this should be changed in future?)